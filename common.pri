@@ -43,6 +43,13 @@ isEmpty(INCLUDEDIR) {
 
 MODULENAME = org/SfietKonstantin/$${NAME}
 
+# staticprovider builds the library and the provider plugins
+# as static libraries, that are all linked in the provider
+CONFIG(staticprovider): {
+    CONFIG += semistatic
+    DEFINES += PT2_STATIC_PROVIDER
+}
+
 # Application + data + qml folders
 CONFIG(optify):{
     APPLICATION_FOLDER  = $${OPTDIR}/bin
@@ -10,6 +10,8 @@ BuildRequires:  pkgconfig(Qt5Core)
 BuildRequires:  pkgconfig(Qt5Gui)
 BuildRequires:  pkgconfig(Qt5Qml)
 BuildRequires:  pkgconfig(Qt5DBus)
+BuildRequires:  pkgconfig(Qt5Sql)
+BuildRequires:  pkgconfig(Qt5Concurrent)
 BuildRequires:  pkgconfig(Qt5Test)
 BuildRequires:  qt5-qttools
 BuildRequires:  qt5-qttools-linguist
@@ -75,7 +77,10 @@ rm -rf %{buildroot}
 %files
 %defattr(-,root,root,-)
 %{_libdir}/libpt2.so.*
+%{_libdir}/libpt2sqlprovider.so.*
 %{_bindir}/pt2-provider
+%{_bindir}/pt2-daemon
+%{_datadir}/dbus-1/services/org.SfietKonstantin.pt2.daemon.service
 
 #%files qml-plugin-ts-devel
 #%defattr(-,root,root,-)
@@ -88,8 +93,12 @@ rm -rf %{buildroot}
 %{_includedir}/pt2/dbus/*.h
 %{_includedir}/pt2/manager/*.h
 %{_includedir}/pt2/provider/*.h
+%{_includedir}/pt2/daemon/*.h
+%{_includedir}/pt2/sqlprovider/*.h
 %{_libdir}/libpt2.so
+%{_libdir}/libpt2sqlprovider.so
 %{_libdir}/pkgconfig/pt2.pc
+%{_libdir}/pkgconfig/pt2sqlprovider.pc
 
 %files qml-plugin
 %{_libdir}/qt5/qml/org/SfietKonstantin/pt2/qmldir
@@ -103,4 +112,4 @@ rm -rf %{buildroot}
 %files plugin-ratp
 /usr/share/pt2/plugins/libratp.so
 /usr/share/pt2/plugins/ratp.desktop
-/usr/share/pt2/plugins/ratp/ratp.db
+/usr/share/pt2/plugins/ratp/ratp.pt2db
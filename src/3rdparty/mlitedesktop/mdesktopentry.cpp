@@ -19,8 +19,8 @@
 #include <QStringList>
 #include <QCoreApplication>
 #include <QTranslator>
-#include <QTextStream>
-#include <QTextCodec>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QDebug>
 
 #include "mdesktopentry.h"
@@ -49,6 +49,8 @@ const QString LogicalIdKey("Desktop Entry/X-MeeGo-Logical-Id");
 const QString TranslationCatalogKey("Desktop Entry/X-MeeGo-Translation-Catalog");
 const QString XMaemoServiceKey("Desktop Entry/X-Maemo-Service");
 QMap<QString, QSharedPointer<QTranslator> > MDesktopEntryPrivate::translators;
+//! Protects the translators, that are shared by all desktop entries
+static QMutex translatorsMutex;
 
 // The syntax of the locale string in the POSIX environment variables
 // related to locale is:
@@ -87,41 +89,16 @@ void parsePosixLang(const QString &localeString, QString *language, QString *cou
 
 MDesktopEntryPrivate::MDesktopEntryPrivate(const QString &fileName) :
     sourceFileName(fileName),
+    translatorsLoaded(false),
     valid(true),
     q_ptr(NULL)
 {
     QFile file(fileName);
 
     //Checks if the file exists and opens it in readonly mode
-    if (file.exists() && file.open(QIODevice::ReadOnly)) {
-        if (readDesktopFile(file, desktopEntriesMap)) {
-            // Load the translation catalog if it has been defined for the entry.
-            if (desktopEntriesMap.contains(TranslationCatalogKey)) {
-                // Load the catalog from disk if it's not yet loaded
-                QString catalog = desktopEntriesMap.value(TranslationCatalogKey);
-                QString engineeringEnglishCatalog = catalog + "_eng_en";
-                if (!translators.contains(engineeringEnglishCatalog)) {
-                    QTranslator *translator = new QTranslator;
-                    if (translator->load(engineeringEnglishCatalog, "/usr/share/translations")) {
-                        translators[engineeringEnglishCatalog] = QSharedPointer<QTranslator>(translator);
-                        qApp->installTranslator(translator);
-                    } else {
-                        delete translator;
-                    }
-                }
-
-                if (!translators.contains(catalog)) {
-                    QTranslator *translator = new QTranslator;
-                    if (translator->load(QLocale(), catalog, "-", "/usr/share/translations")) {
-                        translators[catalog] = QSharedPointer<QTranslator>(translator);
-                        qApp->installTranslator(translator);
-                    } else {
-                        qDebug() << "Unable to load catalog" << catalog;
-                        delete translator;
-                    }
-                }
-            }
-        }
+    if (file.open(QIODevice::ReadOnly)) {
+        data = file.readAll();
+        valid = scanDesktopFile(data, index);
     } else {
         qDebug() << "Specified Desktop file does not exist" << fileName;
     }
@@ -131,91 +108,253 @@ MDesktopEntryPrivate::~MDesktopEntryPrivate()
 {
 }
 
-bool MDesktopEntryPrivate::readDesktopFile(QIODevice &device, QMap<QString, QString> &desktopEntriesMap)
+// Whitespace, as accepted by \s
+static inline bool isSpace(char c)
 {
-    valid = MDesktopEntry::readDesktopFile(device, desktopEntriesMap);
-    return valid;
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
 }
 
-bool MDesktopEntry::readDesktopFile(QIODevice &device, QMap<QString, QString> &desktopEntriesMap)
+// Group names may contain all ASCII characters except for [ and ] and control characters
+static inline bool isGroupNameChar(char c)
+{
+    return c >= 0x20 && c <= 0x7e && c != '[' && c != ']';
+}
+
+static inline bool isKeyChar(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-';
+}
+
+static inline bool isLocaleChar(char c)
+{
+    return isKeyChar(c) || c == '_' || c == '@' || c == '.';
+}
+
+static inline bool isMultiValueKey(const QByteArray &group, const QByteArray &key)
+{
+    return group == "Desktop Entry"
+            && (key == "Categories" || key == "OnlyShowIn" || key == "NotShowIn"
+                || key == "MimeType");
+}
+
+bool MDesktopEntryPrivate::scanDesktopFile(const QByteArray &data, MDesktopEntryIndex &index)
 {
     bool valid = true;
-    // Group header is of form [groupname]
-    // The group name is captured
-    // Group names may contain all ASCII characters except for [ and ] and control characters
-    QRegExp groupHeaderRE("\\[([\\0040-\\0132\\0134\\0136-\\0176]+)\\]");
-    // Key-value pair is of form Key=Value or Key[localization]=Value
-    // The first capture is the key and the second capture is the value
-    QRegExp keyValueRE("([A-Za-z0-9-]+"                // key
-                       "(?:\\[[A-Za-z0-9_@.-]+\\])?"   // optional localization
-                       ")"                             // end key capturing
-                       "\\s*=\\s*"                     // equals
-                       "(.*)");                        // value
-    QString currentGroup;
-    QStringList groupNames;
-    QTextStream stream(&device);
-    stream.setCodec(QTextCodec::codecForName("UTF-8"));
-    while (!stream.atEnd()) {
-        QString line = stream.readLine().trimmed();
-        if (!line.isEmpty() && !line.startsWith('#')) {
-            if (keyValueRE.exactMatch(line) && !currentGroup.isEmpty()) {
-                // A key-value line was found. Prepend the key with the current group name.
-                QString desktopKey = currentGroup + '/' + keyValueRE.cap(1);
-
-                // Check whether it's already in the map
-                if (!desktopEntriesMap.contains(desktopKey)) {
-                    QString value = keyValueRE.cap(2);
-
-                    // Check whether this is a known multivalue key
-                    if (desktopKey == CategoriesKey || desktopKey == OnlyShowInKey ||
-                            desktopKey == NotShowInKey || desktopKey == MimeTypeKey) {
-                        if (value.endsWith("\\;") || !value.endsWith(';')) {
-                            // Multivalue doesn't end with a semicolon so mark the desktop entry invalid
-                            qDebug() << "Value for multivalue key" << desktopKey << "does not end in a semicolon";
-                            valid = false;
-                        }
-                    }
+    const char *begin = data.constData();
+    const int size = data.size();
+    QByteArray currentGroup;
+    QHash<QByteArray, MDesktopEntryValue> *currentEntries = 0;
+
+    int lineStart = 0;
+    while (lineStart < size) {
+        int lineEnd = lineStart;
+        while (lineEnd < size && begin[lineEnd] != '\n') {
+            ++lineEnd;
+        }
+        int next = lineEnd + 1;
 
-                    // Add the value to the desktop entries map
-                    desktopEntriesMap.insert(desktopKey, value);
-                } else {
-                    // Key is already present in the map so issue a warning
-                    qDebug() << "Key" << desktopKey << "already defined. Value" << keyValueRE.cap(2) << "is ignored";
-                }
-            } else if (groupHeaderRE.exactMatch(line)) {
-                // A group header line was found and if it's not already defined, set it as current group
-                if (!groupNames.contains(groupHeaderRE.cap(1), Qt::CaseSensitive)) {
-                    if (groupNames.isEmpty() && groupHeaderRE.cap(1) != "Desktop Entry") {
-                        qDebug() << "Desktop entry should start with group name \"Desktop Entry\" ";
+        // Trim the line
+        int start = lineStart;
+        int end = lineEnd;
+        while (start < end && isSpace(begin[start])) {
+            ++start;
+        }
+        while (end > start && isSpace(begin[end - 1])) {
+            --end;
+        }
+        lineStart = next;
+
+        if (start == end || begin[start] == '#') {
+            continue;
+        }
+
+        // Key-value pair is of form Key=Value or Key[localization]=Value
+        int position = start;
+        while (position < end && isKeyChar(begin[position])) {
+            ++position;
+        }
+        bool keyValue = position > start;
+        if (keyValue && position < end && begin[position] == '[') {
+            int localeStart = ++position;
+            while (position < end && isLocaleChar(begin[position])) {
+                ++position;
+            }
+            keyValue = position > localeStart && position < end && begin[position] == ']';
+            ++position;
+        }
+        int keyEnd = position;
+        if (keyValue) {
+            while (position < end && isSpace(begin[position])) {
+                ++position;
+            }
+            keyValue = position < end && begin[position] == '=';
+        }
+
+        if (keyValue && currentEntries) {
+            ++position;
+            while (position < end && isSpace(begin[position])) {
+                ++position;
+            }
+
+            QByteArray key (begin + start, keyEnd - start);
+            if (!currentEntries->contains(key)) {
+                MDesktopEntryValue value;
+                value.offset = position;
+                value.length = end - position;
+
+                // Check whether this is a known multivalue key
+                if (isMultiValueKey(currentGroup, key)) {
+                    bool endsWithSemicolon = value.length > 0 && begin[end - 1] == ';';
+                    bool escaped = value.length > 1 && begin[end - 2] == '\\';
+                    if (!endsWithSemicolon || escaped) {
+                        // Multivalue doesn't end with a semicolon so mark the desktop entry invalid
+                        qDebug() << "Value for multivalue key" << key << "does not end in a semicolon";
                         valid = false;
-                    } else {
-                        groupNames.push_back(groupHeaderRE.cap(1));
-                        currentGroup = groupHeaderRE.cap(1);
                     }
                 }
-                // Redefining a group name will cause the desktop entry to become invalid but still parsed by the parser.
-                else {
-                    currentGroup = groupHeaderRE.cap(1);
-                    qDebug() << "Multiple definitions of group" << groupHeaderRE.cap(1);
+
+                currentEntries->insert(key, value);
+            } else {
+                // Key is already present in the map so issue a warning
+                qDebug() << "Key" << currentGroup + '/' + key << "already defined. Value"
+                         << QString::fromUtf8(begin + position, end - position) << "is ignored";
+            }
+            continue;
+        }
+
+        // Group header is of form [groupname]
+        bool groupHeader = end - start > 2 && begin[start] == '[' && begin[end - 1] == ']';
+        for (int i = start + 1; groupHeader && i < end - 1; ++i) {
+            groupHeader = isGroupNameChar(begin[i]);
+        }
+
+        if (groupHeader) {
+            QByteArray group (begin + start + 1, end - start - 2);
+            // A group header line was found and if it's not already defined, set it as current group
+            if (!index.contains(group)) {
+                if (index.isEmpty() && group != "Desktop Entry") {
+                    qDebug() << "Desktop entry should start with group name \"Desktop Entry\" ";
                     valid = false;
+                } else {
+                    currentGroup = group;
+                    currentEntries = &index[group];
                 }
-            } else {
-                qDebug() << "Invalid .desktop entry line:" << line;
             }
+            // Redefining a group name will cause the desktop entry to become invalid but still parsed by the parser.
+            else {
+                currentGroup = group;
+                currentEntries = &index[group];
+                qDebug() << "Multiple definitions of group" << group;
+                valid = false;
+            }
+        } else {
+            qDebug() << "Invalid .desktop entry line:" << QString::fromUtf8(begin + start, end - start);
         }
     }
     return valid;
 }
 
+bool MDesktopEntry::readDesktopFile(QIODevice &device, QMap<QString, QString> &desktopEntriesMap)
+{
+    QByteArray data = device.readAll();
+    MDesktopEntryIndex index;
+    bool valid = MDesktopEntryPrivate::scanDesktopFile(data, index);
+
+    MDesktopEntryIndex::const_iterator i;
+    for (i = index.constBegin(); i != index.constEnd(); ++i) {
+        QString group = QString::fromUtf8(i.key());
+        QHash<QByteArray, MDesktopEntryValue>::const_iterator j;
+        for (j = i.value().constBegin(); j != i.value().constEnd(); ++j) {
+            QString key = group + '/' + QString::fromUtf8(j.key());
+            if (!desktopEntriesMap.contains(key)) {
+                desktopEntriesMap.insert(key, QString::fromUtf8(data.constData() + j.value().offset,
+                                                                j.value().length));
+            }
+        }
+    }
+    return valid;
+}
+
+const MDesktopEntryValue *MDesktopEntryPrivate::find(const QString &key) const
+{
+    // Keys cannot contain a slash, but groups can
+    int separator = key.lastIndexOf('/');
+    if (separator == -1) {
+        return 0;
+    }
+    return find(key.left(separator), key.mid(separator + 1));
+}
+
+const MDesktopEntryValue *MDesktopEntryPrivate::find(const QString &group, const QString &key) const
+{
+    MDesktopEntryIndex::const_iterator i = index.constFind(group.toUtf8());
+    if (i == index.constEnd()) {
+        return 0;
+    }
+
+    QHash<QByteArray, MDesktopEntryValue>::const_iterator j = i.value().constFind(key.toUtf8());
+    if (j == i.value().constEnd()) {
+        return 0;
+    }
+    return &j.value();
+}
+
+QString MDesktopEntryPrivate::value(const QString &key) const
+{
+    const MDesktopEntryValue *entryValue = find(key);
+    if (!entryValue) {
+        return QString();
+    }
+    return QString::fromUtf8(data.constData() + entryValue->offset, entryValue->length);
+}
+
+void MDesktopEntryPrivate::loadTranslators() const
+{
+    if (translatorsLoaded) {
+        return;
+    }
+    translatorsLoaded = true;
+
+    // Load the translation catalog if it has been defined for the entry.
+    QString catalog = value(TranslationCatalogKey);
+    if (catalog.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&translatorsMutex);
+    // Load the catalog from disk if it's not yet loaded
+    QString engineeringEnglishCatalog = catalog + "_eng_en";
+    if (!translators.contains(engineeringEnglishCatalog)) {
+        QTranslator *translator = new QTranslator;
+        if (translator->load(engineeringEnglishCatalog, "/usr/share/translations")) {
+            translators[engineeringEnglishCatalog] = QSharedPointer<QTranslator>(translator);
+            qApp->installTranslator(translator);
+        } else {
+            delete translator;
+        }
+    }
+
+    if (!translators.contains(catalog)) {
+        QTranslator *translator = new QTranslator;
+        if (translator->load(QLocale(), catalog, "-", "/usr/share/translations")) {
+            translators[catalog] = QSharedPointer<QTranslator>(translator);
+            qApp->installTranslator(translator);
+        } else {
+            qDebug() << "Unable to load catalog" << catalog;
+            delete translator;
+        }
+    }
+}
+
 bool MDesktopEntryPrivate::boolValue(const QString &key) const
 {
-    return desktopEntriesMap.value(key) == "true";
+    return value(key) == "true";
 }
 
 QStringList MDesktopEntryPrivate::stringListValue(const QString &key) const
 {
     QStringList list;
-    QString value = desktopEntriesMap.value(key);
+    QString value = this->value(key);
 
     // Split the string using ; but not \; as the separator
     const int valueLength = value.length();
@@ -259,22 +398,26 @@ QString MDesktopEntry::fileName() const
 
 bool MDesktopEntry::contains(const QString &key) const
 {
-    return d_ptr->desktopEntriesMap.contains(key);
+    return d_ptr->find(key) != 0;
 }
 
 bool MDesktopEntry::contains(const QString &group, const QString &key) const
 {
-    return d_ptr->desktopEntriesMap.contains(group + '/' + key);
+    return d_ptr->find(group, key) != 0;
 }
 
 QString MDesktopEntry::value(const QString &key) const
 {
-    return d_ptr->desktopEntriesMap.value(key);
+    return d_ptr->value(key);
 }
 
 QString MDesktopEntry::value(const QString &group, const QString &key) const
 {
-    return d_ptr->desktopEntriesMap.value(group + '/' + key);
+    const MDesktopEntryValue *entryValue = d_ptr->find(group, key);
+    if (!entryValue) {
+        return QString();
+    }
+    return QString::fromUtf8(d_ptr->data.constData() + entryValue->offset, entryValue->length);
 }
 
 QStringList MDesktopEntry::stringListValue(const QString &key) const
@@ -338,6 +481,7 @@ QString MDesktopEntry::name() const
     QString name = value(NameKey);
 
     if (contains(LogicalIdKey)) {
+        d_ptr->loadTranslators();
         QString key = value(LogicalIdKey);
         QString translation = qtTrId(key.toLatin1().data());
         if (!translation.isEmpty() && translation != key) {
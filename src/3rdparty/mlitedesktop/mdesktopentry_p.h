@@ -17,11 +17,33 @@
 #ifndef MDESKTOPENTRY_P_H
 #define MDESKTOPENTRY_P_H
 
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
 #include <QSharedPointer>
+#include <QStringList>
 
 class MDesktopEntry;
 class QTranslator;
 
+/*!
+ * Location of a value in the raw contents of a desktop entry file.
+ */
+struct MDesktopEntryValue
+{
+    //! Offset of the value in the raw contents
+    int offset;
+    //! Length of the value, in bytes
+    int length;
+};
+
+/*!
+ * Index of the values of a desktop entry file, by group and by key.
+ * Groups and keys are kept as raw bytes, and values are only decoded
+ * when they are accessed.
+ */
+typedef QHash<QByteArray, QHash<QByteArray, MDesktopEntryValue> > MDesktopEntryIndex;
+
 /*!
  * MDesktopEntryPrivate is the private class for MDesktopEntry.
  */
@@ -43,23 +65,60 @@ public:
     virtual ~MDesktopEntryPrivate();
 
     /*!
-     * Parses a desktop entry file.
+     * Scans the raw contents of a desktop entry file in a single pass.
      *
-     * \param device the QIODevice to read the desktop file from
-     * \param map the QMap to store key-value pairs to
+     * \param data the raw contents of the desktop file
+     * \param index the index to store the location of the values to
      * \return true if desktop file can be parsed
      */
-    bool readDesktopFile(QIODevice &device, QMap<QString, QString> &map);
+    static bool scanDesktopFile(const QByteArray &data, MDesktopEntryIndex &index);
+
+    /*!
+     * Returns the location of the value of a key.
+     *
+     * \param key the key, of the form group/key
+     * \return the location of the value, or 0 if the key is not defined
+     */
+    const MDesktopEntryValue *find(const QString &key) const;
+
+    /*!
+     * Returns the location of the value of a key.
+     *
+     * \param group the group of the key
+     * \param key the key
+     * \return the location of the value, or 0 if the key is not defined
+     */
+    const MDesktopEntryValue *find(const QString &group, const QString &key) const;
+
+    /*!
+     * Decodes the value of a key.
+     *
+     * \param key the key, of the form group/key
+     * \return the value, or an empty string if the key is not defined
+     */
+    QString value(const QString &key) const;
+
+    /*!
+     * Loads the translation catalog defined for the entry, if it
+     * is not yet loaded. Catalogs are only loaded when a localized
+     * value is requested.
+     */
+    void loadTranslators() const;
 
     //! The name of the file where the information for this desktop entry was read from.
     QString sourceFileName;
 
-    //! A map for storing the desktop entries keys and their corresponding values
-    QMap<QString, QString> desktopEntriesMap;
+    //! The raw contents of the desktop entry file
+    QByteArray data;
+
+    //! The location of the values of the desktop entry, by group and key
+    MDesktopEntryIndex index;
 
     //! A map for storing translators for translation catalogs
     static QMap<QString, QSharedPointer<QTranslator> > translators;
 
+    //! Flag to indicate whether the translation catalog was loaded
+    mutable bool translatorsLoaded;
     /*!
      * Returns the boolean value of a key.
      *
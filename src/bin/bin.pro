@@ -1,5 +1,5 @@
 TEMPLATE = subdirs
-SUBDIRS = provider
+SUBDIRS = provider daemon
 
 #contains(CONFIG, mobile): SUBDIRS += mobile
 #!contains(CONFIG, mobile): SUBDIRS += desktop
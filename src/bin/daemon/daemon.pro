@@ -0,0 +1,29 @@
+include(../../../common.pri)
+
+TEMPLATE = app
+TARGET = $${NAME}-daemon
+
+QT = core dbus
+INCLUDEPATH += ../../lib/
+CONFIG(staticprovider): QT += concurrent
+LIBS += -L../../lib/ -l$${NAME}
+!CONFIG(semistatic): {
+LIBS += -L../../3rdparty/mlitedesktop -lmlitedesktop
+}
+
+HEADERS +=  \
+
+SOURCES +=  main.cpp
+
+# DBus activation
+QMAKE_SUBSTITUTES += org.SfietKonstantin.pt2.daemon.service.in
+OTHER_FILES += org.SfietKonstantin.pt2.daemon.service.in
+
+# deployment
+target.path = $${APPLICATION_FOLDER}
+
+dbusService.path = $${PREFIX}/share/dbus-1/services
+dbusService.files = $$OUT_PWD/org.SfietKonstantin.pt2.daemon.service
+dbusService.CONFIG += no_check_exist
+
+INSTALLS += target dbusService
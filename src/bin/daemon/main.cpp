@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+/**
+ * @file daemon/main.cpp
+ * @short Entry point of the daemon
+ */
+
+#include <iostream>
+#include <signal.h>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusConnectionInterface>
+
+#include "debug.h"
+#include "daemon/daemonservice.h"
+#include "dbus/dbusconstants.h"
+#include "manager/backendlistmanager.h"
+#include "manager/dbusbackendmanager.h"
+
+using namespace std;
+using namespace PT2;
+
+/**
+ * @brief Display help
+ */
+void displayHelp()
+{
+    cout << "pt2 daemon, version " << VERSION << endl;
+    cout << endl;
+    cout << "Usage: pt2-daemon" << endl;
+    cout << "Run the backends, and share them with the applications that use the daemon."
+         << endl;
+}
+
+/**
+ * @brief UNIX signal handler
+ * @param signal signal.
+ */
+void signalHandler(int signal)
+{
+    switch(signal) {
+        case SIGTERM:
+        case SIGINT:
+            debug("daemon") << "Daemon terminated";
+            QCoreApplication::quit();
+            break;
+    }
+}
+
+/**
+ * @brief Main
+ *
+ * Entry point of the daemon.
+ *
+ * @param argc argc.
+ * @param argv argv.
+ * @return exit code.
+ */
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    if (app.arguments().count() != 1) {
+        displayHelp();
+        return 0;
+    }
+
+    // Backends talk to the owner of the pt2 service, so
+    // only one manager can run on the session bus
+    QDBusConnectionInterface *interface = QDBusConnection::sessionBus().interface();
+    if (interface->isServiceRegistered(DBUS_SERVICE)) {
+        warning("daemon") << "Another backend manager is already running";
+        return 1;
+    }
+
+    DBusBackendManager backendManager;
+    BackendListManager backendListManager;
+    DaemonService service (&backendManager, &backendListManager);
+    if (!service.registerDBusService()) {
+        warning("daemon") << "Failed to register the daemon DBus service";
+        return 1;
+    }
+    backendListManager.reload();
+
+    // Handle signals
+    signal(SIGTERM, signalHandler);
+    signal(SIGINT, signalHandler);
+
+    return app.exec();
+}
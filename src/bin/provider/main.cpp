@@ -38,6 +38,7 @@
 #include <signal.h>
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QtPlugin>
 #include <QtCore/QStringList>
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusInterface>
@@ -46,6 +47,13 @@
 #include "dbus/dbushelper.h"
 #include "provider/providerplugindbuswrapper.h"
 
+#ifdef PT2_STATIC_PROVIDER
+// Plugins linked in the provider. They are selected by name
+// in ProviderPluginDBusWrapper::load().
+Q_IMPORT_PLUGIN(Ratp)
+Q_IMPORT_PLUGIN(Test)
+#endif
+
 using namespace std;
 using namespace PT2;
 
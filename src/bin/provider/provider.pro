@@ -5,6 +5,13 @@ TARGET = $${NAME}-provider
 
 QT = core dbus
 INCLUDEPATH += ../../lib/
+CONFIG(staticprovider): {
+QT += network concurrent
+LIBS += -L../../plugins/ratp/ -lratp
+LIBS += -L../../plugins/test/ -ltest
+PRE_TARGETDEPS += ../../plugins/ratp/libratp.a ../../plugins/test/libtest.a \
+                  ../../lib/lib$${NAME}.a
+}
 LIBS += -L../../lib/ -l$${NAME}
 !CONFIG(semistatic): {
 LIBS += -L../../3rdparty/mlitedesktop -lmlitedesktop
@@ -58,5 +58,14 @@
  * provided string.
  */
 #define CAPABILITY_REAL_TIME_SUGGEST_LINE_FROM_STRING "capability:real_time_suggest_line_from_string"
+/**
+ * @short CAPABILITY_REAL_TIME_SUGGEST_STATION_COMPLETE
+ *
+ * The backend returns every station whose name contains the
+ * provided string, ignoring case and diacritic marks. The
+ * stations suggested for a longer string can then be found
+ * by filtering the stations suggested for a shorter one.
+ */
+#define CAPABILITY_REAL_TIME_SUGGEST_STATION_COMPLETE "capability:real_time_suggest_station_complete"
 
 #endif // CAPABILITIESCONSTANTS_H
@@ -0,0 +1,12 @@
+HEADERS += $$PWD/daemonservice.h \
+    $$PWD/daemonbackendwrapper.h \
+    $$PWD/daemonbackendmanager.h
+
+SOURCES += $$PWD/daemonservice.cpp \
+    $$PWD/daemonbackendwrapper.cpp \
+    $$PWD/daemonbackendmanager.cpp
+
+daemon_headers.files = $$PWD/*.h
+daemon_headers.path = $${INCLUDEDIR}/daemon
+
+!CONFIG(optify): INSTALLS += daemon_headers
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+/**
+ * @file daemonbackendmanager.cpp
+ * @short Implementation of PT2::DaemonBackendManager
+ */
+
+#include "daemonbackendmanager.h"
+
+#include "daemonbackendwrapper.h"
+
+namespace PT2
+{
+
+DaemonBackendManager::DaemonBackendManager(QObject *parent) :
+    AbstractBackendManager(parent)
+{
+    // Results are cached by the daemon
+    setResultCacheEnabled(false);
+
+    // The daemon already launched the enabled backends when
+    // it started, so they are usually available immediately
+    startEnabledBackends();
+}
+
+DaemonBackendManager::~DaemonBackendManager()
+{
+}
+
+AbstractBackendWrapper * DaemonBackendManager::createBackend(const QString &identifier,
+                                                             const QString &executable,
+                                                             const QMap<QString, QString> &attributes,
+                                                             QObject *parent) const
+{
+    return new DaemonBackendWrapper(identifier, executable, attributes, parent);
+}
+
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef PT2_DAEMONBACKENDMANAGER_H
+#define PT2_DAEMONBACKENDMANAGER_H
+
+/**
+ * @file daemonbackendmanager.h
+ * @short Definition of PT2::DaemonBackendManager
+ */
+
+#include "pt2_global.h"
+#include "manager/abstractbackendmanager.h"
+
+namespace PT2
+{
+
+/**
+ * @brief Backend manager that uses the backends of the pt2 daemon
+ *
+ * This class implements a manager that uses daemon backend
+ * wrappers, so that an application can share the backends of
+ * the pt2 daemon with other applications, instead of launching
+ * its own backends with PT2::DBusBackendManager. It does not
+ * register any DBus service, so many applications can use it
+ * at the same time.
+ *
+ * The enabled backends are added, and the daemon is asked to
+ * launch them, when this manager is created.
+ */
+class PT2_EXPORT DaemonBackendManager : public AbstractBackendManager
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Default constructor
+     * @param parent parent object.
+     */
+    explicit DaemonBackendManager(QObject *parent = 0);
+    /**
+     * @brief Destructor
+     */
+    virtual ~DaemonBackendManager();
+protected:
+    /**
+     * @brief Create a backend
+     * @param identifier identifier.
+     * @param executable executable.
+     * @param attributes attributes.
+     * @param parent parent.
+     * @return created backend.
+     */
+    virtual AbstractBackendWrapper * createBackend(const QString &identifier,
+                                                   const QString &executable,
+                                                   const QMap<QString, QString> &attributes,
+                                                   QObject *parent = 0) const;
+};
+
+}
+
+#endif // PT2_DAEMONBACKENDMANAGER_H
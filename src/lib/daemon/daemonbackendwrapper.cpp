@@ -0,0 +1,376 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+/**
+ * @file daemonbackendwrapper.cpp
+ * @short Implementation of PT2::DaemonBackendWrapper
+ */
+
+#include "daemonbackendwrapper.h"
+#include "manager/abstractbackendwrapper_p.h"
+
+#include <QtCore/QHash>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+
+#include "debug.h"
+#include "errorid.h"
+#include "base/line.h"
+#include "base/station.h"
+#include "dbus/dbusconstants.h"
+#include "dbus/dbushelper.h"
+#include "dbus/generated/daemondbusproxy.h"
+
+namespace PT2
+{
+
+/**
+ * @internal
+ * @brief Private class for PT2::DaemonBackendWrapper
+ */
+class DaemonBackendWrapperPrivate: public AbstractBackendWrapperPrivate
+{
+    Q_OBJECT
+public:
+    /**
+     * @internal
+     * @brief Default constructor
+     * @param q Q-pointer
+     */
+    explicit DaemonBackendWrapperPrivate(DaemonBackendWrapper *q);
+    /**
+     * @internal
+     * @brief Mirror the properties of the backend in the daemon
+     * @param properties properties of the backend.
+     */
+    void setProperties(const QVariantMap &properties);
+    /**
+     * @internal
+     * @brief Daemon proxy
+     */
+    OrgSfietKonstantinPt2DaemonInterface *proxy;
+    /**
+     * @internal
+     * @brief Requests being sent to the daemon
+     */
+    QHash<QDBusPendingCallWatcher *, QString> sentRequests;
+public Q_SLOTS:
+    /**
+     * @internal
+     * @brief Slot for backend properties changed
+     * @param identifier identifier of the backend.
+     * @param properties properties of the backend.
+     */
+    void slotBackendPropertiesChanged(const QString &identifier, const QVariantMap &properties);
+    /**
+     * @internal
+     * @brief Slot for backend properties retrieved
+     * @param watcher pending call watcher.
+     */
+    void slotPropertiesFinished(QDBusPendingCallWatcher *watcher);
+    /**
+     * @internal
+     * @brief Slot for launch finished
+     * @param watcher pending call watcher.
+     */
+    void slotLaunchFinished(QDBusPendingCallWatcher *watcher);
+    /**
+     * @internal
+     * @brief Slot for request sent
+     * @param watcher pending call watcher.
+     */
+    void slotRequestFinished(QDBusPendingCallWatcher *watcher);
+    /**
+     * @internal
+     * @brief Slot for error registered
+     * @param requests request identifiers.
+     * @param errorId error category.
+     * @param error error.
+     */
+    void slotErrorRegistered(const QStringList &requests, const QString &errorId,
+                             const QString &error);
+    /**
+     * @internal
+     * @brief Slot for suggested stations registered
+     * @param requests request identifiers.
+     * @param suggestedStationList suggested station list.
+     */
+    void slotRealTimeSuggestedStationsRegistered(const QStringList &requests,
+                                                 const QList<PT2::Station> &suggestedStationList);
+    /**
+     * @internal
+     * @brief Slot for rides from station registered
+     * @param requests request identifiers.
+     * @param rideList ride list.
+     */
+    void slotRealTimeRidesFromStationRegistered(const QStringList &requests,
+                                                const QList<PT2::CompanyNodeData> &rideList);
+    /**
+     * @internal
+     * @brief Slot for suggested lines registered
+     * @param requests request identifiers.
+     * @param suggestedLineList suggested line list.
+     */
+    void slotRealTimeSuggestedLinesRegistered(const QStringList &requests,
+                                              const QList<PT2::Line> &suggestedLineList);
+private:
+    /**
+     * @internal
+     * @brief Q-pointer
+     */
+    DaemonBackendWrapper * const q_ptr;
+    Q_DECLARE_PUBLIC(DaemonBackendWrapper)
+};
+
+DaemonBackendWrapperPrivate::DaemonBackendWrapperPrivate(DaemonBackendWrapper *q):
+    AbstractBackendWrapperPrivate(), proxy(0), q_ptr(q)
+{
+}
+
+void DaemonBackendWrapperPrivate::setProperties(const QVariantMap &properties)
+{
+    Q_Q(DaemonBackendWrapper);
+    // The backend is not known by the daemon until it is launched
+    if (properties.isEmpty()) {
+        return;
+    }
+
+    q->setLastError(properties.value(DBUS_DAEMON_LAST_ERROR_PROPERTY).toString());
+    q->setBackendProperties(properties.value(DBUS_DAEMON_CAPABILITIES_PROPERTY).toStringList(),
+                            properties.value(DBUS_DAEMON_COPYRIGHT_PROPERTY).toString());
+    int status = properties.value(DBUS_DAEMON_STATUS_PROPERTY).toInt();
+    q->setStatus(static_cast<AbstractBackendWrapper::Status>(status));
+}
+
+void DaemonBackendWrapperPrivate::slotBackendPropertiesChanged(const QString &identifier,
+                                                               const QVariantMap &properties)
+{
+    if (identifier == this->identifier) {
+        setProperties(properties);
+    }
+}
+
+void DaemonBackendWrapperPrivate::slotPropertiesFinished(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<QVariantMap> reply = *watcher;
+    if (!reply.isError()) {
+        setProperties(reply.value());
+    }
+    watcher->deleteLater();
+}
+
+void DaemonBackendWrapperPrivate::slotLaunchFinished(QDBusPendingCallWatcher *watcher)
+{
+    Q_Q(DaemonBackendWrapper);
+    QDBusPendingReply<bool> reply = *watcher;
+    if (reply.isError()) {
+        q->setLastError(QString("Failed to contact the daemon: \"%1\"").arg(reply.error().message()));
+        q->setStatus(AbstractBackendWrapper::Invalid);
+    } else if (!reply.value()) {
+        q->setLastError(QString("The daemon cannot find %1").arg(identifier));
+        q->setStatus(AbstractBackendWrapper::Invalid);
+    }
+    watcher->deleteLater();
+}
+
+void DaemonBackendWrapperPrivate::slotRequestFinished(QDBusPendingCallWatcher *watcher)
+{
+    Q_Q(DaemonBackendWrapper);
+    QString request = sentRequests.take(watcher);
+    if (watcher->isError()) {
+        q->registerError(request, ERROR_BACKEND_NOT_LAUNCHED,
+                         QString("Failed to contact the daemon: \"%1\"").arg(watcher->error().message()));
+    }
+    watcher->deleteLater();
+}
+
+void DaemonBackendWrapperPrivate::slotErrorRegistered(const QStringList &requests,
+                                                      const QString &errorId,
+                                                      const QString &error)
+{
+    Q_Q(DaemonBackendWrapper);
+    // Unknown requests, sent by other clients, are ignored
+    foreach (const QString &request, requests) {
+        q->registerError(request, errorId, error);
+    }
+}
+
+void DaemonBackendWrapperPrivate::slotRealTimeSuggestedStationsRegistered(const QStringList &requests,
+                                                                          const QList<PT2::Station> &suggestedStationList)
+{
+    Q_Q(DaemonBackendWrapper);
+    foreach (const QString &request, requests) {
+        q->registerRealTimeSuggestedStations(request, suggestedStationList);
+    }
+}
+
+void DaemonBackendWrapperPrivate::slotRealTimeRidesFromStationRegistered(const QStringList &requests,
+                                                                         const QList<PT2::CompanyNodeData> &rideList)
+{
+    Q_Q(DaemonBackendWrapper);
+    foreach (const QString &request, requests) {
+        q->registerRealTimeRidesFromStation(request, rideList);
+    }
+}
+
+void DaemonBackendWrapperPrivate::slotRealTimeSuggestedLinesRegistered(const QStringList &requests,
+                                                                       const QList<PT2::Line> &suggestedLineList)
+{
+    Q_Q(DaemonBackendWrapper);
+    foreach (const QString &request, requests) {
+        q->registerRealTimeSuggestedLines(request, suggestedLineList);
+    }
+}
+
+////// End of private class //////
+
+DaemonBackendWrapper::DaemonBackendWrapper(const QString &identifier, const QString &executable,
+                                           const QMap<QString, QString> &arguments,
+                                           QObject *parent):
+    AbstractBackendWrapper(*(new DaemonBackendWrapperPrivate(this)), parent)
+{
+    Q_D(DaemonBackendWrapper);
+    registerDBusTypes();
+
+    d->identifier = identifier;
+    d->executable = executable;
+    d->arguments = arguments;
+
+    d->proxy = new OrgSfietKonstantinPt2DaemonInterface(DBUS_DAEMON_SERVICE, DBUS_DAEMON_PATH,
+                                                        QDBusConnection::sessionBus(), this);
+    connect(d->proxy, &OrgSfietKonstantinPt2DaemonInterface::backendPropertiesChanged,
+            d, &DaemonBackendWrapperPrivate::slotBackendPropertiesChanged);
+    connect(d->proxy, &OrgSfietKonstantinPt2DaemonInterface::errorRegistered,
+            d, &DaemonBackendWrapperPrivate::slotErrorRegistered);
+    connect(d->proxy, &OrgSfietKonstantinPt2DaemonInterface::realTimeSuggestedStationsRegistered,
+            d, &DaemonBackendWrapperPrivate::slotRealTimeSuggestedStationsRegistered);
+    connect(d->proxy, &OrgSfietKonstantinPt2DaemonInterface::realTimeRidesFromStationRegistered,
+            d, &DaemonBackendWrapperPrivate::slotRealTimeRidesFromStationRegistered);
+    connect(d->proxy, &OrgSfietKonstantinPt2DaemonInterface::realTimeSuggestedLinesRegistered,
+            d, &DaemonBackendWrapperPrivate::slotRealTimeSuggestedLinesRegistered);
+
+    // The backend might already be launched by the daemon
+    QDBusPendingCallWatcher *watcher
+            = new QDBusPendingCallWatcher(d->proxy->backendProperties(identifier), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+            d, &DaemonBackendWrapperPrivate::slotPropertiesFinished);
+}
+
+DaemonBackendWrapper::~DaemonBackendWrapper()
+{
+}
+
+QString DaemonBackendWrapper::requestRealTimeSuggestedStations(const QString &partialStation)
+{
+    QString request = createRequest(RealTime_SuggestStationFromStringType);
+    QVariantList arguments;
+    arguments.append(QVariant::fromValue(partialStation));
+    sendQueuedRequest(request, RealTime_SuggestStationFromStringType, arguments);
+    return request;
+}
+
+QString DaemonBackendWrapper::requestRealTimeRidesFromStation(const PT2::Station &station)
+{
+    QString request = createRequest(RealTime_RidesFromStationType);
+    QVariantList arguments;
+    arguments.append(QVariant::fromValue(station));
+    sendQueuedRequest(request, RealTime_RidesFromStationType, arguments);
+    return request;
+}
+
+QString DaemonBackendWrapper::requestRealTimeSuggestedLines(const QString &partialLine)
+{
+    QString request = createRequest(RealTime_SuggestLineFromStringType);
+    QVariantList arguments;
+    arguments.append(QVariant::fromValue(partialLine));
+    sendQueuedRequest(request, RealTime_SuggestLineFromStringType, arguments);
+    return request;
+}
+
+void DaemonBackendWrapper::launch()
+{
+    Q_D(DaemonBackendWrapper);
+    if (identifier().isEmpty()) {
+        setLastError("No identifier was set");
+        setStatus(Invalid);
+        return;
+    }
+
+    debug("daemon-backend-wrapper") << "Asking the daemon to launch" << identifier();
+    QDBusPendingCallWatcher *watcher
+            = new QDBusPendingCallWatcher(d->proxy->launchBackend(identifier()), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+            d, &DaemonBackendWrapperPrivate::slotLaunchFinished);
+}
+
+void DaemonBackendWrapper::stop()
+{
+}
+
+void DaemonBackendWrapper::kill()
+{
+}
+
+void DaemonBackendWrapper::sendQueuedRequest(const QString &request, RequestType requestType,
+                                             const QVariantList &arguments)
+{
+    Q_D(DaemonBackendWrapper);
+    // Requests are not queued here, since the daemon
+    // queues them until the backend is launched
+    QDBusPendingReply<> reply;
+    switch (requestType) {
+    case RealTime_SuggestStationFromStringType:
+        reply = d->proxy->requestRealTimeSuggestedStations(identifier(), request,
+                                                           arguments.at(0).value<QString>());
+        break;
+    case RealTime_RidesFromStationType:
+        reply = d->proxy->requestRealTimeRidesFromStation(identifier(), request,
+                                                          arguments.at(0).value<PT2::Station>());
+        break;
+    case RealTime_SuggestLineFromStringType:
+        reply = d->proxy->requestRealTimeSuggestedLines(identifier(), request,
+                                                        arguments.at(0).value<QString>());
+        break;
+    default:
+        return;
+        break;
+    }
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+    d->sentRequests.insert(watcher, request);
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+            d, &DaemonBackendWrapperPrivate::slotRequestFinished);
+}
+
+}
+
+#include "daemonbackendwrapper.moc"
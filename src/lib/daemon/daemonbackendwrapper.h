@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef PT2_DAEMONBACKENDWRAPPER_H
+#define PT2_DAEMONBACKENDWRAPPER_H
+
+/**
+ * @file daemonbackendwrapper.h
+ * @short Definition of PT2::DaemonBackendWrapper
+ */
+
+#include "pt2_global.h"
+#include "manager/abstractbackendwrapper.h"
+
+namespace PT2
+{
+
+class DaemonBackendWrapperPrivate;
+
+/**
+ * @brief Backend wrapper for a backend owned by the pt2 daemon
+ *
+ * This class implements a wrapper that forwards requests to
+ * the pt2 daemon, through PT2::DaemonService, instead of running
+ * the backend. The status, capabilities and copyright mirror the
+ * ones of the backend in the daemon.
+ *
+ * Backends are shared by all the clients of the daemon, so stop()
+ * and kill() do not stop them: the daemon stops the backends that
+ * are launched on demand when they are idle. Requests are queued by
+ * the daemon when the backend is not launched yet.
+ */
+class PT2_EXPORT DaemonBackendWrapper : public AbstractBackendWrapper
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Default constructor
+     *
+     * @param identifier identifier for this backend wrapper.
+     * @param executable command line that launch the backend, unused.
+     * @param arguments list of arguments, unused.
+     * @param parent parent object.
+     */
+    explicit DaemonBackendWrapper(const QString &identifier, const QString &executable,
+                                  const QMap<QString, QString> &arguments, QObject *parent = 0);
+    /**
+     * @brief Destructor
+     */
+    virtual ~DaemonBackendWrapper();
+    /**
+     * @brief Request suggested stations for real time information
+     * @param partialStation partial station name.
+     * @return request identifier.
+     */
+    QString requestRealTimeSuggestedStations(const QString &partialStation);
+    /**
+     * @brief Request rides from station for real time information
+     * @param station station.
+     * @return request identifier.
+     */
+    QString requestRealTimeRidesFromStation(const PT2::Station &station);
+    /**
+     * @brief Request suggested lines for real time information
+     * @param partialLine partial line name.
+     * @return request identifier.
+     */
+    QString requestRealTimeSuggestedLines(const QString &partialLine);
+public Q_SLOTS:
+    /**
+     * @brief Launch the backend
+     *
+     * Asks the daemon to launch the backend, if it is not
+     * launched yet.
+     */
+    virtual void launch();
+    /**
+     * @brief Stop the backend
+     *
+     * The backend is owned by the daemon, and is not stopped.
+     */
+    virtual void stop();
+    /**
+     * @brief Kill the backend
+     *
+     * The backend is owned by the daemon, and is not killed.
+     */
+    virtual void kill();
+protected:
+    /**
+     * @brief Reimplementation of sendQueuedRequest
+     *
+     * @param request request identifier.
+     * @param requestType request type.
+     * @param arguments arguments of the request.
+     */
+    void sendQueuedRequest(const QString &request, RequestType requestType,
+                           const QVariantList &arguments);
+private:
+    Q_DECLARE_PRIVATE(DaemonBackendWrapper)
+};
+
+}
+
+#endif // PT2_DAEMONBACKENDWRAPPER_H
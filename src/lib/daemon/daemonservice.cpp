@@ -0,0 +1,562 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+/**
+ * @file daemonservice.cpp
+ * @short Implementation of PT2::DaemonService
+ */
+
+#include "daemonservice.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtDBus/QDBusConnection>
+
+#include "debug.h"
+#include "errorid.h"
+#include "base/companynodedata.h"
+#include "base/line.h"
+#include "base/station.h"
+#include "dbus/dbusconstants.h"
+#include "dbus/dbushelper.h"
+#include "dbus/generated/daemonserviceadaptor.h"
+#include "manager/abstractbackendmanager.h"
+#include "manager/abstractbackendwrapper.h"
+#include "manager/backendinfo.h"
+#include "manager/backendlistmanager.h"
+
+namespace PT2
+{
+
+/**
+ * @internal
+ * @brief Private class for PT2::DaemonService
+ */
+class DaemonServicePrivate: public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @internal
+     * @brief Default constructor
+     * @param q Q-pointer.
+     */
+    explicit DaemonServicePrivate(DaemonService *q);
+    /**
+     * @internal
+     * @brief Properties of a backend
+     * @param backend backend.
+     * @return properties of the backend.
+     */
+    static QVariantMap properties(AbstractBackendWrapper *backend);
+    /**
+     * @internal
+     * @brief Key identifying the data that is requested
+     * @param identifier identifier of the backend.
+     * @param requestType request type.
+     * @param argument argument of the request.
+     * @return key of the request.
+     */
+    static QString requestKey(const QString &identifier,
+                              AbstractBackendWrapper::RequestType requestType,
+                              const QString &argument);
+    /**
+     * @internal
+     * @brief Add a backend from the backend list
+     * @param identifier identifier of the backend.
+     * @return if the backend was found in the backend list.
+     */
+    bool addBackend(const QString &identifier);
+    /**
+     * @internal
+     * @brief Multiplex a client request on a running request
+     * @param key key of the request.
+     * @param request client request identifier.
+     * @return if the same data is already being requested.
+     */
+    bool multiplex(const QString &key, const QString &request);
+    /**
+     * @internal
+     * @brief Backend that can answer a client request
+     *
+     * If the backend cannot answer, an error is registered
+     * for the client request.
+     *
+     * @param identifier identifier of the backend.
+     * @param request client request identifier.
+     * @return backend, or 0 if it is not available.
+     */
+    AbstractBackendWrapper * availableBackend(const QString &identifier, const QString &request);
+    /**
+     * @internal
+     * @brief Register a request sent to a backend
+     * @param key key of the request.
+     * @param backendRequest backend request identifier.
+     * @param request client request identifier.
+     */
+    void addRequest(const QString &key, const QString &backendRequest, const QString &request);
+    /**
+     * @internal
+     * @brief Take the client requests answered by a backend request
+     * @param backendRequest backend request identifier.
+     * @return client request identifiers.
+     */
+    QStringList takeRequests(const QString &backendRequest);
+    /**
+     * @internal
+     * @brief If the backend that sent a result is revalidating it
+     * @param backendRequest backend request identifier.
+     * @return if the result is a stale cached result.
+     */
+    bool isRevalidating(const QString &backendRequest) const;
+    /**
+     * @internal
+     * @brief Backend manager
+     */
+    AbstractBackendManager *backendManager;
+    /**
+     * @internal
+     * @brief Backend list manager
+     */
+    BackendListManager *backendListManager;
+    /**
+     * @internal
+     * @brief Running backend requests, by key
+     */
+    QHash<QString, QString> backendRequests;
+    /**
+     * @internal
+     * @brief Keys of the running backend requests
+     */
+    QHash<QString, QString> requestKeys;
+    /**
+     * @internal
+     * @brief Client requests, by backend request
+     */
+    QHash<QString, QStringList> clientRequests;
+    /**
+     * @internal
+     * @brief Backends to launch when the backend list is loaded
+     */
+    QSet<QString> pendingLaunches;
+public Q_SLOTS:
+    /**
+     * @internal
+     * @brief Slot for backend added
+     * @param identifier identifier.
+     * @param backend backend.
+     */
+    void slotBackendAdded(const QString &identifier, AbstractBackendWrapper *backend);
+    /**
+     * @internal
+     * @brief Slot for backend status or properties changed
+     */
+    void slotBackendChanged();
+    /**
+     * @internal
+     * @brief Slot for loading changed
+     */
+    void slotLoadingChanged();
+    /**
+     * @internal
+     * @brief Slot for error registered
+     * @param request backend request identifier.
+     * @param errorId error category.
+     * @param error error.
+     */
+    void slotErrorRegistered(const QString &request, const QString &errorId,
+                             const QString &error);
+    /**
+     * @internal
+     * @brief Slot for suggested stations registered
+     * @param request backend request identifier.
+     * @param suggestedStationList suggested station list.
+     */
+    void slotRealTimeSuggestedStationsRegistered(const QString &request,
+                                                 const QList<PT2::Station> &suggestedStationList);
+    /**
+     * @internal
+     * @brief Slot for rides from station registered
+     * @param request backend request identifier.
+     * @param rideList ride list.
+     */
+    void slotRealTimeRidesFromStationRegistered(const QString &request,
+                                                const QList<PT2::CompanyNodeData> &rideList);
+    /**
+     * @internal
+     * @brief Slot for suggested lines registered
+     * @param request backend request identifier.
+     * @param suggestedLineList suggested line list.
+     */
+    void slotRealTimeSuggestedLinesRegistered(const QString &request,
+                                              const QList<PT2::Line> &suggestedLineList);
+private:
+    /**
+     * @internal
+     * @brief Q-pointer
+     */
+    DaemonService * const q_ptr;
+    Q_DECLARE_PUBLIC(DaemonService)
+};
+
+DaemonServicePrivate::DaemonServicePrivate(DaemonService *q):
+    QObject(), backendManager(0), backendListManager(0), q_ptr(q)
+{
+}
+
+QVariantMap DaemonServicePrivate::properties(AbstractBackendWrapper *backend)
+{
+    QVariantMap properties;
+    properties.insert(DBUS_DAEMON_STATUS_PROPERTY, int(backend->status()));
+    properties.insert(DBUS_DAEMON_LAST_ERROR_PROPERTY, backend->lastError());
+    properties.insert(DBUS_DAEMON_CAPABILITIES_PROPERTY, backend->capabilities());
+    properties.insert(DBUS_DAEMON_COPYRIGHT_PROPERTY, backend->copyright());
+    return properties;
+}
+
+QString DaemonServicePrivate::requestKey(const QString &identifier,
+                                         AbstractBackendWrapper::RequestType requestType,
+                                         const QString &argument)
+{
+    return QString("%1/%2/%3").arg(identifier, QString::number(requestType), argument);
+}
+
+bool DaemonServicePrivate::addBackend(const QString &identifier)
+{
+    if (!backendListManager) {
+        return false;
+    }
+
+    foreach (const BackendInfo &backendInfo, backendListManager->backendList()) {
+        if (backendInfo.backendIdentifier() == identifier) {
+            backendManager->addBackend(backendInfo);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DaemonServicePrivate::multiplex(const QString &key, const QString &request)
+{
+    if (!backendRequests.contains(key)) {
+        return false;
+    }
+
+    QString backendRequest = backendRequests.value(key);
+    debug("daemon-service") << "Multiplexing request" << request << "on" << backendRequest;
+    clientRequests[backendRequest].append(request);
+    return true;
+}
+
+AbstractBackendWrapper * DaemonServicePrivate::availableBackend(const QString &identifier,
+                                                                const QString &request)
+{
+    Q_Q(DaemonService);
+    AbstractBackendWrapper *backend = backendManager->backend(identifier);
+    if (!backend) {
+        emit q->errorRegistered(QStringList() << request, ERROR_BACKEND_NOT_LAUNCHED,
+                                QString("Unknown backend %1").arg(identifier));
+        return 0;
+    }
+
+    if (backend->status() != AbstractBackendWrapper::Launched
+        && !backend->isLaunchedOnDemand()) {
+        emit q->errorRegistered(QStringList() << request, ERROR_BACKEND_NOT_LAUNCHED,
+                                QString("Backend %1 is not launched").arg(identifier));
+        return 0;
+    }
+
+    return backend;
+}
+
+void DaemonServicePrivate::addRequest(const QString &key, const QString &backendRequest,
+                                      const QString &request)
+{
+    backendRequests.insert(key, backendRequest);
+    requestKeys.insert(backendRequest, key);
+    clientRequests[backendRequest].append(request);
+}
+
+QStringList DaemonServicePrivate::takeRequests(const QString &backendRequest)
+{
+    backendRequests.remove(requestKeys.take(backendRequest));
+    return clientRequests.take(backendRequest);
+}
+
+bool DaemonServicePrivate::isRevalidating(const QString &backendRequest) const
+{
+    AbstractBackendWrapper *backend = qobject_cast<AbstractBackendWrapper *>(sender());
+    return backend && backend->isRevalidating(backendRequest);
+}
+
+void DaemonServicePrivate::slotBackendAdded(const QString &identifier,
+                                            AbstractBackendWrapper *backend)
+{
+    Q_Q(DaemonService);
+    connect(backend, &AbstractBackendWrapper::statusChanged,
+            this, &DaemonServicePrivate::slotBackendChanged);
+    connect(backend, &AbstractBackendWrapper::capabilitiesChanged,
+            this, &DaemonServicePrivate::slotBackendChanged);
+    connect(backend, &AbstractBackendWrapper::copyrightChanged,
+            this, &DaemonServicePrivate::slotBackendChanged);
+    connect(backend, &AbstractBackendWrapper::errorRegistered,
+            this, &DaemonServicePrivate::slotErrorRegistered);
+    connect(backend, &AbstractBackendWrapper::realTimeSuggestedStationsRegistered,
+            this, &DaemonServicePrivate::slotRealTimeSuggestedStationsRegistered);
+    connect(backend, &AbstractBackendWrapper::realTimeRidesFromStationRegistered,
+            this, &DaemonServicePrivate::slotRealTimeRidesFromStationRegistered);
+    connect(backend, &AbstractBackendWrapper::realTimeSuggestedLinesRegistered,
+            this, &DaemonServicePrivate::slotRealTimeSuggestedLinesRegistered);
+
+    emit q->backendPropertiesChanged(identifier, properties(backend));
+}
+
+void DaemonServicePrivate::slotBackendChanged()
+{
+    Q_Q(DaemonService);
+    AbstractBackendWrapper *backend = qobject_cast<AbstractBackendWrapper *>(sender());
+    if (!backend) {
+        return;
+    }
+
+    emit q->backendPropertiesChanged(backend->identifier(), properties(backend));
+}
+
+void DaemonServicePrivate::slotLoadingChanged()
+{
+    Q_Q(DaemonService);
+    if (backendListManager->isLoading()) {
+        return;
+    }
+
+    QSet<QString> launches = pendingLaunches;
+    pendingLaunches.clear();
+    foreach (const QString &identifier, launches) {
+        if (!q->launchBackend(identifier)) {
+            warning("daemon-service") << "Backend" << identifier << "cannot be found";
+        }
+    }
+}
+
+void DaemonServicePrivate::slotErrorRegistered(const QString &request, const QString &errorId,
+                                               const QString &error)
+{
+    Q_Q(DaemonService);
+    QStringList requests = takeRequests(request);
+    if (!requests.isEmpty()) {
+        emit q->errorRegistered(requests, errorId, error);
+    }
+}
+
+void DaemonServicePrivate::slotRealTimeSuggestedStationsRegistered(const QString &request,
+                                                                   const QList<PT2::Station> &suggestedStationList)
+{
+    Q_Q(DaemonService);
+    if (isRevalidating(request)) {
+        return;
+    }
+
+    QStringList requests = takeRequests(request);
+    if (!requests.isEmpty()) {
+        emit q->realTimeSuggestedStationsRegistered(requests, suggestedStationList);
+    }
+}
+
+void DaemonServicePrivate::slotRealTimeRidesFromStationRegistered(const QString &request,
+                                                                  const QList<PT2::CompanyNodeData> &rideList)
+{
+    Q_Q(DaemonService);
+    if (isRevalidating(request)) {
+        return;
+    }
+
+    QStringList requests = takeRequests(request);
+    if (!requests.isEmpty()) {
+        emit q->realTimeRidesFromStationRegistered(requests, rideList);
+    }
+}
+
+void DaemonServicePrivate::slotRealTimeSuggestedLinesRegistered(const QString &request,
+                                                                const QList<PT2::Line> &suggestedLineList)
+{
+    Q_Q(DaemonService);
+    if (isRevalidating(request)) {
+        return;
+    }
+
+    QStringList requests = takeRequests(request);
+    if (!requests.isEmpty()) {
+        emit q->realTimeSuggestedLinesRegistered(requests, suggestedLineList);
+    }
+}
+
+////// End of private class //////
+
+DaemonService::DaemonService(AbstractBackendManager *backendManager,
+                             BackendListManager *backendListManager, QObject *parent):
+    QObject(parent), d_ptr(new DaemonServicePrivate(this))
+{
+    Q_D(DaemonService);
+    registerDBusTypes();
+    new DaemonAdaptor(this);
+
+    d->backendManager = backendManager;
+    d->backendListManager = backendListManager;
+
+    foreach (AbstractBackendWrapper *backend, backendManager->backends()) {
+        d->slotBackendAdded(backend->identifier(), backend);
+    }
+    connect(backendManager, &AbstractBackendManager::backendAdded,
+            d, &DaemonServicePrivate::slotBackendAdded);
+    if (backendListManager) {
+        connect(backendListManager, &BackendListManager::loadingChanged,
+                d, &DaemonServicePrivate::slotLoadingChanged);
+    }
+}
+
+DaemonService::~DaemonService()
+{
+    QDBusConnection::sessionBus().unregisterService(DBUS_DAEMON_SERVICE);
+    QDBusConnection::sessionBus().unregisterObject(DBUS_DAEMON_PATH);
+}
+
+bool DaemonService::registerDBusService()
+{
+    if (!QDBusConnection::sessionBus().registerObject(DBUS_DAEMON_PATH, this)) {
+        warning("daemon-service") << "Failed to register object on path" << DBUS_DAEMON_PATH;
+        return false;
+    }
+
+    return QDBusConnection::sessionBus().registerService(DBUS_DAEMON_SERVICE);
+}
+
+QStringList DaemonService::backends() const
+{
+    Q_D(const DaemonService);
+    return d->backendManager->identifiers();
+}
+
+QVariantMap DaemonService::backendProperties(const QString &identifier) const
+{
+    Q_D(const DaemonService);
+    AbstractBackendWrapper *backend = d->backendManager->backend(identifier);
+    if (!backend) {
+        return QVariantMap();
+    }
+    return DaemonServicePrivate::properties(backend);
+}
+
+bool DaemonService::launchBackend(const QString &identifier)
+{
+    Q_D(DaemonService);
+    if (!d->backendManager->contains(identifier) && !d->addBackend(identifier)) {
+        if (d->backendListManager && d->backendListManager->isLoading()) {
+            debug("daemon-service") << "Backend" << identifier
+                                    << "will be launched when the backend list is loaded";
+            d->pendingLaunches.insert(identifier);
+            return true;
+        }
+        return false;
+    }
+
+    AbstractBackendWrapper *backend = d->backendManager->backend(identifier);
+    if (backend->status() == AbstractBackendWrapper::Launching
+        || backend->status() == AbstractBackendWrapper::Launched) {
+        return true;
+    }
+
+    debug("daemon-service") << "Launching" << identifier;
+    return d->backendManager->launchBackend(identifier);
+}
+
+void DaemonService::requestRealTimeSuggestedStations(const QString &identifier,
+                                                     const QString &request,
+                                                     const QString &partialStation)
+{
+    Q_D(DaemonService);
+    QString key = DaemonServicePrivate::requestKey(identifier,
+                                                   AbstractBackendWrapper::RealTime_SuggestStationFromStringType,
+                                                   partialStation);
+    if (d->multiplex(key, request)) {
+        return;
+    }
+
+    AbstractBackendWrapper *backend = d->availableBackend(identifier, request);
+    if (!backend) {
+        return;
+    }
+
+    d->addRequest(key, backend->requestRealTimeSuggestedStations(partialStation), request);
+}
+
+void DaemonService::requestRealTimeRidesFromStation(const QString &identifier,
+                                                    const QString &request,
+                                                    const Station &station)
+{
+    Q_D(DaemonService);
+    QString key = DaemonServicePrivate::requestKey(identifier,
+                                                   AbstractBackendWrapper::RealTime_RidesFromStationType,
+                                                   station.identifier());
+    if (d->multiplex(key, request)) {
+        return;
+    }
+
+    AbstractBackendWrapper *backend = d->availableBackend(identifier, request);
+    if (!backend) {
+        return;
+    }
+
+    d->addRequest(key, backend->requestPrefetchedRealTimeRidesFromStation(station), request);
+}
+
+void DaemonService::requestRealTimeSuggestedLines(const QString &identifier,
+                                                  const QString &request,
+                                                  const QString &partialLine)
+{
+    Q_D(DaemonService);
+    QString key = DaemonServicePrivate::requestKey(identifier,
+                                                   AbstractBackendWrapper::RealTime_SuggestLineFromStringType,
+                                                   partialLine);
+    if (d->multiplex(key, request)) {
+        return;
+    }
+
+    AbstractBackendWrapper *backend = d->availableBackend(identifier, request);
+    if (!backend) {
+        return;
+    }
+
+    d->addRequest(key, backend->requestRealTimeSuggestedLines(partialLine), request);
+}
+
+}
+
+#include "daemonservice.moc"
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef PT2_DAEMONSERVICE_H
+#define PT2_DAEMONSERVICE_H
+
+/**
+ * @file daemonservice.h
+ * @short Definition of PT2::DaemonService
+ */
+
+#include "pt2_global.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QVariantMap>
+
+namespace PT2
+{
+
+class AbstractBackendManager;
+class BackendListManager;
+class CompanyNodeData;
+class Line;
+class Station;
+class DaemonServicePrivate;
+/**
+ * @brief DBus service of the pt2 daemon
+ *
+ * This class exposes the backends of a backend manager to
+ * other processes through DBus, so that many client applications
+ * can share the same backends, and the results they cache. It is
+ * used by the pt2-daemon, and the clients are implemented with
+ * PT2::DaemonBackendManager.
+ *
+ * Requests are sent by the clients with a request identifier that
+ * they created. Requests from different clients for the same data,
+ * that are a request of the same type, to the same backend, and with
+ * the same argument, are multiplexed: only one request is sent to the
+ * backend, and the reply is broadcasted once, with the identifiers of
+ * all the client requests.
+ *
+ * Backends that are not managed yet are added from the backend
+ * list manager when a client launches them.
+ *
+ * Stale results that are being revalidated by a backend are not
+ * broadcasted: clients only receive the answer of the backend.
+ */
+class PT2_EXPORT DaemonService : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Default constructor
+     * @param backendManager backend manager that owns the backends.
+     * @param backendListManager backend list manager used to find backends.
+     * @param parent parent object.
+     */
+    explicit DaemonService(AbstractBackendManager *backendManager,
+                           BackendListManager *backendListManager, QObject *parent = 0);
+    /**
+     * @brief Destructor
+     */
+    virtual ~DaemonService();
+    /**
+     * @brief Register DBus service
+     *
+     * This method registers this object on DBUS_DAEMON_PATH, and
+     * the DBUS_DAEMON_SERVICE service.
+     *
+     * @return if the service was successfully registered.
+     */
+    bool registerDBusService();
+public Q_SLOTS:
+    /**
+     * @brief Backends
+     * @return identifiers of the managed backends.
+     */
+    QStringList backends() const;
+    /**
+     * @brief Backend properties
+     *
+     * The properties are the status, the last error, the capabilities
+     * and the copyright of the backend, with the keys defined in
+     * @ref dbusconstants.h. They are empty for an unknown backend.
+     *
+     * @param identifier identifier of the backend.
+     * @return properties of the backend.
+     */
+    QVariantMap backendProperties(const QString &identifier) const;
+    /**
+     * @brief Launch a backend
+     *
+     * Nothing is done if the backend is already launching or launched.
+     * If the backend list is being loaded, the backend is launched once
+     * it is loaded.
+     *
+     * @param identifier identifier of the backend.
+     * @return if the backend is known, and is being launched.
+     */
+    bool launchBackend(const QString &identifier);
+    /**
+     * @brief Request suggested stations for real time information
+     * @param identifier identifier of the backend.
+     * @param request client request identifier.
+     * @param partialStation partial station name.
+     */
+    void requestRealTimeSuggestedStations(const QString &identifier, const QString &request,
+                                          const QString &partialStation);
+    /**
+     * @brief Request rides from station for real time information
+     *
+     * Rides that were prefetched by the backend are used if
+     * they are available.
+     *
+     * @param identifier identifier of the backend.
+     * @param request client request identifier.
+     * @param station station.
+     */
+    void requestRealTimeRidesFromStation(const QString &identifier, const QString &request,
+                                         const PT2::Station &station);
+    /**
+     * @brief Request suggested lines for real time information
+     * @param identifier identifier of the backend.
+     * @param request client request identifier.
+     * @param partialLine partial line name.
+     */
+    void requestRealTimeSuggestedLines(const QString &identifier, const QString &request,
+                                       const QString &partialLine);
+Q_SIGNALS:
+    /**
+     * @brief Backend properties changed
+     * @param identifier identifier of the backend.
+     * @param properties properties of the backend.
+     */
+    void backendPropertiesChanged(const QString &identifier, const QVariantMap &properties);
+    /**
+     * @brief Error registered
+     * @param requests client request identifiers.
+     * @param errorId a predefined string that provides the error category.
+     * @param error a human-readable string describing the error.
+     */
+    void errorRegistered(const QStringList &requests, const QString &errorId,
+                         const QString &error);
+    /**
+     * @brief Suggested stations registered for real time information
+     * @param requests client request identifiers.
+     * @param suggestedStationList suggested station list.
+     */
+    void realTimeSuggestedStationsRegistered(const QStringList &requests,
+                                             const QList<PT2::Station> &suggestedStationList);
+    /**
+     * @brief Rides from station registered for real time information
+     * @param requests client request identifiers.
+     * @param rideList ride list.
+     */
+    void realTimeRidesFromStationRegistered(const QStringList &requests,
+                                            const QList<PT2::CompanyNodeData> &rideList);
+    /**
+     * @brief Suggested lines registered for real time information
+     * @param requests client request identifiers.
+     * @param suggestedLineList suggested line list.
+     */
+    void realTimeSuggestedLinesRegistered(const QStringList &requests,
+                                          const QList<PT2::Line> &suggestedLineList);
+protected:
+    /**
+     * @brief D-pointer
+     */
+    QScopedPointer<DaemonServicePrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(DaemonService)
+};
+
+}
+
+#endif // PT2_DAEMONSERVICE_H
@@ -3,13 +3,18 @@ system($$PWD/run-dbusxml2cpp.sh $$[QT_INSTALL_BINS])
 HEADERS += $$PWD/dbusconstants.h \
     $$PWD/dbushelper.h \
     $$PWD/generated/dbusbackendwrapperadaptor.h \
-    $$PWD/generated/backenddbusproxy.h
+    $$PWD/generated/backenddbusproxy.h \
+    $$PWD/generated/daemonserviceadaptor.h \
+    $$PWD/generated/daemondbusproxy.h
 
 SOURCES += $$PWD/dbushelper.cpp \
     $$PWD/generated/dbusbackendwrapperadaptor.cpp \
-    $$PWD/generated/backenddbusproxy.cpp
+    $$PWD/generated/backenddbusproxy.cpp \
+    $$PWD/generated/daemonserviceadaptor.cpp \
+    $$PWD/generated/daemondbusproxy.cpp
 
-OTHER_FILES += dbus-backend.xml
+OTHER_FILES += dbus-backend.xml \
+    dbus-daemon.xml
 
 dbus_headers.files = $$PWD/*.h
 dbus_headers.path = $${INCLUDEDIR}/dbus
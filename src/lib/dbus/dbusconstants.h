@@ -50,5 +50,41 @@
  * Prefix for DBus path that points to backends
  */
 #define DBUS_BACKEND_PATH_PREFIX "/backend/"
+/**
+ * @short DBUS_DAEMON_SERVICE
+ *
+ * DBus service name of the daemon
+ */
+#define DBUS_DAEMON_SERVICE "org.SfietKonstantin.pt2.daemon"
+/**
+ * @short DBUS_DAEMON_PATH
+ *
+ * DBus path that points to the daemon service
+ */
+#define DBUS_DAEMON_PATH "/daemon"
+/**
+ * @short DBUS_DAEMON_STATUS_PROPERTY
+ *
+ * Key of the status in the backend properties sent by the daemon
+ */
+#define DBUS_DAEMON_STATUS_PROPERTY "status"
+/**
+ * @short DBUS_DAEMON_LAST_ERROR_PROPERTY
+ *
+ * Key of the last error in the backend properties sent by the daemon
+ */
+#define DBUS_DAEMON_LAST_ERROR_PROPERTY "lastError"
+/**
+ * @short DBUS_DAEMON_CAPABILITIES_PROPERTY
+ *
+ * Key of the capabilities in the backend properties sent by the daemon
+ */
+#define DBUS_DAEMON_CAPABILITIES_PROPERTY "capabilities"
+/**
+ * @short DBUS_DAEMON_COPYRIGHT_PROPERTY
+ *
+ * Key of the copyright in the backend properties sent by the daemon
+ */
+#define DBUS_DAEMON_COPYRIGHT_PROPERTY "copyright"
 
 #endif // PT2_DBUSSERVICECONSTANTS_H
@@ -15,3 +15,8 @@ $XMLTOCPP -a dbusbackendwrapperadaptor -i manager/dbusbackendwrapper.h -i base/s
 $XMLTOCPP -p backenddbusproxy -i base/company.h -i base/line.h -i base/ride.h -i base/station.h \
           -i base/companynodedata.h \
           ../dbus-backend.xml
+$XMLTOCPP -a daemonserviceadaptor -i daemon/daemonservice.h -i base/station.h \
+          -l PT2::DaemonService ../dbus-daemon.xml
+$XMLTOCPP -p daemondbusproxy -i base/company.h -i base/line.h -i base/ride.h -i base/station.h \
+          -i base/companynodedata.h \
+          ../dbus-daemon.xml
@@ -70,6 +70,17 @@
  * to understand why there is a failure in an operation.
  */
 #define ERROR_BACKEND_WARNING "error:backend_warning"
+/**
+ * @short ERROR_BACKEND_NOT_LAUNCHED
+ *
+ * The error is sent when a request was queued while the
+ * backend was launched on demand, but the backend failed
+ * to launch.
+ *
+ * This error is displayed in a GUI, in order to help the user
+ * to understand why there is a failure in an operation.
+ */
+#define ERROR_BACKEND_NOT_LAUNCHED "error:backend_not_launched"
 /**
  * @short ERROR_OTHER
  *
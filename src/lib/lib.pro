@@ -2,7 +2,8 @@ include(../../common.pri)
 
 TEMPLATE = lib
 CONFIG += qt create_prl no_install_prl create_pc
-QT = core dbus
+CONFIG(staticprovider): CONFIG += staticlib
+QT = core dbus concurrent
 
 DEFINES += PT2_LIBRARY
 
@@ -23,7 +24,8 @@ target.path = $${LIBDIR}
 HEADERS += pt2_global.h \
     debug.h \
     errorid.h \
-    capabilitiesconstants.h
+    capabilitiesconstants.h \
+    normalization.h
 
 QMAKE_PKGCONFIG_NAME = lib$$TARGET
 QMAKE_PKGCONFIG_DESCRIPTION = Public transportation 2 development files
@@ -41,3 +43,4 @@ include(base/base.pri)
 include(dbus/dbus.pri)
 include(manager/manager.pri)
 include(provider/provider.pri)
+include(daemon/daemon.pri)
@@ -37,14 +37,61 @@
 #include "abstractbackendmanager.h"
 
 #include <QtCore/QMap>
+#include <QtCore/QDataStream>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QSettings>
+#include <QtCore/QStandardPaths>
 
 #include "abstractbackendwrapper.h"
+#include "backendinfo.h"
+#include "resultcache.h"
 #include "debug.h"
 
 namespace PT2
 {
 
+/**
+ * @internal
+ * @brief Default time after which an idle backend is stopped, in milliseconds
+ */
+static const int DEFAULT_IDLE_TIMEOUT = 300000;
+/**
+ * @internal
+ * @brief City used by backends that cover a whole country
+ */
+static const char *ALL_CITIES = "all";
+/**
+ * @internal
+ * @brief Settings group containing the enabled backends
+ */
+static const char *ENABLED_BACKENDS_GROUP = "enabled";
+
+/**
+ * @internal
+ * @brief Path to the settings file
+ * @return path to the settings file.
+ */
+static QString settingsFile()
+{
+    QDir dir (QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation));
+    return dir.absoluteFilePath("pt2/backends.conf");
+}
+
+/**
+ * @internal
+ * @brief Key used to index the backends by city
+ * @param country country code.
+ * @param city city.
+ * @return key.
+ */
+static QString cityKey(const QString &country, const QString &city)
+{
+    return country.trimmed().toUpper() + "/" + city.trimmed().toLower();
+}
+
 /**
  * @internal
  * @brief Private class for PT2::AbstractBackendManager
@@ -56,6 +103,56 @@ struct AbstractBackendManagerPrivate
      * @brief Backends
      */
     QMap<QString, AbstractBackendWrapper *> backends;
+    /**
+     * @internal
+     * @brief Idle timeout
+     */
+    int idleTimeout;
+    /**
+     * @internal
+     * @brief If the result cache is enabled
+     */
+    bool resultCacheEnabled;
+    /**
+     * @internal
+     * @brief Backends that do not have a country
+     */
+    QSet<QString> internationalBackends;
+    /**
+     * @internal
+     * @brief Backends, by country
+     */
+    QHash<QString, QSet<QString> > countryBackends;
+    /**
+     * @internal
+     * @brief Backends covering a whole country, by country
+     */
+    QHash<QString, QSet<QString> > nationalBackends;
+    /**
+     * @internal
+     * @brief Backends, by city key
+     */
+    QHash<QString, QSet<QString> > cityBackends;
+    /**
+     * @internal
+     * @brief Timer started when the enabled backends are started
+     */
+    QElapsedTimer startupTimer;
+    /**
+     * @internal
+     * @brief Startup timeline
+     */
+    QList<QPair<QString, qint64> > startupTimeline;
+    /**
+     * @internal
+     * @brief Enabled backends that are being started
+     */
+    QSet<QString> startingBackends;
+    /**
+     * @internal
+     * @brief If an enabled backend was launched
+     */
+    bool firstBackendLaunched;
 };
 
 ////// End of private class //////
@@ -63,6 +160,10 @@ struct AbstractBackendManagerPrivate
 AbstractBackendManager::AbstractBackendManager(QObject *parent):
     QObject(parent), d_ptr(new AbstractBackendManagerPrivate)
 {
+    Q_D(AbstractBackendManager);
+    d->idleTimeout = DEFAULT_IDLE_TIMEOUT;
+    d->resultCacheEnabled = true;
+    d->firstBackendLaunched = false;
 }
 
 AbstractBackendManager::~AbstractBackendManager()
@@ -106,6 +207,120 @@ QList<AbstractBackendWrapper *> AbstractBackendManager::backends() const
     return wrappers;
 }
 
+QList<AbstractBackendWrapper *> AbstractBackendManager::availableBackends(const QString &country,
+                                                                          const QString &city) const
+{
+    Q_D(const AbstractBackendManager);
+    if (country.trimmed().isEmpty()) {
+        return availableBackends();
+    }
+
+    QString countryCode = country.trimmed().toUpper();
+    QSet<QString> identifiers = d->internationalBackends;
+    if (city.trimmed().isEmpty()) {
+        identifiers.unite(d->countryBackends.value(countryCode));
+    } else {
+        identifiers.unite(d->nationalBackends.value(countryCode));
+        identifiers.unite(d->cityBackends.value(cityKey(countryCode, city)));
+    }
+
+    // Sorted like availableBackends(), by identifier
+    QStringList sortedIdentifiers = identifiers.toList();
+    qSort(sortedIdentifiers);
+
+    QList<AbstractBackendWrapper *> wrappers;
+    foreach (const QString &identifier, sortedIdentifiers) {
+        AbstractBackendWrapper *backend = d->backends.value(identifier, 0);
+        if (!backend) {
+            continue;
+        }
+
+        if (backend->status() == AbstractBackendWrapper::Launched
+            || backend->isLaunchedOnDemand()) {
+            wrappers.append(backend);
+        }
+    }
+
+    return wrappers;
+}
+
+QList<AbstractBackendWrapper *> AbstractBackendManager::availableBackends() const
+{
+    Q_D(const AbstractBackendManager);
+    QList<AbstractBackendWrapper *> wrappers;
+    foreach (AbstractBackendWrapper *backend, d->backends) {
+        if (backend->status() == AbstractBackendWrapper::Launched
+            || backend->isLaunchedOnDemand()) {
+            wrappers.append(backend);
+        }
+    }
+
+    return wrappers;
+}
+
+int AbstractBackendManager::idleTimeout() const
+{
+    Q_D(const AbstractBackendManager);
+    return d->idleTimeout;
+}
+
+void AbstractBackendManager::setIdleTimeout(int idleTimeout)
+{
+    Q_D(AbstractBackendManager);
+    d->idleTimeout = idleTimeout;
+    foreach (AbstractBackendWrapper *backend, d->backends) {
+        backend->setIdleTimeout(idleTimeout);
+    }
+}
+
+bool AbstractBackendManager::isResultCacheEnabled() const
+{
+    Q_D(const AbstractBackendManager);
+    return d->resultCacheEnabled;
+}
+
+void AbstractBackendManager::setResultCacheEnabled(bool resultCacheEnabled)
+{
+    Q_D(AbstractBackendManager);
+    d->resultCacheEnabled = resultCacheEnabled;
+}
+
+QStringList AbstractBackendManager::enabledBackends() const
+{
+    QSettings settings (settingsFile(), QSettings::IniFormat);
+    settings.beginGroup(ENABLED_BACKENDS_GROUP);
+    return settings.childKeys();
+}
+
+void AbstractBackendManager::setBackendEnabled(const BackendInfo &backendInfo, bool enabled)
+{
+    QString identifier = backendInfo.backendIdentifier();
+    if (identifier.isEmpty()) {
+        return;
+    }
+
+    QSettings settings (settingsFile(), QSettings::IniFormat);
+    settings.beginGroup(ENABLED_BACKENDS_GROUP);
+    if (!enabled) {
+        settings.remove(identifier);
+        return;
+    }
+
+    // The backend informations are stored, so that the backend
+    // can be started before the backend list is loaded
+    QByteArray data;
+    QDataStream stream (&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << backendInfo;
+    settings.setValue(identifier, data);
+}
+
+QList<QPair<QString, qint64> > AbstractBackendManager::startupTimeline() const
+{
+    Q_D(const AbstractBackendManager);
+    return d->startupTimeline;
+}
+
 void AbstractBackendManager::addBackend(const QString &identifier, const QString &executable,
                                         const QMap<QString, QString> &attributes)
 {
@@ -113,8 +328,56 @@ void AbstractBackendManager::addBackend(const QString &identifier, const QString
 
     AbstractBackendWrapper *backendWrapper = createBackend(identifier, executable,
                                                            attributes, this);
+    backendWrapper->setIdleTimeout(d->idleTimeout);
+    if (d->resultCacheEnabled) {
+        backendWrapper->setResultCache(new ResultCache(identifier));
+    }
+    d->backends.insert(identifier, backendWrapper);
+    d->internationalBackends.insert(identifier);
+
+    emit backendAdded(identifier, backendWrapper);
+}
+
+void AbstractBackendManager::addBackend(const BackendInfo &backendInfo)
+{
+    Q_D(AbstractBackendManager);
+    QString identifier = backendInfo.backendIdentifier();
+
+    AbstractBackendWrapper *backendWrapper = createBackend(identifier, backendInfo.executable(),
+                                                           QMap<QString, QString>(), this);
+    backendWrapper->setIdleTimeout(d->idleTimeout);
+    if (d->resultCacheEnabled) {
+        backendWrapper->setResultCache(new ResultCache(identifier));
+    }
+    backendWrapper->setDeclaredCapabilities(backendInfo.capabilities());
     d->backends.insert(identifier, backendWrapper);
 
+    // Index the backend by country and city
+    QString country = backendInfo.backendCountry().trimmed().toUpper();
+    if (country.isEmpty()) {
+        d->internationalBackends.insert(identifier);
+    } else {
+        d->countryBackends[country].insert(identifier);
+        bool national = true;
+        foreach (const QString &city, backendInfo.backendCities()) {
+            if (city.trimmed().isEmpty()) {
+                continue;
+            }
+
+            if (city.trimmed().toLower() == ALL_CITIES) {
+                national = true;
+                break;
+            }
+            national = false;
+            d->cityBackends[cityKey(country, city)].insert(identifier);
+        }
+        if (national) {
+            d->nationalBackends[country].insert(identifier);
+        }
+    }
+
+    debug("abs-backend-manager") << "Added" << identifier << "with declared capabilities"
+                                 << backendInfo.capabilities();
     emit backendAdded(identifier, backendWrapper);
 }
 
@@ -160,6 +423,17 @@ bool AbstractBackendManager::removeBackend(const QString &identifier)
     }
 
     d->backends.remove(identifier);
+    d->internationalBackends.remove(identifier);
+    QHash<QString, QSet<QString> >::iterator i;
+    for (i = d->countryBackends.begin(); i != d->countryBackends.end(); ++i) {
+        i.value().remove(identifier);
+    }
+    for (i = d->nationalBackends.begin(); i != d->nationalBackends.end(); ++i) {
+        i.value().remove(identifier);
+    }
+    for (i = d->cityBackends.begin(); i != d->cityBackends.end(); ++i) {
+        i.value().remove(identifier);
+    }
     removedBackend->deleteLater();
 
     emit backendRemoved(identifier);
@@ -167,4 +441,86 @@ bool AbstractBackendManager::removeBackend(const QString &identifier)
     return true;
 }
 
+void AbstractBackendManager::startEnabledBackends()
+{
+    Q_D(AbstractBackendManager);
+    d->startupTimer.start();
+    d->startupTimeline.clear();
+    d->startupTimeline.append(qMakePair(QString("start"), qint64(0)));
+    d->firstBackendLaunched = false;
+
+    QSettings settings (settingsFile(), QSettings::IniFormat);
+    settings.beginGroup(ENABLED_BACKENDS_GROUP);
+    foreach (const QString &identifier, settings.childKeys()) {
+        if (contains(identifier)) {
+            continue;
+        }
+
+        QDataStream stream (settings.value(identifier).toByteArray());
+        stream.setVersion(QDataStream::Qt_5_0);
+        BackendInfo backendInfo;
+        stream >> backendInfo;
+        if (stream.status() != QDataStream::Ok || !backendInfo.isValid()
+            || backendInfo.backendIdentifier() != identifier) {
+            warning("abs-backend-manager") << "Ignoring invalid enabled backend" << identifier;
+            continue;
+        }
+
+        // Backends are not waited for, so that they are all
+        // launching at the same time
+        addBackend(backendInfo);
+        AbstractBackendWrapper *startedBackend = backend(identifier);
+        connect(startedBackend, &AbstractBackendWrapper::statusChanged,
+                this, &AbstractBackendManager::slotStartupStatusChanged);
+        d->startingBackends.insert(identifier);
+        d->startupTimeline.append(qMakePair(QString("launch:%1").arg(identifier),
+                                            d->startupTimer.elapsed()));
+        startedBackend->launch();
+    }
+
+    debug("abs-backend-manager") << "Launching" << d->startingBackends.count()
+                                 << "enabled backends took" << d->startupTimer.elapsed() << "ms";
+    if (d->startingBackends.isEmpty()) {
+        d->startupTimeline.append(qMakePair(QString("finished"), d->startupTimer.elapsed()));
+    }
+    emit startupTimelineChanged();
+}
+
+void AbstractBackendManager::slotStartupStatusChanged()
+{
+    Q_D(AbstractBackendManager);
+    AbstractBackendWrapper *startedBackend = qobject_cast<AbstractBackendWrapper *>(sender());
+    if (!startedBackend || !d->startingBackends.contains(startedBackend->identifier())) {
+        return;
+    }
+
+    QString identifier = startedBackend->identifier();
+    qint64 elapsed = d->startupTimer.elapsed();
+    switch (startedBackend->status()) {
+    case AbstractBackendWrapper::Launching:
+        return;
+        break;
+    case AbstractBackendWrapper::Launched:
+        d->startupTimeline.append(qMakePair(QString("launched:%1").arg(identifier), elapsed));
+        debug("abs-backend-manager") << identifier << "launched after" << elapsed << "ms";
+        if (!d->firstBackendLaunched) {
+            d->firstBackendLaunched = true;
+            d->startupTimeline.append(qMakePair(QString("first-launched"), elapsed));
+        }
+        break;
+    default:
+        d->startupTimeline.append(qMakePair(QString("failed:%1").arg(identifier), elapsed));
+        break;
+    }
+
+    disconnect(startedBackend, &AbstractBackendWrapper::statusChanged,
+               this, &AbstractBackendManager::slotStartupStatusChanged);
+    d->startingBackends.remove(identifier);
+    if (d->startingBackends.isEmpty()) {
+        d->startupTimeline.append(qMakePair(QString("finished"), elapsed));
+        debug("abs-backend-manager") << "Enabled backends started in" << elapsed << "ms";
+    }
+    emit startupTimelineChanged();
+}
+
 }
@@ -40,12 +40,14 @@
 #include "pt2_global.h"
 
 #include <QtCore/QObject>
+#include <QtCore/QPair>
 #include <QtCore/QStringList>
 
 namespace PT2
 {
 
 class AbstractBackendWrapper;
+class BackendInfo;
 class AbstractBackendManagerPrivate;
 /**
  * @brief Base class for a backend manager
@@ -63,6 +65,36 @@ class AbstractBackendManagerPrivate;
  * Backend managers are created by implementing createBackend().
  * This method is used to create the correct backend that this
  * class will manage.
+ *
+ * @section lazyLaunch Launching backends on demand
+ *
+ * Backends added from a PT2::BackendInfo that declares capabilities
+ * are launched on demand: they are launched when the first request
+ * is performed, and stopped after being idle for idleTimeout()
+ * milliseconds. availableBackends() lists these backends, as well
+ * as the launched backends.
+ *
+ * @section routing Routing requests by region
+ *
+ * Backends added from a PT2::BackendInfo are indexed by country
+ * and city, so that availableBackends(const QString &, const QString &)
+ * only returns the backends that cover a given region. Backends
+ * without a country are international, and backends whose cities
+ * are "All" cover their whole country: they always match.
+ *
+ * @section startup Starting enabled backends
+ *
+ * The backends enabled with setBackendEnabled() are persisted, and
+ * startEnabledBackends() launches all of them at once, without waiting
+ * for one backend to be launched before launching the next one. The
+ * time taken by each backend to be launched is recorded in
+ * startupTimeline().
+ *
+ * @section cache Caching results
+ *
+ * When isResultCacheEnabled() is true, each added backend is given
+ * a PT2::ResultCache, so that the results of its requests are
+ * stored on disk and reused across sessions.
  */
 class PT2_EXPORT AbstractBackendManager: public QObject
 {
@@ -115,6 +147,88 @@ public:
      * @return a list of all the backends.
      */
     QList<AbstractBackendWrapper *> backends() const;
+    /**
+     * @brief Available backends
+     *
+     * This method is used to get a list of the backends that
+     * can answer to requests, that are the launched backends, and
+     * the backends that are launched on demand.
+     *
+     * @return a list of the available backends.
+     */
+    QList<AbstractBackendWrapper *> availableBackends() const;
+    /**
+     * @brief Available backends in a region
+     *
+     * This method is used to get a list of the available backends
+     * that cover a region. If the country is empty, all the available
+     * backends are returned. If the city is empty, all the backends of
+     * the country are returned.
+     *
+     * @param country country code.
+     * @param city city.
+     * @return a list of the available backends in the region.
+     */
+    QList<AbstractBackendWrapper *> availableBackends(const QString &country,
+                                                      const QString &city = QString()) const;
+    /**
+     * @brief Idle timeout
+     *
+     * Backends that are launched on demand are stopped when they
+     * did not receive any request during this duration.
+     *
+     * @return idle timeout, in milliseconds.
+     */
+    int idleTimeout() const;
+    /**
+     * @brief Set idle timeout
+     *
+     * The idle timeout is applied to all the managed backends.
+     *
+     * @param idleTimeout idle timeout, in milliseconds.
+     */
+    void setIdleTimeout(int idleTimeout);
+    /**
+     * @brief If the result cache is enabled
+     *
+     * By default, the result cache is enabled. Changing this
+     * property only affects the backends added later.
+     *
+     * @return if the result cache is enabled.
+     */
+    bool isResultCacheEnabled() const;
+    /**
+     * @brief Set if the result cache is enabled
+     * @param resultCacheEnabled if the result cache is enabled.
+     */
+    void setResultCacheEnabled(bool resultCacheEnabled);
+    /**
+     * @brief Enabled backends
+     * @return identifiers of the enabled backends.
+     */
+    QStringList enabledBackends() const;
+    /**
+     * @brief Set if a backend is enabled
+     *
+     * Enabled backends are persisted, and are launched by
+     * startEnabledBackends().
+     *
+     * @param backendInfo backend informations.
+     * @param enabled if the backend is enabled.
+     */
+    void setBackendEnabled(const BackendInfo &backendInfo, bool enabled);
+    /**
+     * @brief Startup timeline
+     *
+     * The timeline contains events, with the time since
+     * startEnabledBackends() was called, in milliseconds. Events are
+     * "start", "launch:<identifier>", "launched:<identifier>",
+     * "failed:<identifier>", "first-launched", and "finished" when
+     * all the enabled backends are either launched or failed.
+     *
+     * @return startup timeline.
+     */
+    QList<QPair<QString, qint64> > startupTimeline() const;
     /**
      * @brief Add a backend
      *
@@ -124,6 +238,15 @@ public:
      */
     void addBackend(const QString &identifier, const QString &executable,
                     const QMap<QString, QString> &attributes);
+    /**
+     * @brief Add a backend from its informations
+     *
+     * If the backend declares its capabilities, it is not launched
+     * immediately, but when the first request is performed.
+     *
+     * @param backendInfo backend informations.
+     */
+    void addBackend(const BackendInfo &backendInfo);
     /**
      * @brief Launch a backend
      * @param identifier identifier.
@@ -151,6 +274,14 @@ public:
      * @return if the remove is successful.
      */
     bool removeBackend(const QString &identifier);
+public Q_SLOTS:
+    /**
+     * @brief Start enabled backends
+     *
+     * All the enabled backends that are not managed yet are
+     * added and launched concurrently.
+     */
+    void startEnabledBackends();
 Q_SIGNALS:
     /**
      * @brief Backend added
@@ -163,6 +294,10 @@ Q_SIGNALS:
      * @param identifier identifier.
      */
     void backendRemoved(const QString &identifier);
+    /**
+     * @brief Startup timeline changed
+     */
+    void startupTimelineChanged();
 protected:
     /**
      * @brief Create a backend
@@ -182,6 +317,11 @@ protected:
     QScopedPointer<AbstractBackendManagerPrivate> d_ptr;
 private:
     Q_DECLARE_PRIVATE(AbstractBackendManager)
+private Q_SLOTS:
+    /**
+     * @brief Slot used to record the startup of the enabled backends
+     */
+    void slotStartupStatusChanged();
 
 };
 
@@ -37,21 +37,57 @@
 #include "abstractbackendwrapper.h"
 #include "abstractbackendwrapper_p.h"
 
+#include <QtCore/QTimer>
 #include <QtCore/QUuid>
 
 #include "debug.h"
 #include "errorid.h"
 #include "base/company.h"
+#include "base/companynodedata.h"
 #include "base/line.h"
 #include "base/ride.h"
 #include "base/station.h"
+#include "manager/resultcache.h"
 
 namespace PT2
 {
 
+/**
+ * @internal
+ * @brief Time during which prefetched rides can be used, in milliseconds
+ */
+static const int PREFETCH_TIMEOUT = 30000;
+/**
+ * @internal
+ * @brief Default time after which an idle backend is stopped, in milliseconds
+ */
+static const int DEFAULT_IDLE_TIMEOUT = 300000;
+
 AbstractBackendWrapperPrivate::AbstractBackendWrapperPrivate()
 {
      status = AbstractBackendWrapper::Stopped;
+     launchOnDemand = false;
+     idleTimeout = DEFAULT_IDLE_TIMEOUT;
+     idleTimer = 0;
+     resultCache = 0;
+}
+
+void AbstractBackendWrapperPrivate::pruneExpiredPrefetchedRides()
+{
+    QSet<QString> usedIdentifiers;
+    QList<QPair<QString, QString> >::const_iterator i;
+    for (i = prefetchHits.constBegin(); i != prefetchHits.constEnd(); ++i) {
+        usedIdentifiers.insert(i->second);
+    }
+
+    QHash<QString, PrefetchedRides>::iterator j = prefetchedRides.begin();
+    while (j != prefetchedRides.end()) {
+        if (j.value().timer.hasExpired(PREFETCH_TIMEOUT) && !usedIdentifiers.contains(j.key())) {
+            j = prefetchedRides.erase(j);
+        } else {
+            ++j;
+        }
+    }
 }
 
 ////// End of private class //////
@@ -75,6 +111,8 @@ AbstractBackendWrapper::AbstractBackendWrapper(AbstractBackendWrapperPrivate &dd
 
 AbstractBackendWrapper::~AbstractBackendWrapper()
 {
+    Q_D(AbstractBackendWrapper);
+    delete d->resultCache;
 }
 
 QString AbstractBackendWrapper::identifier() const
@@ -107,6 +145,60 @@ QString AbstractBackendWrapper::copyright() const
     return d->copyright;
 }
 
+bool AbstractBackendWrapper::isLaunchedOnDemand() const
+{
+    Q_D(const AbstractBackendWrapper);
+    return d->launchOnDemand;
+}
+
+void AbstractBackendWrapper::setDeclaredCapabilities(const QStringList &capabilities)
+{
+    Q_D(AbstractBackendWrapper);
+    d->launchOnDemand = !capabilities.isEmpty();
+    if (d->status != Launched && d->capabilities != capabilities) {
+        d->capabilities = capabilities;
+        emit capabilitiesChanged();
+
+        debug("abs-backend-wrapper") << "Declared capabilities" << capabilities;
+    }
+}
+
+int AbstractBackendWrapper::idleTimeout() const
+{
+    Q_D(const AbstractBackendWrapper);
+    return d->idleTimeout;
+}
+
+void AbstractBackendWrapper::setIdleTimeout(int idleTimeout)
+{
+    Q_D(AbstractBackendWrapper);
+    d->idleTimeout = idleTimeout;
+    if (d->idleTimer && idleTimeout <= 0) {
+        d->idleTimer->stop();
+    }
+}
+
+ResultCache * AbstractBackendWrapper::resultCache() const
+{
+    Q_D(const AbstractBackendWrapper);
+    return d->resultCache;
+}
+
+void AbstractBackendWrapper::setResultCache(ResultCache *resultCache)
+{
+    Q_D(AbstractBackendWrapper);
+    if (d->resultCache != resultCache) {
+        delete d->resultCache;
+        d->resultCache = resultCache;
+    }
+}
+
+bool AbstractBackendWrapper::isRevalidating(const QString &request) const
+{
+    Q_D(const AbstractBackendWrapper);
+    return d->revalidatingRequests.contains(request);
+}
+
 void AbstractBackendWrapper::waitForStopped()
 {
 }
@@ -120,11 +212,80 @@ void AbstractBackendWrapper::registerError(const QString &request, const QString
         debug("abs-backend-wrapper") << errorId;
         debug("abs-backend-wrapper") << error;
 
+        // Requests waiting for a failed prefetch fail too
+        d->prefetchRequests.remove(request);
+        foreach (const QString &waitingRequest, d->waitingRequests.take(request)) {
+            registerError(waitingRequest, errorId, error);
+        }
+
+        d->cacheKeys.remove(request);
+        d->revalidatingRequests.remove(request);
         delete d->requests.take(request);
         emit errorRegistered(request, errorId, error);
     }
 }
 
+void AbstractBackendWrapper::prefetchRealTimeRidesFromStation(const PT2::Station &station)
+{
+    Q_D(AbstractBackendWrapper);
+    QString identifier = station.identifier();
+    if (d->prefetchRequests.values().contains(identifier)) {
+        return;
+    }
+
+    d->pruneExpiredPrefetchedRides();
+    if (d->prefetchedRides.contains(identifier)
+        && !d->prefetchedRides.value(identifier).timer.hasExpired(PREFETCH_TIMEOUT)) {
+        return;
+    }
+
+    debug("abs-backend-wrapper") << "Prefetching rides from" << station.name();
+    QString request = requestRealTimeRidesFromStation(station);
+    d->prefetchRequests.insert(request, identifier);
+}
+
+QString AbstractBackendWrapper::requestPrefetchedRealTimeRidesFromStation(const PT2::Station &station)
+{
+    Q_D(AbstractBackendWrapper);
+    QString identifier = station.identifier();
+    if (d->prefetchedRides.contains(identifier)) {
+        if (!d->prefetchedRides.value(identifier).timer.hasExpired(PREFETCH_TIMEOUT)) {
+            debug("abs-backend-wrapper") << "Using prefetched rides from" << station.name();
+            QString request = createRequest(RealTime_RidesFromStationType);
+            d->prefetchHits.append(qMakePair(request, identifier));
+            QTimer::singleShot(0, this, SLOT(slotRegisterPrefetchHits()));
+            return request;
+        }
+        d->prefetchedRides.remove(identifier);
+    }
+
+    QString prefetchRequest = d->prefetchRequests.key(identifier);
+    if (!prefetchRequest.isEmpty()) {
+        debug("abs-backend-wrapper") << "Waiting for prefetched rides from" << station.name();
+        QString request = createRequest(RealTime_RidesFromStationType);
+        d->waitingRequests[prefetchRequest].append(request);
+        return request;
+    }
+
+    return requestRealTimeRidesFromStation(station);
+}
+
+void AbstractBackendWrapper::cancelPrefetches()
+{
+    Q_D(AbstractBackendWrapper);
+    foreach (const QString &request, d->prefetchRequests.keys()) {
+        if (d->waitingRequests.contains(request)) {
+            continue;
+        }
+
+        debug("abs-backend-wrapper") << "Cancelling prefetch" << request;
+        d->prefetchRequests.remove(request);
+        d->cacheKeys.remove(request);
+        delete d->requests.take(request);
+    }
+    d->pruneExpiredPrefetchedRides();
+}
+
 void AbstractBackendWrapper::registerRealTimeSuggestedStations(const QString &request, const QList<PT2::Station> &suggestedStationList)
 {
     Q_D(AbstractBackendWrapper);
@@ -134,6 +295,7 @@ void AbstractBackendWrapper::registerRealTimeSuggestedStations(const QString &re
             return;
         }
 
+        cacheResult(request, QVariant::fromValue(suggestedStationList));
         debug("abs-backend-wrapper") << "Suggested stations registered";
         debug("abs-backend-wrapper") << "Request" << request;
         debug("abs-backend-wrapper") << "list of suggested stations";
@@ -155,6 +317,13 @@ void AbstractBackendWrapper::registerRealTimeRidesFromStation(const QString &req
             return;
         }
 
+        cacheResult(request, QVariant::fromValue(rideList));
+        // Prefetched rides are not relayed
+        if (d->prefetchRequests.contains(request)) {
+            delete d->requests.take(request);
+            registerPrefetchedRides(request, rideList);
+            return;
+        }
         
 
         delete d->requests.take(request);
@@ -171,6 +340,7 @@ void AbstractBackendWrapper::registerRealTimeSuggestedLines(const QString &reque
             return;
         }
 
+        cacheResult(request, QVariant::fromValue(suggestedLineList));
         
 
         delete d->requests.take(request);
@@ -198,6 +368,11 @@ void AbstractBackendWrapper::setStatus(Status status)
         emit statusChanged();
 
         debug("abs-backend-wrapper") << "Status changed to" << d->status;
+
+        if (status == Launched) {
+            restartIdleTimer();
+        }
+        processQueuedRequests();
     }
 }
 
@@ -227,6 +402,158 @@ void AbstractBackendWrapper::setBackendProperties(const QStringList &capabilitie
     }
 }
 
+void AbstractBackendWrapper::registerPrefetchedRides(const QString &request,
+                                                     const QList<PT2::CompanyNodeData> &rideList)
+{
+    Q_D(AbstractBackendWrapper);
+    PrefetchedRides prefetchedRides;
+    prefetchedRides.rideList = rideList;
+    prefetchedRides.timer.start();
+    d->prefetchedRides.insert(d->prefetchRequests.take(request), prefetchedRides);
+
+    foreach (const QString &waitingRequest, d->waitingRequests.take(request)) {
+        registerRealTimeRidesFromStation(waitingRequest, rideList);
+    }
+}
+
+void AbstractBackendWrapper::slotRegisterPrefetchHits()
+{
+    Q_D(AbstractBackendWrapper);
+    while (!d->prefetchHits.isEmpty()) {
+        QPair<QString, QString> hit = d->prefetchHits.takeFirst();
+        registerRealTimeRidesFromStation(hit.first,
+                                         d->prefetchedRides.value(hit.second).rideList);
+    }
+}
+
+void AbstractBackendWrapper::cacheResult(const QString &request, const QVariant &result)
+{
+    Q_D(AbstractBackendWrapper);
+    d->revalidatingRequests.remove(request);
+    if (!d->resultCache || !d->cacheKeys.contains(request)) {
+        return;
+    }
+
+    RequestType requestType = d->requests.value(request)->type;
+    d->resultCache->insert(d->cacheKeys.take(request), requestType, result,
+                           ResultCache::defaultTimeToLive(requestType));
+}
+
+void AbstractBackendWrapper::slotRegisterCacheHits()
+{
+    Q_D(AbstractBackendWrapper);
+    while (!d->cacheHits.isEmpty()) {
+        CacheHit hit = d->cacheHits.takeFirst();
+        if (!d->requests.contains(hit.request)) {
+            continue;
+        }
+
+        RequestType requestType = d->requests.value(hit.request)->type;
+        if (!hit.stale) {
+            switch (requestType) {
+            case RealTime_SuggestStationFromStringType:
+                registerRealTimeSuggestedStations(hit.request, hit.result.value<QList<PT2::Station> >());
+                break;
+            case RealTime_RidesFromStationType:
+                registerRealTimeRidesFromStation(hit.request, hit.result.value<QList<PT2::CompanyNodeData> >());
+                break;
+            case RealTime_SuggestLineFromStringType:
+                registerRealTimeSuggestedLines(hit.request, hit.result.value<QList<PT2::Line> >());
+                break;
+            default:
+                break;
+            }
+            continue;
+        }
+
+        // Stale prefetched rides are not relayed, and
+        // stale results keep the request running
+        if (d->prefetchRequests.contains(hit.request)) {
+            continue;
+        }
+
+        d->revalidatingRequests.insert(hit.request);
+        switch (requestType) {
+        case RealTime_SuggestStationFromStringType:
+            emit realTimeSuggestedStationsRegistered(hit.request, hit.result.value<QList<PT2::Station> >());
+            break;
+        case RealTime_RidesFromStationType:
+            emit realTimeRidesFromStationRegistered(hit.request, hit.result.value<QList<PT2::CompanyNodeData> >());
+            break;
+        case RealTime_SuggestLineFromStringType:
+            emit realTimeSuggestedLinesRegistered(hit.request, hit.result.value<QList<PT2::Line> >());
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void AbstractBackendWrapper::processQueuedRequests()
+{
+    Q_D(AbstractBackendWrapper);
+    if (d->queuedRequests.isEmpty()) {
+        return;
+    }
+
+    switch (d->status) {
+    case Launched:
+        debug("abs-backend-wrapper") << "Sending" << d->queuedRequests.count()
+                                     << "queued requests";
+        while (!d->queuedRequests.isEmpty()) {
+            QPair<QString, QVariantList> queuedRequest = d->queuedRequests.takeFirst();
+            if (d->requests.contains(queuedRequest.first)) {
+                sendQueuedRequest(queuedRequest.first, d->requests.value(queuedRequest.first)->type,
+                                  queuedRequest.second);
+            }
+        }
+        break;
+    case Stopped:
+        // Requests were queued while the backend was stopping
+        QMetaObject::invokeMethod(this, "launch", Qt::QueuedConnection);
+        break;
+    case Invalid:
+        while (!d->queuedRequests.isEmpty()) {
+            registerError(d->queuedRequests.takeFirst().first, ERROR_BACKEND_NOT_LAUNCHED,
+                          d->lastError);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void AbstractBackendWrapper::restartIdleTimer()
+{
+    Q_D(AbstractBackendWrapper);
+    if (!d->launchOnDemand || d->idleTimeout <= 0) {
+        return;
+    }
+
+    if (!d->idleTimer) {
+        d->idleTimer = new QTimer(this);
+        d->idleTimer->setSingleShot(true);
+        connect(d->idleTimer, &QTimer::timeout, this, &AbstractBackendWrapper::slotIdleTimeout);
+    }
+    d->idleTimer->start(d->idleTimeout);
+}
+
+void AbstractBackendWrapper::slotIdleTimeout()
+{
+    Q_D(AbstractBackendWrapper);
+    if (d->status != Launched) {
+        return;
+    }
+
+    if (!d->requests.isEmpty()) {
+        restartIdleTimer();
+        return;
+    }
+
+    debug("abs-backend-wrapper") << "Stopping idle backend" << d->identifier;
+    stop();
+}
+
 QString AbstractBackendWrapper::createRequest(RequestType requestType)
 {
     Q_D(AbstractBackendWrapper);
@@ -238,9 +565,60 @@ QString AbstractBackendWrapper::createRequest(RequestType requestType)
     requestData->request = request;
     requestData->type = requestType;
     d->requests.insert(request, requestData);
+    restartIdleTimer();
 
     return request;
 }
 
+bool AbstractBackendWrapper::queueRequest(const QString &request, const QVariantList &arguments)
+{
+    Q_D(AbstractBackendWrapper);
+    if (!d->launchOnDemand || d->status == Launched) {
+        return false;
+    }
+
+    debug("abs-backend-wrapper") << "Queuing request" << request << "until"
+                                 << d->identifier << "is launched";
+    bool launchNeeded = d->queuedRequests.isEmpty()
+                        && (d->status == Stopped || d->status == Invalid);
+    d->queuedRequests.append(qMakePair(request, arguments));
+
+    // The backend is launched in the next event loop iteration,
+    // so that a failure is reported after the request is returned
+    if (launchNeeded) {
+        QMetaObject::invokeMethod(this, "launch", Qt::QueuedConnection);
+    }
+    return true;
+}
+
+bool AbstractBackendWrapper::answerFromCache(const QString &request, const QVariantList &arguments)
+{
+    Q_D(AbstractBackendWrapper);
+    if (!d->resultCache || !d->requests.contains(request)) {
+        return false;
+    }
+
+    QString key = ResultCache::key(d->requests.value(request)->type, arguments);
+    CacheHit hit;
+    hit.request = request;
+    ResultCache::Freshness freshness = d->resultCache->find(key, hit.result);
+    if (freshness == ResultCache::Missing) {
+        d->cacheKeys.insert(request, key);
+        return false;
+    }
+
+    debug("abs-backend-wrapper") << "Using cached result for" << key;
+    hit.stale = (freshness == ResultCache::Stale);
+    d->cacheHits.append(hit);
+    QTimer::singleShot(0, this, SLOT(slotRegisterCacheHits()));
+
+    // Stale results are sent again
+    if (hit.stale) {
+        d->cacheKeys.insert(request, key);
+        return false;
+    }
+    return true;
+}
+
 
 }
@@ -42,6 +42,7 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QStringList>
+#include <QtCore/QVariant>
 
 namespace PT2
 {
@@ -51,6 +52,7 @@ class Station;
 class Ride;
 class RideNodeData;
 class CompanyNodeData;
+class ResultCache;
 class AbstractBackendWrapperPrivate;
 
 /**
@@ -138,6 +140,29 @@ class AbstractBackendWrapperPrivate;
  * a method to perform this registration (that should use setBackendProperties())
  * and that should set the status to AbstractBackendWrapper::Launched.
  *
+ * @section prefetching Prefetching
+ *
+ * Rides from a station can be requested speculatively with
+ * prefetchRealTimeRidesFromStation(), before the user actually
+ * asks for them. Prefetched rides are kept for a short time, and
+ * requestPrefetchedRealTimeRidesFromStation() answers with them
+ * if they are available, or waits for the running prefetch. The
+ * prefetches that are not needed anymore can be dropped with
+ * cancelPrefetches().
+ *
+ * Backends do not support request priorities, so prefetches are
+ * sent like any other request. Callers should only prefetch a few
+ * stations at once.
+ *
+ * @section caching Caching results
+ *
+ * Results can be stored on disk by a PT2::ResultCache, that is set
+ * with setResultCache(). Requests are answered from the cache when
+ * the cached result is fresh. When it is stale, the cached result is
+ * registered immediately, and registered again for the same request
+ * when the backend answers. isRevalidating() tells if a registered
+ * result will be registered again.
+ *
  */
 class PT2_EXPORT AbstractBackendWrapper: public QObject
 {
@@ -253,6 +278,102 @@ public:
      * @return request identifier.
      */
     virtual QString requestRealTimeSuggestedLines(const QString &partialLine) = 0;
+    /**
+     * @brief Prefetch rides from station for real time information
+     *
+     * The rides are requested to the backend, but are not relayed
+     * by realTimeRidesFromStationRegistered(). Instead, they are
+     * kept to answer a later call to
+     * requestPrefetchedRealTimeRidesFromStation(). Nothing is done
+     * if rides for this station are already prefetched.
+     *
+     * @param station station.
+     */
+    void prefetchRealTimeRidesFromStation(const PT2::Station &station);
+    /**
+     * @brief Request rides from station for real time information, using prefetched rides
+     *
+     * If the rides of the station were prefetched recently, they are
+     * registered for the returned request in the next event loop
+     * iteration. If they are still being prefetched, they are
+     * registered when the prefetch finishes. Otherwise, this method
+     * calls requestRealTimeRidesFromStation().
+     *
+     * @param station station.
+     * @return request identifier.
+     */
+    QString requestPrefetchedRealTimeRidesFromStation(const PT2::Station &station);
+    /**
+     * @brief Cancel prefetches
+     *
+     * The running prefetches that are not awaited by any request
+     * are dropped, and their replies will be ignored. Expired
+     * prefetched rides are also dropped.
+     */
+    void cancelPrefetches();
+    /**
+     * @brief If the backend is launched on demand
+     *
+     * A backend is launched on demand when its capabilities
+     * were declared with setDeclaredCapabilities(). Such a backend
+     * is launched when a request is performed while it is stopped,
+     * and the request is sent once the backend is launched. It is
+     * stopped after being idle for idleTimeout() milliseconds.
+     *
+     * @return if the backend is launched on demand.
+     */
+    bool isLaunchedOnDemand() const;
+    /**
+     * @brief Set declared capabilities
+     *
+     * The declared capabilities, usually read from the backend
+     * description, are the capabilities of the backend until it
+     * is launched and registers its own capabilities. Declaring
+     * capabilities allows the backend to be launched on demand.
+     *
+     * @param capabilities declared capabilities.
+     */
+    void setDeclaredCapabilities(const QStringList &capabilities);
+    /**
+     * @brief Idle timeout
+     *
+     * A backend launched on demand that have no running request
+     * for this duration is stopped. A negative or null timeout
+     * disables stopping idle backends.
+     *
+     * @return idle timeout, in milliseconds.
+     */
+    int idleTimeout() const;
+    /**
+     * @brief Set idle timeout
+     * @param idleTimeout idle timeout, in milliseconds.
+     */
+    void setIdleTimeout(int idleTimeout);
+    /**
+     * @brief Result cache
+     * @return result cache, or 0 if results are not cached.
+     */
+    ResultCache * resultCache() const;
+    /**
+     * @brief Set result cache
+     *
+     * The backend wrapper takes ownership of the result cache.
+     *
+     * @param resultCache result cache.
+     */
+    void setResultCache(ResultCache *resultCache);
+    /**
+     * @brief If a request is being revalidated
+     *
+     * A request is revalidated when a stale cached result was
+     * registered for it, and the backend did not answer yet.
+     * The request is still running, and the result of the
+     * backend will be registered for the same request.
+     *
+     * @param request request identifier.
+     * @return if the request is being revalidated.
+     */
+    bool isRevalidating(const QString &request) const;
 public Q_SLOTS:
     /**
      * @brief Launch the backend
@@ -420,13 +541,97 @@ protected:
      * @return request identifier.
      */
     QString createRequest(RequestType requestType);
+    /**
+     * @brief Queue request
+     *
+     * This method should be called by implementations before
+     * sending a request. If the backend is launched on demand
+     * and is not launched, the request is queued, the backend
+     * is launched, and the request is sent later using
+     * sendQueuedRequest().
+     *
+     * @param request request identifier.
+     * @param arguments arguments of the request.
+     * @return if the request was queued.
+     */
+    bool queueRequest(const QString &request, const QVariantList &arguments);
+    /**
+     * @brief Answer from cache
+     *
+     * This method should be called by implementations before
+     * queueRequest(). If a fresh result is cached, it is registered
+     * in the next event loop iteration, and the request should not
+     * be sent. If a stale result is cached, it is also registered,
+     * but the request should still be sent to revalidate it.
+     *
+     * @param request request identifier.
+     * @param arguments arguments of the request.
+     * @return if the request was answered from the cache.
+     */
+    bool answerFromCache(const QString &request, const QVariantList &arguments);
+    /**
+     * @brief Send a queued request
+     *
+     * This method is called when the backend is launched, for each
+     * request that were queued with queueRequest().
+     *
+     * @param request request identifier.
+     * @param requestType request type.
+     * @param arguments arguments of the request.
+     */
+    virtual void sendQueuedRequest(const QString &request, RequestType requestType,
+                                   const QVariantList &arguments) = 0;
 
     /**
      * @brief D-pointer
      */
     QScopedPointer<AbstractBackendWrapperPrivate> d_ptr;
 private:
+    /**
+     * @brief Register prefetched rides
+     *
+     * The rides are kept, and registered for the requests that
+     * were waiting for this prefetch.
+     *
+     * @param request request identifier of the prefetch.
+     * @param rideList ride list.
+     */
+    void registerPrefetchedRides(const QString &request, const QList<PT2::CompanyNodeData> &rideList);
+    /**
+     * @brief Store the result of a request in the result cache
+     *
+     * Only the results of the requests that were sent to
+     * the backend are stored.
+     *
+     * @param request request identifier.
+     * @param result result.
+     */
+    void cacheResult(const QString &request, const QVariant &result);
+    /**
+     * @brief Process queued requests
+     *
+     * Queued requests are sent when the backend is launched,
+     * and fail if it cannot be launched.
+     */
+    void processQueuedRequests();
+    /**
+     * @brief Restart the idle timer
+     */
+    void restartIdleTimer();
     Q_DECLARE_PRIVATE(AbstractBackendWrapper)
+private Q_SLOTS:
+    /**
+     * @brief Slot used to register prefetched rides
+     */
+    void slotRegisterPrefetchHits();
+    /**
+     * @brief Slot used to register cached results
+     */
+    void slotRegisterCacheHits();
+    /**
+     * @brief Slot used to stop the backend when it is idle
+     */
+    void slotIdleTimeout();
 };
 
 }
@@ -47,8 +47,16 @@
 
 #include "abstractbackendwrapper.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
 #include <QtCore/QMap>
 #include <QtCore/QObject>
+#include <QtCore/QPair>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
+#include <QtCore/QVariant>
+
+#include "base/companynodedata.h"
 
 
 namespace PT2
@@ -72,6 +80,47 @@ struct RequestData
     AbstractBackendWrapper::RequestType type;
 };
 
+/**
+ * @internal
+ * @brief Rides prefetched in PT2::AbstractBackendWrapper
+ */
+struct PrefetchedRides
+{
+    /**
+     * @internal
+     * @brief Ride list
+     */
+    QList<CompanyNodeData> rideList;
+    /**
+     * @internal
+     * @brief Timer started when the rides were retrieved
+     */
+    QElapsedTimer timer;
+};
+
+/**
+ * @internal
+ * @brief Result found in the result cache of PT2::AbstractBackendWrapper
+ */
+struct CacheHit
+{
+    /**
+     * @internal
+     * @brief Request identifier
+     */
+    QString request;
+    /**
+     * @internal
+     * @brief Cached result
+     */
+    QVariant result;
+    /**
+     * @internal
+     * @brief If the cached result is stale
+     */
+    bool stale;
+};
+
 /**
  * @internal
  * @brief Private class for PT2::AbstractBackendWrapper
@@ -85,6 +134,14 @@ public:
      * @brief Default constructor
      */
     AbstractBackendWrapperPrivate();
+    /**
+     * @internal
+     * @brief Drop the expired prefetched rides
+     *
+     * Prefetched rides that are about to be registered
+     * for a request are kept.
+     */
+    void pruneExpiredPrefetchedRides();
     /**
      * @internal
      * @brief Identifier
@@ -125,6 +182,66 @@ public:
      * @brief Requests
      */
     QMap<QString, RequestData *> requests;
+    /**
+     * @internal
+     * @brief Running prefetches, with the identifier of their station
+     */
+    QHash<QString, QString> prefetchRequests;
+    /**
+     * @internal
+     * @brief Requests waiting for a running prefetch
+     */
+    QHash<QString, QStringList> waitingRequests;
+    /**
+     * @internal
+     * @brief Prefetched rides, by station identifier
+     */
+    QHash<QString, PrefetchedRides> prefetchedRides;
+    /**
+     * @internal
+     * @brief Requests answered with prefetched rides, with the identifier of their station
+     */
+    QList<QPair<QString, QString> > prefetchHits;
+    /**
+     * @internal
+     * @brief If the backend is launched on demand
+     */
+    bool launchOnDemand;
+    /**
+     * @internal
+     * @brief Idle timeout
+     */
+    int idleTimeout;
+    /**
+     * @internal
+     * @brief Timer used to stop the backend when it is idle
+     */
+    QTimer *idleTimer;
+    /**
+     * @internal
+     * @brief Requests queued until the backend is launched, with their arguments
+     */
+    QList<QPair<QString, QVariantList> > queuedRequests;
+    /**
+     * @internal
+     * @brief Result cache
+     */
+    ResultCache *resultCache;
+    /**
+     * @internal
+     * @brief Cache keys of the requests whose results should be cached
+     */
+    QHash<QString, QString> cacheKeys;
+    /**
+     * @internal
+     * @brief Requests answered from the result cache
+     */
+    QList<CacheHit> cacheHits;
+    /**
+     * @internal
+     * @brief Requests whose stale cached results were registered
+     */
+    QSet<QString> revalidatingRequests;
 };
 
 }
@@ -21,6 +21,11 @@
 
 #include "backendinfo.h"
 #include <MDesktopEntry>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QPluginLoader>
 #include <QtCore/QSharedData>
 
 namespace PT2
@@ -89,6 +94,82 @@ static const char *DESKTOP_FILE_BACKENDINFO_WEBSITE = "X-PublicTransportation-Ba
  * Used in PublicTransportation::BackendInfo.
  */
 static const char *DESKTOP_FILE_BACKENDINFO_VERSION = "X-PublicTransportation-BackendInfo-Version";
+/**
+ * @internal
+ * @brief DESKTOP_FILE_BACKENDINFO_CAPABILITIES
+ *
+ * Used in PublicTransportation::BackendInfo.
+ */
+static const char *DESKTOP_FILE_BACKENDINFO_CAPABILITIES
+    = "X-PublicTransportation-BackendInfo-Capabilities";
+/**
+ * @internal
+ * @brief PROVIDER_PREFIX
+ *
+ * Used in PublicTransportation::BackendInfo.
+ */
+static const char *PROVIDER_PREFIX = "$PROVIDER ";
+/**
+ * @internal
+ * @brief PLUGIN_METADATA_CAPABILITIES
+ *
+ * Used in PublicTransportation::BackendInfo.
+ */
+static const char *PLUGIN_METADATA_CAPABILITIES = "capabilities";
+
+/**
+ * @internal
+ * @brief Read the capabilities from the metadata of a plugin
+ *
+ * The metadata is read without loading the plugin. When the
+ * plugins are linked statically, the metadata is read from the
+ * plugins imported in the current process, that are selected by
+ * name, like in PT2::ProviderPluginDBusWrapper.
+ *
+ * @param executable executable of the backend.
+ * @return capabilities, or an empty list if they are not declared.
+ */
+static QStringList pluginCapabilities(const QString &executable)
+{
+    if (!executable.startsWith(PROVIDER_PREFIX)) {
+        return QStringList();
+    }
+
+    QString plugin = executable.mid(QString(PROVIDER_PREFIX).size()).trimmed();
+    if (plugin.isEmpty()) {
+        return QStringList();
+    }
+
+#ifdef PT2_STATIC_PROVIDER
+    QString name = QFileInfo(plugin).completeBaseName();
+    if (name.startsWith("lib")) {
+        name = name.mid(3);
+    }
+
+    QJsonObject metaData;
+    foreach (const QStaticPlugin &staticPlugin, QPluginLoader::staticPlugins()) {
+        QString className = staticPlugin.metaData().value("className").toString();
+        if (className.compare(name, Qt::CaseInsensitive) == 0) {
+            metaData = staticPlugin.metaData().value("MetaData").toObject();
+            break;
+        }
+    }
+#else
+    QDir dir (PLUGIN_FOLDER);
+    if (!dir.exists(plugin)) {
+        return QStringList();
+    }
+
+    QPluginLoader pluginLoader (dir.absoluteFilePath(plugin));
+    QJsonObject metaData = pluginLoader.metaData().value("MetaData").toObject();
+#endif
+    QStringList capabilities;
+    foreach (const QJsonValue &capability,
+             metaData.value(PLUGIN_METADATA_CAPABILITIES).toArray()) {
+        capabilities.append(capability.toString());
+    }
+    return capabilities;
+}
 
 BackendInfoPrivate::BackendInfoPrivate()
     : QSharedData()
@@ -100,7 +181,7 @@ BackendInfoPrivate::BackendInfoPrivate(const BackendInfoPrivate &other)
     , description(other.description), executable(other.executable)
     , identifier(other.identifier), author(other.author), email(other.email)
     , website(other.website), version(other.version), country(other.country)
-    , cities(other.cities)
+    , cities(other.cities), capabilities(other.capabilities)
 {
 }
 
@@ -147,6 +228,15 @@ BackendInfo::BackendInfo(const QString &file):
     d->email = parser.value(DESKTOP_FILE_GROUP, DESKTOP_FILE_BACKENDINFO_EMAIL);
     d->website = parser.value(DESKTOP_FILE_GROUP, DESKTOP_FILE_BACKENDINFO_WEBSITE);
     d->version = parser.value(DESKTOP_FILE_GROUP, DESKTOP_FILE_BACKENDINFO_VERSION);
+
+    QString capabilities = parser.value(DESKTOP_FILE_GROUP, DESKTOP_FILE_BACKENDINFO_CAPABILITIES);
+    if (!capabilities.isEmpty()) {
+        foreach (const QString &capability, capabilities.split(",", QString::SkipEmptyParts)) {
+            d->capabilities.append(capability.trimmed());
+        }
+    } else {
+        d->capabilities = pluginCapabilities(d->executable);
+    }
 }
 
 BackendInfo::~BackendInfo()
@@ -213,4 +303,27 @@ QString BackendInfo::backendVersion() const
     return d->version;
 }
 
+QStringList BackendInfo::capabilities() const
+{
+    return d->capabilities;
+}
+
+QDataStream & operator<<(QDataStream &stream, const BackendInfo &backendInfo)
+{
+    const BackendInfoPrivate *d = backendInfo.d.constData();
+    stream << d->icon << d->name << d->description << d->executable << d->identifier
+           << d->author << d->email << d->website << d->version << d->country << d->cities
+           << d->capabilities;
+    return stream;
+}
+
+QDataStream & operator>>(QDataStream &stream, BackendInfo &backendInfo)
+{
+    BackendInfoPrivate *d = backendInfo.d.data();
+    stream >> d->icon >> d->name >> d->description >> d->executable >> d->identifier
+           >> d->author >> d->email >> d->website >> d->version >> d->country >> d->cities
+           >> d->capabilities;
+    return stream;
+}
+
 }
@@ -37,6 +37,7 @@
  * @short Definition of PT2::BackendInfo
  */
 
+#include <QtCore/QDataStream>
 #include <QtCore/QSharedDataPointer>
 #include <QtCore/QStringList>
 
@@ -123,6 +124,11 @@ struct BackendInfoPrivate: public QSharedData
      * @brief Cities
      */
     QStringList cities;
+    /**
+     * @internal
+     * @brief Capabilities
+     */
+    QStringList capabilities;
 };
 
 /**
@@ -152,6 +158,7 @@ struct BackendInfoPrivate: public QSharedData
  * X-PublicTransportation-BackendInfo-Email=some.author@mycompany.com
  * X-PublicTransportation-BackendInfo-Website=http://www.mycompany.com
  * X-PublicTransportation-BackendInfo-Version=1.0.0
+ * X-PublicTransportation-BackendInfo-Capabilities=capability:real_time_suggest_station_from_string
  * \endcode
  *
  * \b Name, \b Comment, \b Icon are used to provide basic informations about
@@ -169,6 +176,15 @@ struct BackendInfoPrivate: public QSharedData
  *
  * For example, with DBus, this identifier is the path to the DBus object that
  * corresponds to the backend being run.
+ *
+ * \b Capabilities is a comma separated list of the capabilities of the
+ * backend, as found in \ref capabilitiesconstants.h. When this key is not
+ * provided, and the backend is a C++ plugin, the capabilities are read from
+ * the "capabilities" array of the plugin metadata, without loading the plugin.
+ * When the plugins are linked statically in the provider, this metadata is
+ * only available in the processes that import the plugins, so the capabilities
+ * should rather be declared in the desktop file. Knowing the capabilities of a backend allows it to be launched only when
+ * a request needs it.
  */
 class BackendInfo
 {
@@ -251,13 +267,44 @@ public:
      * @return backend version.
      */
     QString backendVersion() const;
+    /**
+     * @brief Backend capabilities
+     *
+     * These capabilities are declared in the desktop file, or
+     * in the plugin metadata. They are empty if they are not
+     * declared.
+     *
+     * @return backend capabilities.
+     */
+    QStringList capabilities() const;
 protected:
     /**
      * @brief D-pointer
      */
     QSharedDataPointer<BackendInfoPrivate> d;
+private:
+    friend QDataStream & operator<<(QDataStream &stream, const BackendInfo &backendInfo);
+    friend QDataStream & operator>>(QDataStream &stream, BackendInfo &backendInfo);
 };
 
+/**
+ * @brief Write a backend info to a stream
+ *
+ * Used to cache the parsed desktop files.
+ *
+ * @param stream stream to write to.
+ * @param backendInfo backend info to write.
+ * @return the stream.
+ */
+QDataStream & operator<<(QDataStream &stream, const BackendInfo &backendInfo);
+/**
+ * @brief Read a backend info from a stream
+ * @param stream stream to read from.
+ * @param backendInfo backend info to read.
+ * @return the stream.
+ */
+QDataStream & operator>>(QDataStream &stream, BackendInfo &backendInfo);
+
 }
 
 #endif // PT2_BACKENDINFO_H
@@ -36,7 +36,17 @@
 
 #include "backendlistmanager.h"
 
+#include <QtCore/QDateTime>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QLocale>
+#include <QtCore/QMap>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTimer>
+#include <QtConcurrent/QtConcurrentMap>
 
 #include "backendinfo.h"
 #include "debug.h"
@@ -44,24 +54,388 @@
 namespace PT2
 {
 
+/**
+ * @internal
+ * @brief Magic number of the cache file
+ */
+static const quint32 CACHE_MAGIC = 0x50543243;
+/**
+ * @internal
+ * @brief Version of the cache file
+ *
+ * Should be incremented when the serialization of
+ * PT2::BackendInfo changes.
+ */
+static const quint32 CACHE_VERSION = 3;
+/**
+ * @internal
+ * @brief Prefix of the executable of provider plugins
+ */
+static const char *PROVIDER_PREFIX = "$PROVIDER ";
+/**
+ * @internal
+ * @brief Delay before reloading, after the folder changed, in milliseconds
+ */
+static const int RELOAD_DELAY = 100;
+
+/**
+ * @internal
+ * @brief Parsed desktop file
+ */
+struct BackendListEntry
+{
+    /**
+     * @internal
+     * @brief Path
+     */
+    QString path;
+    /**
+     * @internal
+     * @brief Modification time, in milliseconds since epoch
+     */
+    qint64 modified;
+    /**
+     * @internal
+     * @brief Size
+     */
+    qint64 size;
+    /**
+     * @internal
+     * @brief Modification time of the provider plugin, in milliseconds since epoch
+     *
+     * The capabilities of a backend can be read from the metadata
+     * of its provider plugin. This is 0 if the backend is not a
+     * provider plugin.
+     */
+    qint64 pluginModified;
+    /**
+     * @internal
+     * @brief Backend info
+     *
+     * Invalid desktop files are also cached, with an
+     * invalid backend info.
+     */
+    BackendInfo info;
+};
+
+/**
+ * @internal
+ * @brief Modification time of the provider plugin of a backend
+ * @param info backend info.
+ * @return modification time, in milliseconds since epoch, or 0 if not found.
+ */
+static qint64 pluginModified(const BackendInfo &info)
+{
+    if (!info.executable().startsWith(PROVIDER_PREFIX)) {
+        return 0;
+    }
+
+    QString plugin = info.executable().mid(QString(PROVIDER_PREFIX).size()).trimmed();
+    QFileInfo fileInfo (QDir(PLUGIN_FOLDER), plugin);
+    if (plugin.isEmpty() || !fileInfo.exists()) {
+        return 0;
+    }
+    return fileInfo.lastModified().toMSecsSinceEpoch();
+}
+
+/**
+ * @internal
+ * @brief If two entries were parsed from the same files
+ * @param first first entry.
+ * @param second second entry.
+ * @return if the desktop files, and the provider plugins, are the same.
+ */
+static inline bool sameFiles(const BackendListEntry &first, const BackendListEntry &second)
+{
+    return first.modified == second.modified && first.size == second.size
+            && first.pluginModified == second.pluginModified;
+}
+
+/**
+ * @internal
+ * @brief Parse a desktop file
+ *
+ * This method is run in a worker thread.
+ *
+ * @param entry entry whose path, modification time and size are set.
+ * @return entry with the parsed backend info.
+ */
+static BackendListEntry parseEntry(const BackendListEntry &entry)
+{
+    BackendListEntry parsedEntry = entry;
+    parsedEntry.info = BackendInfo(entry.path);
+    parsedEntry.pluginModified = pluginModified(parsedEntry.info);
+    return parsedEntry;
+}
+
 /**
  * @internal
  * @brief Private class for PT2::BackendListManager
  */
-struct BackendListManagerPrivate
+class BackendListManagerPrivate: public QObject
 {
+    Q_OBJECT
 public:
     /**
      * @internal
-     * @brief List of backends
+     * @brief Default constructor
+     * @param q Q-pointer.
      */
-    QList<BackendInfo> backendList;
+    explicit BackendListManagerPrivate(BackendListManager *q);
+    /**
+     * @internal
+     * @brief Path to the cache file
+     * @return path to the cache file.
+     */
+    static QString cacheFile();
+    /**
+     * @internal
+     * @brief Load the cache
+     *
+     * Entries of the cache are used as the current entries.
+     */
+    void loadCache();
+    /**
+     * @internal
+     * @brief Save the cache
+     */
+    void saveCache() const;
+    /**
+     * @internal
+     * @brief Set loading
+     * @param loading if the list is loading.
+     */
+    void setLoading(bool loading);
+    /**
+     * @internal
+     * @brief Notify the changes since the last notification
+     */
+    void notifyChanges();
+    /**
+     * @internal
+     * @brief If the cache was loaded
+     */
+    bool cacheLoaded;
+    /**
+     * @internal
+     * @brief Parsed desktop files, by path
+     */
+    QMap<QString, BackendListEntry> entries;
+    /**
+     * @internal
+     * @brief Backends that were already notified
+     */
+    QMap<QString, BackendListEntry> notifiedEntries;
+    /**
+     * @internal
+     * @brief Folder watcher
+     */
+    QFileSystemWatcher *watcher;
+    /**
+     * @internal
+     * @brief Timer used to reload after the folder changed
+     */
+    QTimer *reloadTimer;
+    /**
+     * @internal
+     * @brief Watcher of the running parsing
+     */
+    QFutureWatcher<BackendListEntry> *parseWatcher;
+    /**
+     * @internal
+     * @brief Entries that did not change, during parsing
+     */
+    QMap<QString, BackendListEntry> unchangedEntries;
+    /**
+     * @internal
+     * @brief If the list is loading
+     */
+    bool loading;
+    /**
+     * @internal
+     * @brief If the list should be reloaded after the running parsing
+     */
+    bool reloadPending;
+public Q_SLOTS:
+    /**
+     * @internal
+     * @brief Slot entries parsed
+     */
+    void slotEntriesParsed();
+protected:
+    /**
+     * @internal
+     * @brief Q-pointer
+     */
+    BackendListManager * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(BackendListManager)
 };
 
+BackendListManagerPrivate::BackendListManagerPrivate(BackendListManager *q)
+    : QObject(), cacheLoaded(false), watcher(0), reloadTimer(0)
+    , parseWatcher(new QFutureWatcher<BackendListEntry>(this)), loading(false)
+    , reloadPending(false), q_ptr(q)
+{
+    connect(parseWatcher, &QFutureWatcher<BackendListEntry>::finished,
+            this, &BackendListManagerPrivate::slotEntriesParsed);
+}
+
+QString BackendListManagerPrivate::cacheFile()
+{
+    QDir dir (QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+    return dir.absoluteFilePath("pt2/backends.cache");
+}
+
+void BackendListManagerPrivate::loadCache()
+{
+    cacheLoaded = true;
+    QFile file (cacheFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream (file.readAll());
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic;
+    quint32 version;
+    stream >> magic >> version;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        debug("backend-list-manager") << "Ignoring outdated cache";
+        return;
+    }
+
+    // Names and descriptions are translated
+    QString locale;
+    stream >> locale;
+    if (locale != QLocale::system().name()) {
+        debug("backend-list-manager") << "Ignoring cache for locale" << locale;
+        return;
+    }
+
+    quint32 count;
+    stream >> count;
+    QMap<QString, BackendListEntry> cachedEntries;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        BackendListEntry entry;
+        stream >> path >> entry.modified >> entry.size >> entry.pluginModified >> entry.info;
+        entry.path = path;
+        cachedEntries.insert(path, entry);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        warning("backend-list-manager") << "Ignoring corrupted cache";
+        return;
+    }
+
+    entries = cachedEntries;
+    debug("backend-list-manager") << "Loaded" << entries.count() << "entries from cache";
+}
+
+void BackendListManagerPrivate::saveCache() const
+{
+    QString path = cacheFile();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file (path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        warning("backend-list-manager") << "Failed to write cache" << path;
+        return;
+    }
+
+    QByteArray data;
+    QDataStream stream (&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << CACHE_MAGIC << CACHE_VERSION << QLocale::system().name()
+           << quint32(entries.count());
+    QMap<QString, BackendListEntry>::const_iterator i;
+    for (i = entries.constBegin(); i != entries.constEnd(); ++i) {
+        stream << i.key() << i.value().modified << i.value().size << i.value().pluginModified
+               << i.value().info;
+    }
+    file.write(data);
+}
+
+void BackendListManagerPrivate::setLoading(bool loadingToSet)
+{
+    Q_Q(BackendListManager);
+    if (loading != loadingToSet) {
+        loading = loadingToSet;
+        emit q->loadingChanged();
+    }
+}
+
+void BackendListManagerPrivate::notifyChanges()
+{
+    Q_Q(BackendListManager);
+    // Compute the changes since the last notification
+    QList<BackendInfo> added;
+    QStringList removed;
+    QMap<QString, BackendListEntry>::const_iterator i;
+    for (i = notifiedEntries.constBegin(); i != notifiedEntries.constEnd(); ++i) {
+        const BackendListEntry &entry = i.value();
+        if (!entry.info.isValid()) {
+            continue;
+        }
+
+        if (!entries.contains(i.key()) || !sameFiles(entries.value(i.key()), entry)) {
+            removed.append(entry.info.backendIdentifier());
+        }
+    }
+    for (i = entries.constBegin(); i != entries.constEnd(); ++i) {
+        const BackendListEntry &entry = i.value();
+        if (!entry.info.isValid()) {
+            continue;
+        }
+
+        if (!notifiedEntries.contains(i.key())
+            || !sameFiles(notifiedEntries.value(i.key()), entry)) {
+            added.append(entry.info);
+        }
+    }
+    notifiedEntries = entries;
+
+    debug("backend-list-manager") << "Backend list reloaded";
+    debug("backend-list-manager") << "Number of backends:" << q->backendList().count()
+                                  << "added:" << added.count() << "removed:" << removed.count();
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        emit q->backendListChanged(added, removed);
+    }
+}
+
+void BackendListManagerPrivate::slotEntriesParsed()
+{
+    Q_Q(BackendListManager);
+    // Entries are stored in a map, sorted by path, so that the
+    // list of backends does not depend on the order in which
+    // the worker threads finished
+    QMap<QString, BackendListEntry> newEntries = unchangedEntries;
+    QList<BackendListEntry> parsedEntries = parseWatcher->future().results();
+    foreach (const BackendListEntry &entry, parsedEntries) {
+        newEntries.insert(entry.path, entry);
+    }
+    unchangedEntries.clear();
+
+    bool changed = !parsedEntries.isEmpty() || newEntries.count() != entries.count();
+    entries = newEntries;
+    if (changed) {
+        saveCache();
+    }
+
+    notifyChanges();
+
+    if (reloadPending) {
+        reloadPending = false;
+        q->reload();
+        return;
+    }
+    setLoading(false);
+}
+
 ////// End of private class //////
 
 BackendListManager::BackendListManager(QObject *parent) :
-    QObject(parent), d_ptr(new BackendListManagerPrivate())
+    QObject(parent), d_ptr(new BackendListManagerPrivate(this))
 {
 }
 
@@ -69,32 +443,80 @@ BackendListManager::~BackendListManager()
 {
 }
 
+bool BackendListManager::isLoading() const
+{
+    Q_D(const BackendListManager);
+    return d->loading;
+}
+
 QList<BackendInfo> BackendListManager::backendList() const
 {
     Q_D(const BackendListManager);
-    return d->backendList;
+    QList<BackendInfo> backendList;
+    foreach (const BackendListEntry &entry, d->notifiedEntries) {
+        if (entry.info.isValid()) {
+            backendList.append(entry.info);
+        }
+    }
+    return backendList;
 }
 
 void BackendListManager::reload()
 {
     Q_D(BackendListManager);
-    d->backendList.clear();
+    if (d->parseWatcher->isRunning()) {
+        d->reloadPending = true;
+        return;
+    }
+
+    if (!d->cacheLoaded) {
+        d->loadCache();
+    }
+
+    if (!d->watcher) {
+        d->reloadTimer = new QTimer(this);
+        d->reloadTimer->setSingleShot(true);
+        d->reloadTimer->setInterval(RELOAD_DELAY);
+        connect(d->reloadTimer, &QTimer::timeout, this, &BackendListManager::reload);
+        d->watcher = new QFileSystemWatcher(this);
+        connect(d->watcher, &QFileSystemWatcher::directoryChanged,
+                d->reloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+        if (QDir(PLUGIN_FOLDER).exists()) {
+            d->watcher->addPath(PLUGIN_FOLDER);
+        }
+    }
 
     debug("backend-list-manager") << "Searching in" << PLUGIN_FOLDER;
     QDir pluginDir = QDir(PLUGIN_FOLDER);
     QStringList nameFilters;
     nameFilters.append("*.desktop");
 
-    foreach (QString file, pluginDir.entryList(nameFilters, QDir::Files)) {
-        BackendInfo info (pluginDir.absoluteFilePath(file));
-        if (info.isValid()) {
-            d->backendList.append(info);
+    // Only the desktop files that changed are parsed again,
+    // in worker threads
+    d->unchangedEntries.clear();
+    QList<BackendListEntry> changedEntries;
+    foreach (const QFileInfo &fileInfo, pluginDir.entryInfoList(nameFilters, QDir::Files)) {
+        BackendListEntry entry;
+        entry.path = fileInfo.absoluteFilePath();
+        entry.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+        entry.size = fileInfo.size();
+        entry.pluginModified = 0;
+
+        if (d->entries.contains(entry.path)) {
+            const BackendListEntry &cachedEntry = d->entries.value(entry.path);
+            entry.pluginModified = pluginModified(cachedEntry.info);
+            if (sameFiles(cachedEntry, entry)) {
+                d->unchangedEntries.insert(entry.path, cachedEntry);
+                continue;
+            }
         }
+        changedEntries.append(entry);
     }
 
-    debug("backend-list-manager") << "Backend list reloaded";
-    debug("backend-list-manager") << "Number of backends:" << d->backendList.count();
-    emit backendListChanged();
+    d->setLoading(true);
+    d->parseWatcher->setFuture(QtConcurrent::mapped(changedEntries, parseEntry));
 }
 
 }
+
+#include "backendlistmanager.moc"
@@ -40,6 +40,7 @@
 #include "pt2_global.h"
 
 #include <QtCore/QObject>
+#include <QtCore/QStringList>
 
 namespace PT2
 {
@@ -57,10 +58,25 @@ class BackendListManagerPrivate;
  * Getting the list of backend is done using
  * - reload() that parses the folder containing backends.
  * - backendList() that contains informations about found backends.
+ *
+ * Parsed desktop files are cached in a binary file, and are only
+ * parsed again when their modification time or size changed. After
+ * the first call to reload(), the folder is watched, and the list
+ * is updated automatically when desktop files are added, removed
+ * or replaced. Changes are notified with backendListChanged(),
+ * that only contains the backends that were added or removed.
+ *
+ * Desktop files that need to be parsed are parsed in parallel,
+ * in worker threads, so reload() returns immediately. isLoading()
+ * tells if the list is being reloaded.
  */
 class PT2_EXPORT BackendListManager : public QObject
 {
     Q_OBJECT
+    /**
+     * @short Loading
+     */
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
 public:
     /**
      * @brief Default constructor
@@ -71,6 +87,11 @@ public:
      * @brief Destructor
      */
     virtual ~BackendListManager();
+    /**
+     * @brief If the list of backends is being reloaded
+     * @return if the list of backends is being reloaded.
+     */
+    bool isLoading() const;
     /**
      * @brief List of backends
      * @return list of backends.
@@ -79,13 +100,26 @@ public:
 public Q_SLOTS:
     /**
      * @brief Reload
+     *
+     * If a reload is already running, another reload is
+     * done after it finishes.
      */
     void reload();
 Q_SIGNALS:
+    /**
+     * @brief Loading changed
+     */
+    void loadingChanged();
     /**
      * @brief Backend list changed
+     *
+     * A backend whose desktop file changed is both removed
+     * and added.
+     *
+     * @param added backends that were added.
+     * @param removed identifiers of the backends that were removed.
      */
-    void backendListChanged();
+    void backendListChanged(const QList<PT2::BackendInfo> &added, const QStringList &removed);
 protected:
     /**
      * @brief D-pointer
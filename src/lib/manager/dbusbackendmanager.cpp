@@ -38,6 +38,7 @@
 
 #include <QtDBus/QDBusConnection>
 
+#include "debug.h"
 #include "dbus/dbusconstants.h"
 #include "dbusbackendwrapper.h"
 
@@ -47,7 +48,14 @@ namespace PT2
 DBusBackendManager::DBusBackendManager(QObject *parent) :
     AbstractBackendManager(parent)
 {
-    registerDBusService();
+    if (!registerDBusService()) {
+        warning("dbus-backend-manager") << "Failed to register the DBus service";
+        return;
+    }
+
+    // Backends register to the service, so they can be launched now,
+    // while the rest of the application is loading
+    startEnabledBackends();
 }
 
 DBusBackendManager::~DBusBackendManager()
@@ -49,6 +49,9 @@ namespace PT2
  *
  * This class simply implements a manager that uses DBus
  * backend wrappers.
+ *
+ * The enabled backends are started as soon as the DBus
+ * service is registered, when this manager is created.
  */
 class PT2_EXPORT DBusBackendManager : public AbstractBackendManager
 {
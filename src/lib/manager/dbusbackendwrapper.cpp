@@ -194,7 +194,10 @@ void DBusBackendWrapper::launch()
     d->dbusObjectPath = DBUS_BACKEND_PATH_PREFIX;
     d->dbusObjectPath.append(dbusIdentifier);
 
-    new Pt2Adaptor(this);
+    // The adaptor is kept when the backend is launched again
+    if (!findChild<Pt2Adaptor *>()) {
+        new Pt2Adaptor(this);
+    }
     if (!QDBusConnection::sessionBus().registerObject(d->dbusObjectPath, this)) {
         setLastError(QString("Failed to register object on path %1").arg(d->dbusObjectPath));
         setStatus(Invalid);
@@ -297,20 +300,50 @@ void DBusBackendWrapper::registerBackend(const QStringList &capabilities, const
 }
 QString DBusBackendWrapper::requestRealTimeSuggestedStations(const QString &partialStation){
     QString request = createRequest(RealTime_SuggestStationFromStringType);
-    emit realTimeSuggestedStationsRequested(request, partialStation);
+    QVariantList arguments;
+    arguments.append(QVariant::fromValue(partialStation));
+    if (!answerFromCache(request, arguments) && !queueRequest(request, arguments)) {
+        emit realTimeSuggestedStationsRequested(request, partialStation);
+    }
     return request;
 }
 QString DBusBackendWrapper::requestRealTimeRidesFromStation(const PT2::Station &station){
     QString request = createRequest(RealTime_RidesFromStationType);
-    emit realTimeRidesFromStationRequested(request, station);
+    QVariantList arguments;
+    arguments.append(QVariant::fromValue(station));
+    if (!answerFromCache(request, arguments) && !queueRequest(request, arguments)) {
+        emit realTimeRidesFromStationRequested(request, station);
+    }
     return request;
 }
 QString DBusBackendWrapper::requestRealTimeSuggestedLines(const QString &partialLine){
     QString request = createRequest(RealTime_SuggestLineFromStringType);
-    emit realTimeSuggestedLinesRequested(request, partialLine);
+    QVariantList arguments;
+    arguments.append(QVariant::fromValue(partialLine));
+    if (!answerFromCache(request, arguments) && !queueRequest(request, arguments)) {
+        emit realTimeSuggestedLinesRequested(request, partialLine);
+    }
     return request;
 }
 
+void DBusBackendWrapper::sendQueuedRequest(const QString &request, RequestType requestType,
+                                           const QVariantList &arguments)
+{
+    switch (requestType) {
+    case RealTime_SuggestStationFromStringType:
+        emit realTimeSuggestedStationsRequested(request, arguments.at(0).value<QString>());
+        break;
+    case RealTime_RidesFromStationType:
+        emit realTimeRidesFromStationRequested(request, arguments.at(0).value<PT2::Station>());
+        break;
+    case RealTime_SuggestLineFromStringType:
+        emit realTimeSuggestedLinesRequested(request, arguments.at(0).value<QString>());
+        break;
+    default:
+        break;
+    }
+}
+
 }
 
 #include "dbusbackendwrapper.moc"
@@ -143,7 +143,16 @@ Q_SIGNALS:
      * @param partialLine partial line name.
      */
     void realTimeSuggestedLinesRequested(const QString &request, const QString &partialLine);
-
+protected:
+    /**
+     * @brief Reimplementation of sendQueuedRequest
+     *
+     * @param request request identifier.
+     * @param requestType request type.
+     * @param arguments arguments of the request.
+     */
+    void sendQueuedRequest(const QString &request, RequestType requestType,
+                           const QVariantList &arguments);
 private:
     Q_DECLARE_PRIVATE(DBusBackendWrapper)
 };
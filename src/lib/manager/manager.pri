@@ -4,14 +4,18 @@ HEADERS += $$PWD/abstractbackendwrapper.h \
     $$PWD/abstractbackendmanager.h \
     $$PWD/dbusbackendmanager.h \
     $$PWD/backendinfo.h \
-    $$PWD/backendlistmanager.h
+    $$PWD/backendlistmanager.h \
+    $$PWD/resultcache.h \
+    $$PWD/stationhistory.h
 
 SOURCES += $$PWD/abstractbackendwrapper.cpp \
     $$PWD/dbusbackendwrapper.cpp \
     $$PWD/abstractbackendmanager.cpp \
     $$PWD/dbusbackendmanager.cpp \
     $$PWD/backendinfo.cpp \
-    $$PWD/backendlistmanager.cpp
+    $$PWD/backendlistmanager.cpp \
+    $$PWD/resultcache.cpp \
+    $$PWD/stationhistory.cpp
 
 manager_headers.files = $$PWD/*.h
 manager_headers.path = $${INCLUDEDIR}/manager
@@ -0,0 +1,758 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+/**
+ * @file resultcache.cpp
+ * @short Implementation of PT2::ResultCache
+ */
+
+#include "resultcache.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QLockFile>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QtEndian>
+
+#include "debug.h"
+#include "base/company.h"
+#include "base/companynodedata.h"
+#include "base/line.h"
+#include "base/linenodedata.h"
+#include "base/ride.h"
+#include "base/ridenodedata.h"
+#include "base/station.h"
+
+namespace PT2
+{
+
+/**
+ * @internal
+ * @brief Magic number of the cache file
+ */
+static const quint32 CACHE_MAGIC = 0x50543252;
+/**
+ * @internal
+ * @brief Version of the cache file
+ *
+ * Should be incremented when the format of the records,
+ * or the serialization of the results changes.
+ */
+static const quint32 CACHE_VERSION = 1;
+/**
+ * @internal
+ * @brief Size of the header of the cache file
+ */
+static const qint64 HEADER_SIZE = 8;
+/**
+ * @internal
+ * @brief Age after which results are dropped, in milliseconds
+ */
+static const qint64 MAX_AGE = Q_INT64_C(2592000000);
+/**
+ * @internal
+ * @brief Age after which rides from station are dropped, in milliseconds
+ *
+ * Rides from station are real time informations, and are
+ * only displayed while stale for a few minutes.
+ */
+static const qint64 RIDES_MAX_AGE = Q_INT64_C(300000);
+/**
+ * @internal
+ * @brief Time to wait for the lock of the cache file, in milliseconds
+ */
+static const int LOCK_TIMEOUT = 1000;
+/**
+ * @internal
+ * @brief Minimum number of replaced records before compacting the file
+ */
+static const int COMPACT_THRESHOLD = 64;
+/**
+ * @internal
+ * @brief Default time to live of suggested stations and lines, in milliseconds
+ */
+static const int SUGGESTIONS_TIME_TO_LIVE = 86400000;
+/**
+ * @internal
+ * @brief Default time to live of rides from station, in milliseconds
+ */
+static const int RIDES_TIME_TO_LIVE = 60000;
+
+/**
+ * @internal
+ * @brief Entry of PT2::ResultCache
+ */
+struct ResultCacheEntry
+{
+    /**
+     * @internal
+     * @brief Request type
+     */
+    qint32 requestType;
+    /**
+     * @internal
+     * @brief Time when the result was stored, in milliseconds since epoch
+     */
+    qint64 stored;
+    /**
+     * @internal
+     * @brief Time to live, in milliseconds
+     */
+    qint32 timeToLive;
+    /**
+     * @internal
+     * @brief Offset of the record in the mapped file
+     */
+    qint64 recordOffset;
+    /**
+     * @internal
+     * @brief Size of the record, with its size
+     */
+    qint64 recordSize;
+    /**
+     * @internal
+     * @brief Offset of the serialized result in the mapped file
+     */
+    qint64 dataOffset;
+    /**
+     * @internal
+     * @brief Size of the serialized result
+     */
+    qint64 dataSize;
+    /**
+     * @internal
+     * @brief If the result is stored in memory, and not in the mapped file
+     */
+    bool inMemory;
+    /**
+     * @internal
+     * @brief Result, if it is stored in memory
+     */
+    QVariant result;
+};
+
+/**
+ * @internal
+ * @brief Private class for PT2::ResultCache
+ */
+struct ResultCachePrivate
+{
+    /**
+     * @internal
+     * @brief Default constructor
+     */
+    explicit ResultCachePrivate();
+    /**
+     * @internal
+     * @brief Path to the cache file of a backend
+     * @param identifier identifier of the backend.
+     * @return path to the cache file.
+     */
+    static QString cacheFile(const QString &identifier);
+    /**
+     * @internal
+     * @brief Open the cache file
+     *
+     * The cache file is locked while it is loaded.
+     */
+    void open();
+    /**
+     * @internal
+     * @brief Map the cache file, and read the keys
+     *
+     * The cache file should be locked.
+     */
+    void load();
+    /**
+     * @internal
+     * @brief Truncate the cache file, and write the header
+     *
+     * The cache file should be locked.
+     *
+     * @return if the header was written.
+     */
+    bool reset();
+    /**
+     * @internal
+     * @brief Rewrite the cache file with the used records only
+     *
+     * The cache file should be locked.
+     */
+    void compact();
+    /**
+     * @internal
+     * @brief Append a record to the cache file
+     *
+     * The cache file should be locked.
+     *
+     * @param record record.
+     * @return if the record was written.
+     */
+    bool append(const QByteArray &record);
+    /**
+     * @internal
+     * @brief Identifier
+     */
+    QString identifier;
+    /**
+     * @internal
+     * @brief Cache file
+     */
+    QFile file;
+    /**
+     * @internal
+     * @brief If the cache file was opened
+     */
+    bool opened;
+    /**
+     * @internal
+     * @brief Mapped cache file
+     */
+    uchar *map;
+    /**
+     * @internal
+     * @brief Size of the mapped cache file
+     */
+    qint64 mapSize;
+    /**
+     * @internal
+     * @brief Entries, by key
+     */
+    QHash<QString, ResultCacheEntry> entries;
+};
+
+/**
+ * @internal
+ * @brief Write a transportation object
+ * @param stream stream to write to.
+ * @param object transportation object.
+ */
+static void writeObject(QDataStream &stream, const TransportationObject &object)
+{
+    stream << object.identifier() << object.internal() << object.name() << object.properties();
+}
+
+/**
+ * @internal
+ * @brief Read a transportation object
+ * @param stream stream to read from.
+ * @param object transportation object.
+ */
+static void readObject(QDataStream &stream, TransportationObject &object)
+{
+    QString identifier;
+    QVariantMap internal;
+    QString name;
+    QVariantMap properties;
+    stream >> identifier >> internal >> name >> properties;
+    object.setIdentifier(identifier);
+    object.setInternal(internal);
+    object.setName(name);
+    object.setProperties(properties);
+}
+
+/**
+ * @internal
+ * @brief Write a list of stations or lines
+ * @param stream stream to write to.
+ * @param objects stations or lines.
+ */
+template<class T> static void writeObjects(QDataStream &stream, const QList<T> &objects)
+{
+    stream << quint32(objects.count());
+    foreach (const T &object, objects) {
+        writeObject(stream, object);
+    }
+}
+
+/**
+ * @internal
+ * @brief Read a list of stations or lines
+ * @param stream stream to read from.
+ * @return stations or lines.
+ */
+template<class T> static QList<T> readObjects(QDataStream &stream)
+{
+    quint32 count;
+    stream >> count;
+    QList<T> objects;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        T object;
+        readObject(stream, object);
+        objects.append(object);
+    }
+    return objects;
+}
+
+/**
+ * @internal
+ * @brief Write rides from station
+ * @param stream stream to write to.
+ * @param rideList ride list.
+ */
+static void writeRides(QDataStream &stream, const QList<CompanyNodeData> &rideList)
+{
+    stream << quint32(rideList.count());
+    foreach (const CompanyNodeData &companyNodeData, rideList) {
+        writeObject(stream, companyNodeData.company());
+        QList<LineNodeData> lineNodeDataList = companyNodeData.lineNodeDataList();
+        stream << quint32(lineNodeDataList.count());
+        foreach (const LineNodeData &lineNodeData, lineNodeDataList) {
+            writeObject(stream, lineNodeData.line());
+            QList<RideNodeData> rideNodeDataList = lineNodeData.rideNodeDataList();
+            stream << quint32(rideNodeDataList.count());
+            foreach (const RideNodeData &rideNodeData, rideNodeDataList) {
+                writeObject(stream, rideNodeData.ride());
+                writeObjects(stream, rideNodeData.stationList());
+            }
+        }
+    }
+}
+
+/**
+ * @internal
+ * @brief Read rides from station
+ * @param stream stream to read from.
+ * @return ride list.
+ */
+static QList<CompanyNodeData> readRides(QDataStream &stream)
+{
+    QList<CompanyNodeData> rideList;
+    quint32 companyCount;
+    stream >> companyCount;
+    for (quint32 i = 0; i < companyCount && stream.status() == QDataStream::Ok; ++i) {
+        Company company;
+        readObject(stream, company);
+        QList<LineNodeData> lineNodeDataList;
+        quint32 lineCount;
+        stream >> lineCount;
+        for (quint32 j = 0; j < lineCount && stream.status() == QDataStream::Ok; ++j) {
+            Line line;
+            readObject(stream, line);
+            QList<RideNodeData> rideNodeDataList;
+            quint32 rideCount;
+            stream >> rideCount;
+            for (quint32 k = 0; k < rideCount && stream.status() == QDataStream::Ok; ++k) {
+                Ride ride;
+                readObject(stream, ride);
+                rideNodeDataList.append(RideNodeData(ride, readObjects<Station>(stream)));
+            }
+            lineNodeDataList.append(LineNodeData(line, rideNodeDataList));
+        }
+        rideList.append(CompanyNodeData(company, lineNodeDataList));
+    }
+    return rideList;
+}
+
+/**
+ * @internal
+ * @brief Write a result
+ * @param stream stream to write to.
+ * @param requestType request type.
+ * @param result result.
+ */
+static void writeResult(QDataStream &stream, AbstractBackendWrapper::RequestType requestType,
+                        const QVariant &result)
+{
+    switch (requestType) {
+    case AbstractBackendWrapper::RealTime_SuggestStationFromStringType:
+        writeObjects(stream, result.value<QList<Station> >());
+        break;
+    case AbstractBackendWrapper::RealTime_RidesFromStationType:
+        writeRides(stream, result.value<QList<CompanyNodeData> >());
+        break;
+    case AbstractBackendWrapper::RealTime_SuggestLineFromStringType:
+        writeObjects(stream, result.value<QList<Line> >());
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @internal
+ * @brief Read a result
+ * @param stream stream to read from.
+ * @param requestType request type.
+ * @return result.
+ */
+static QVariant readResult(QDataStream &stream, AbstractBackendWrapper::RequestType requestType)
+{
+    switch (requestType) {
+    case AbstractBackendWrapper::RealTime_SuggestStationFromStringType:
+        return QVariant::fromValue(readObjects<Station>(stream));
+        break;
+    case AbstractBackendWrapper::RealTime_RidesFromStationType:
+        return QVariant::fromValue(readRides(stream));
+        break;
+    case AbstractBackendWrapper::RealTime_SuggestLineFromStringType:
+        return QVariant::fromValue(readObjects<Line>(stream));
+        break;
+    default:
+        return QVariant();
+        break;
+    }
+}
+
+/**
+ * @internal
+ * @brief Age after which results are dropped
+ * @param requestType request type.
+ * @return maximum age, in milliseconds.
+ */
+static qint64 maxAge(qint32 requestType)
+{
+    switch (requestType) {
+    case AbstractBackendWrapper::RealTime_RidesFromStationType:
+        return RIDES_MAX_AGE;
+        break;
+    default:
+        return MAX_AGE;
+        break;
+    }
+}
+
+ResultCachePrivate::ResultCachePrivate()
+{
+    opened = false;
+    map = 0;
+    mapSize = 0;
+}
+
+QString ResultCachePrivate::cacheFile(const QString &identifier)
+{
+    QByteArray hash = QCryptographicHash::hash(identifier.toUtf8(), QCryptographicHash::Md5);
+    QDir dir (QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+    return dir.absoluteFilePath(QString("pt2/results/%1.cache").arg(QString(hash.toHex())));
+}
+
+void ResultCachePrivate::open()
+{
+    opened = true;
+    QString path = cacheFile(identifier);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    file.setFileName(path);
+
+    // The cache file is shared with the other processes using the backend
+    QLockFile lock (path + ".lock");
+    if (!lock.tryLock(LOCK_TIMEOUT)) {
+        warning("result-cache") << "Failed to lock cache" << path;
+        return;
+    }
+    load();
+}
+
+void ResultCachePrivate::load()
+{
+    if (!file.open(QIODevice::ReadWrite)) {
+        warning("result-cache") << "Failed to open cache" << file.fileName();
+        return;
+    }
+
+    QDataStream headerStream (file.read(HEADER_SIZE));
+    headerStream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic;
+    quint32 version;
+    headerStream >> magic >> version;
+    if (headerStream.status() != QDataStream::Ok || magic != CACHE_MAGIC
+        || version != CACHE_VERSION) {
+        debug("result-cache") << "Discarding outdated cache for" << identifier;
+        reset();
+        return;
+    }
+
+    mapSize = file.size();
+    map = file.map(0, mapSize);
+    if (!map) {
+        warning("result-cache") << "Failed to map cache" << file.fileName();
+        mapSize = 0;
+        return;
+    }
+
+    // Only the keys are read, results are read when they are found
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    int unusedRecords = 0;
+    qint64 offset = HEADER_SIZE;
+    while (offset + 4 <= mapSize) {
+        qint64 size = qFromBigEndian<quint32>(map + offset);
+        if (offset + 4 + size > mapSize) {
+            break;
+        }
+
+        QByteArray record = QByteArray::fromRawData(reinterpret_cast<const char *>(map + offset + 4),
+                                                    size);
+        QDataStream stream (record);
+        stream.setVersion(QDataStream::Qt_5_0);
+        QString key;
+        ResultCacheEntry entry;
+        stream >> key >> entry.requestType >> entry.stored >> entry.timeToLive;
+        if (stream.status() != QDataStream::Ok) {
+            break;
+        }
+
+        entry.recordOffset = offset;
+        entry.recordSize = 4 + size;
+        entry.dataOffset = offset + 4 + stream.device()->pos();
+        entry.dataSize = size - stream.device()->pos();
+        entry.inMemory = false;
+        if (entries.contains(key)) {
+            ++unusedRecords;
+            entries.remove(key);
+        }
+        if (now - entry.stored < maxAge(entry.requestType)) {
+            entries.insert(key, entry);
+        } else {
+            ++unusedRecords;
+        }
+        offset += 4 + size;
+    }
+
+    debug("result-cache") << "Loaded" << entries.count() << "keys for" << identifier;
+
+    // A record might have been partially written
+    if (offset != mapSize) {
+        warning("result-cache") << "Cache for" << identifier << "is truncated";
+        compact();
+    } else if (unusedRecords > COMPACT_THRESHOLD && unusedRecords > entries.count()) {
+        compact();
+    }
+}
+
+bool ResultCachePrivate::reset()
+{
+    if (map) {
+        file.unmap(map);
+        map = 0;
+        mapSize = 0;
+    }
+    entries.clear();
+
+    // The cache file might have been replaced by another process
+    file.close();
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        warning("result-cache") << "Failed to open cache" << file.fileName();
+        return false;
+    }
+
+    QByteArray header;
+    QDataStream stream (&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << CACHE_MAGIC << CACHE_VERSION;
+    return file.write(header) == HEADER_SIZE;
+}
+
+void ResultCachePrivate::compact()
+{
+    debug("result-cache") << "Compacting cache for" << identifier;
+    QSaveFile saveFile (file.fileName());
+    if (!saveFile.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QByteArray header;
+    QDataStream stream (&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << CACHE_MAGIC << CACHE_VERSION;
+    saveFile.write(header);
+    foreach (const ResultCacheEntry &entry, entries) {
+        saveFile.write(reinterpret_cast<const char *>(map + entry.recordOffset), entry.recordSize);
+    }
+
+    file.unmap(map);
+    map = 0;
+    mapSize = 0;
+    file.close();
+    entries.clear();
+    if (!saveFile.commit()) {
+        warning("result-cache") << "Failed to compact cache for" << identifier;
+        reset();
+        return;
+    }
+    load();
+}
+
+bool ResultCachePrivate::append(const QByteArray &record)
+{
+    // The file is opened again, since it might have been compacted,
+    // and replaced, by another process
+    QFile appendFile (file.fileName());
+    if (!appendFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+    return appendFile.write(record) == record.size();
+}
+
+////// End of private class //////
+
+ResultCache::ResultCache(const QString &identifier):
+    d_ptr(new ResultCachePrivate)
+{
+    Q_D(ResultCache);
+    d->identifier = identifier;
+}
+
+ResultCache::~ResultCache()
+{
+}
+
+QString ResultCache::identifier() const
+{
+    Q_D(const ResultCache);
+    return d->identifier;
+}
+
+QString ResultCache::key(AbstractBackendWrapper::RequestType requestType,
+                         const QVariantList &arguments)
+{
+    QStringList key;
+    key.append(QString::number(requestType));
+    foreach (const QVariant &argument, arguments) {
+        if (argument.userType() == qMetaTypeId<Station>()) {
+            key.append(argument.value<Station>().identifier());
+        } else {
+            key.append(argument.toString());
+        }
+    }
+    return key.join("/");
+}
+
+int ResultCache::defaultTimeToLive(AbstractBackendWrapper::RequestType requestType)
+{
+    switch (requestType) {
+    case AbstractBackendWrapper::RealTime_RidesFromStationType:
+        return RIDES_TIME_TO_LIVE;
+        break;
+    default:
+        return SUGGESTIONS_TIME_TO_LIVE;
+        break;
+    }
+}
+
+ResultCache::Freshness ResultCache::find(const QString &key, QVariant &result)
+{
+    Q_D(ResultCache);
+    if (!d->opened) {
+        d->open();
+    }
+
+    if (!d->entries.contains(key)) {
+        return Missing;
+    }
+
+    const ResultCacheEntry &entry = d->entries[key];
+    AbstractBackendWrapper::RequestType requestType
+            = static_cast<AbstractBackendWrapper::RequestType>(entry.requestType);
+    qint64 age = QDateTime::currentMSecsSinceEpoch() - entry.stored;
+    if (age >= maxAge(requestType)) {
+        return Missing;
+    }
+
+    if (entry.inMemory) {
+        result = entry.result;
+    } else {
+        QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(d->map + entry.dataOffset),
+                                                  entry.dataSize);
+        QDataStream stream (data);
+        stream.setVersion(QDataStream::Qt_5_0);
+        result = readResult(stream, requestType);
+        if (stream.status() != QDataStream::Ok) {
+            warning("result-cache") << "Ignoring corrupted result" << key;
+            d->entries.remove(key);
+            return Missing;
+        }
+    }
+
+    return age < entry.timeToLive ? Fresh : Stale;
+}
+
+void ResultCache::insert(const QString &key, AbstractBackendWrapper::RequestType requestType,
+                         const QVariant &result, int timeToLive)
+{
+    Q_D(ResultCache);
+    if (!d->opened) {
+        d->open();
+    }
+
+    ResultCacheEntry entry;
+    entry.requestType = requestType;
+    entry.stored = QDateTime::currentMSecsSinceEpoch();
+    entry.timeToLive = timeToLive;
+    entry.recordOffset = 0;
+    entry.recordSize = 0;
+    entry.dataOffset = 0;
+    entry.dataSize = 0;
+    entry.inMemory = true;
+    entry.result = result;
+    d->entries.insert(key, entry);
+
+    if (!d->file.isOpen()) {
+        return;
+    }
+
+    // Records are appended after the mapped part of the file
+    QByteArray record;
+    QDataStream stream (&record, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << quint32(0) << key << entry.requestType << entry.stored << entry.timeToLive;
+    writeResult(stream, requestType, result);
+    qToBigEndian<quint32>(record.size() - 4, reinterpret_cast<uchar *>(record.data()));
+
+    QLockFile lock (d->file.fileName() + ".lock");
+    if (!lock.tryLock(LOCK_TIMEOUT) || !d->append(record)) {
+        warning("result-cache") << "Failed to write result" << key;
+    }
+}
+
+void ResultCache::clear()
+{
+    Q_D(ResultCache);
+    if (!d->opened) {
+        d->open();
+    }
+
+    if (d->file.isOpen()) {
+        QLockFile lock (d->file.fileName() + ".lock");
+        if (lock.tryLock(LOCK_TIMEOUT)) {
+            d->reset();
+        } else {
+            warning("result-cache") << "Failed to lock cache for" << identifier();
+        }
+    }
+    d->entries.clear();
+}
+
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef PT2_RESULTCACHE_H
+#define PT2_RESULTCACHE_H
+
+/**
+ * @file resultcache.h
+ * @short Definition of PT2::ResultCache
+ */
+
+#include "pt2_global.h"
+
+#include <QtCore/QScopedPointer>
+#include <QtCore/QVariant>
+
+#include "manager/abstractbackendwrapper.h"
+
+namespace PT2
+{
+
+struct ResultCachePrivate;
+/**
+ * @brief Persistent cache of the results of a backend
+ *
+ * This class is used to store the results of the requests sent
+ * to a backend on disk, so that they can be reused after the
+ * application is restarted. Each backend have its own cache file,
+ * and the results are identified by a key, that is built from the
+ * request type and the arguments of the request with key().
+ *
+ * Each result is stored with a time to live. find() tells if a
+ * result is fresh, and can be used instead of sending the request,
+ * or stale, and can be displayed while the request is sent again.
+ * Rides from station older than five minutes, and other results
+ * older than a month are dropped.
+ *
+ * \section resultCacheFormat File format
+ *
+ * The cache file starts with a magic number and a version, and
+ * is followed by records, that are only appended. A record contains
+ * its size, the key, the request type, the time when it was stored,
+ * the time to live, and the serialized result. When a key is stored
+ * twice, the last record is used.
+ *
+ * The file is mapped in memory when the cache is first used, and
+ * only the keys are read: results are read from the mapped file when
+ * they are found. Files with another version are discarded, and files
+ * that contain too many replaced records are compacted.
+ *
+ * The cache file of a backend is shared by every process that uses
+ * this backend. It is locked with a lock file while it is loaded,
+ * compacted or written.
+ */
+class PT2_EXPORT ResultCache
+{
+public:
+    /**
+     * @brief Enumeration describing the freshness of a result
+     */
+    enum Freshness {
+        /**
+         * @short The result is not cached
+         */
+        Missing,
+        /**
+         * @short The result is cached, and can be used
+         */
+        Fresh,
+        /**
+         * @short The result is cached, but should be requested again
+         */
+        Stale
+    };
+    /**
+     * @brief Default constructor
+     * @param identifier identifier of the backend.
+     */
+    explicit ResultCache(const QString &identifier);
+    /**
+     * @brief Destructor
+     */
+    virtual ~ResultCache();
+    /**
+     * @brief Identifier of the backend
+     * @return identifier of the backend.
+     */
+    QString identifier() const;
+    /**
+     * @brief Key of a request
+     * @param requestType request type.
+     * @param arguments arguments of the request.
+     * @return key of the request.
+     */
+    static QString key(AbstractBackendWrapper::RequestType requestType,
+                       const QVariantList &arguments);
+    /**
+     * @brief Default time to live of a result
+     *
+     * Suggested stations and lines rarely change, so they are kept
+     * for a day, while rides from station are real time informations
+     * that are only kept for a minute.
+     *
+     * @param requestType request type.
+     * @return time to live, in milliseconds.
+     */
+    static int defaultTimeToLive(AbstractBackendWrapper::RequestType requestType);
+    /**
+     * @brief Find a result
+     *
+     * The result is a QList<PT2::Station>, a QList<PT2::CompanyNodeData>
+     * or a QList<PT2::Line>, depending on the request type.
+     *
+     * @param key key of the request.
+     * @param[out] result cached result, if it is not missing.
+     * @return freshness of the result.
+     */
+    Freshness find(const QString &key, QVariant &result);
+    /**
+     * @brief Insert a result
+     * @param key key of the request.
+     * @param requestType request type.
+     * @param result result.
+     * @param timeToLive time to live, in milliseconds.
+     */
+    void insert(const QString &key, AbstractBackendWrapper::RequestType requestType,
+                const QVariant &result, int timeToLive);
+    /**
+     * @brief Clear the cache
+     */
+    void clear();
+protected:
+    /**
+     * @brief D-pointer
+     */
+    QScopedPointer<ResultCachePrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(ResultCache)
+};
+
+}
+
+#endif // PT2_RESULTCACHE_H
@@ -0,0 +1,428 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+/**
+ * @file stationhistory.cpp
+ * @short Implementation of PT2::StationHistory
+ */
+
+#include "stationhistory.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QtAlgorithms>
+#include <QtCore/qmath.h>
+
+#include "debug.h"
+#include "normalization.h"
+#include "base/station.h"
+
+namespace PT2
+{
+
+/**
+ * @internal
+ * @brief Magic number of the history file
+ */
+static const quint32 HISTORY_MAGIC = 0x50543248;
+/**
+ * @internal
+ * @brief Version of the history file
+ */
+static const quint32 HISTORY_VERSION = 1;
+/**
+ * @internal
+ * @brief Maximum number of stations in the history
+ */
+static const int MAX_ENTRIES = 100;
+/**
+ * @internal
+ * @brief Time after which the score of a station is halved, in milliseconds
+ */
+static const double HALF_LIFE = 1209600000.;
+
+/**
+ * @internal
+ * @brief Entry of PT2::StationHistory
+ */
+struct StationHistoryEntry
+{
+    /**
+     * @internal
+     * @brief Identifier of the backend that provided the station
+     */
+    QString backendIdentifier;
+    /**
+     * @internal
+     * @brief Station
+     */
+    Station station;
+    /**
+     * @internal
+     * @brief Station name, normalized for searching
+     */
+    QString normalizedName;
+    /**
+     * @internal
+     * @brief Score, when the station was last selected
+     */
+    double score;
+    /**
+     * @internal
+     * @brief Time when the station was last selected, in milliseconds since epoch
+     */
+    qint64 lastUsed;
+};
+
+/**
+ * @internal
+ * @brief Private class for PT2::StationHistory
+ */
+struct StationHistoryPrivate
+{
+    /**
+     * @internal
+     * @brief Default constructor
+     */
+    explicit StationHistoryPrivate();
+    /**
+     * @internal
+     * @brief Path to the history file
+     * @return path to the history file.
+     */
+    static QString historyFile();
+    /**
+     * @internal
+     * @brief Key of a station
+     * @param backendIdentifier identifier of the backend.
+     * @param station station.
+     * @return key of the station.
+     */
+    static QString key(const QString &backendIdentifier, const Station &station);
+    /**
+     * @internal
+     * @brief Decayed score of an entry
+     * @param entry entry.
+     * @param now current time, in milliseconds since epoch.
+     * @return decayed score.
+     */
+    static double score(const StationHistoryEntry &entry, qint64 now);
+    /**
+     * @internal
+     * @brief Load the history file if it was not loaded or was modified
+     */
+    void load();
+    /**
+     * @internal
+     * @brief Save the history file
+     */
+    void save();
+    /**
+     * @internal
+     * @brief Index the words of an entry
+     * @param key key of the entry.
+     */
+    void index(const QString &key);
+    /**
+     * @internal
+     * @brief Remove the words of an entry from the index
+     * @param key key of the entry.
+     */
+    void unindex(const QString &key);
+    /**
+     * @internal
+     * @brief If the history file was loaded
+     */
+    bool loaded;
+    /**
+     * @internal
+     * @brief Modification time of the history file, when it was loaded or saved
+     */
+    QDateTime lastModified;
+    /**
+     * @internal
+     * @brief Entries, by key
+     */
+    QHash<QString, StationHistoryEntry> entries;
+    /**
+     * @internal
+     * @brief Keys of the entries, by the part of their name that starts at each word
+     */
+    QMultiMap<QString, QString> wordIndex;
+};
+
+/**
+ * @internal
+ * @brief Positions of the words of a normalized name
+ * @param normalizedName normalized name.
+ * @return positions where words start.
+ */
+static QList<int> wordStarts(const QString &normalizedName)
+{
+    QList<int> starts;
+    for (int i = 0; i < normalizedName.count(); ++i) {
+        if (!normalizedName.at(i).isLetterOrNumber()) {
+            continue;
+        }
+        if (i == 0 || !normalizedName.at(i - 1).isLetterOrNumber()) {
+            starts.append(i);
+        }
+    }
+    return starts;
+}
+
+StationHistoryPrivate::StationHistoryPrivate()
+{
+    loaded = false;
+}
+
+QString StationHistoryPrivate::historyFile()
+{
+    QDir dir (QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation));
+    return dir.absoluteFilePath("pt2/stationhistory");
+}
+
+QString StationHistoryPrivate::key(const QString &backendIdentifier, const Station &station)
+{
+    return backendIdentifier + QLatin1Char('\n') + station.identifier();
+}
+
+double StationHistoryPrivate::score(const StationHistoryEntry &entry, qint64 now)
+{
+    qint64 elapsed = qMax<qint64>(0, now - entry.lastUsed);
+    return entry.score * qPow(0.5, elapsed / HALF_LIFE);
+}
+
+void StationHistoryPrivate::load()
+{
+    QFileInfo fileInfo (historyFile());
+    if (loaded && fileInfo.lastModified() == lastModified) {
+        return;
+    }
+
+    loaded = true;
+    lastModified = fileInfo.lastModified();
+    entries.clear();
+    wordIndex.clear();
+
+    QFile file (fileInfo.absoluteFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream (&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic;
+    quint32 version;
+    quint32 count;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != HISTORY_MAGIC
+        || version != HISTORY_VERSION) {
+        debug("station-history") << "Discarding outdated station history";
+        return;
+    }
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        StationHistoryEntry entry;
+        QString identifier;
+        QVariantMap internal;
+        QString name;
+        QVariantMap properties;
+        stream >> entry.backendIdentifier >> identifier >> internal >> name >> properties
+               >> entry.score >> entry.lastUsed;
+        if (stream.status() != QDataStream::Ok) {
+            break;
+        }
+
+        entry.station.setIdentifier(identifier);
+        entry.station.setInternal(internal);
+        entry.station.setName(name);
+        entry.station.setProperties(properties);
+        entry.normalizedName = normalizeForSearch(name);
+        QString entryKey = key(entry.backendIdentifier, entry.station);
+        entries.insert(entryKey, entry);
+        index(entryKey);
+    }
+
+    debug("station-history") << "Loaded" << entries.count() << "stations";
+}
+
+void StationHistoryPrivate::save()
+{
+    QString path = historyFile();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file (path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        warning("station-history") << "Failed to open station history" << path;
+        return;
+    }
+
+    QDataStream stream (&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << HISTORY_MAGIC << HISTORY_VERSION << quint32(entries.count());
+    foreach (const StationHistoryEntry &entry, entries) {
+        stream << entry.backendIdentifier << entry.station.identifier()
+               << entry.station.internal() << entry.station.name()
+               << entry.station.properties() << entry.score << entry.lastUsed;
+    }
+
+    if (!file.commit()) {
+        warning("station-history") << "Failed to save station history" << path;
+        return;
+    }
+    lastModified = QFileInfo(path).lastModified();
+}
+
+void StationHistoryPrivate::index(const QString &key)
+{
+    const QString &normalizedName = entries[key].normalizedName;
+    foreach (int start, wordStarts(normalizedName)) {
+        wordIndex.insert(normalizedName.mid(start), key);
+    }
+}
+
+void StationHistoryPrivate::unindex(const QString &key)
+{
+    const QString &normalizedName = entries[key].normalizedName;
+    foreach (int start, wordStarts(normalizedName)) {
+        wordIndex.remove(normalizedName.mid(start), key);
+    }
+}
+
+////// End of private class //////
+
+StationHistory::StationHistory():
+    d_ptr(new StationHistoryPrivate)
+{
+}
+
+StationHistory::~StationHistory()
+{
+}
+
+void StationHistory::record(const QString &backendIdentifier, const Station &station)
+{
+    Q_D(StationHistory);
+    if (backendIdentifier.isEmpty() || station.identifier().isEmpty()) {
+        return;
+    }
+
+    d->load();
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QString key = StationHistoryPrivate::key(backendIdentifier, station);
+    StationHistoryEntry entry;
+    entry.score = 0;
+    if (d->entries.contains(key)) {
+        entry.score = StationHistoryPrivate::score(d->entries.value(key), now);
+        d->unindex(key);
+    }
+
+    // The station is stored again, since its name might have changed
+    entry.backendIdentifier = backendIdentifier;
+    entry.station = station;
+    entry.normalizedName = normalizeForSearch(station.name());
+    entry.score += 1;
+    entry.lastUsed = now;
+    d->entries.insert(key, entry);
+    d->index(key);
+
+    // Only the best stations are kept
+    while (d->entries.count() > MAX_ENTRIES) {
+        QString worstKey;
+        double worstScore = 0;
+        QHash<QString, StationHistoryEntry>::const_iterator i;
+        for (i = d->entries.constBegin(); i != d->entries.constEnd(); ++i) {
+            double score = StationHistoryPrivate::score(i.value(), now);
+            if (i.key() != key && (worstKey.isEmpty() || score < worstScore)) {
+                worstKey = i.key();
+                worstScore = score;
+            }
+        }
+        d->unindex(worstKey);
+        d->entries.remove(worstKey);
+    }
+
+    d->save();
+}
+
+QList<QPair<QString, Station> > StationHistory::find(const QString &normalizedQuery, int limit)
+{
+    Q_D(StationHistory);
+    QList<QPair<QString, Station> > stations;
+    if (normalizedQuery.isEmpty() || limit == 0) {
+        return stations;
+    }
+
+    d->load();
+
+    // Names starting with the query, at any word, are
+    // stored after the query in the index
+    QSet<QString> keys;
+    QMultiMap<QString, QString>::const_iterator i = d->wordIndex.lowerBound(normalizedQuery);
+    while (i != d->wordIndex.constEnd() && i.key().startsWith(normalizedQuery)) {
+        keys.insert(i.value());
+        ++i;
+    }
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<QPair<double, QString> > scoredKeys;
+    foreach (const QString &key, keys) {
+        scoredKeys.append(qMakePair(StationHistoryPrivate::score(d->entries.value(key), now), key));
+    }
+    qSort(scoredKeys.begin(), scoredKeys.end(), qGreater<QPair<double, QString> >());
+
+    for (int j = 0; j < scoredKeys.count() && (limit < 0 || j < limit); ++j) {
+        const StationHistoryEntry &entry = d->entries[scoredKeys.at(j).second];
+        stations.append(qMakePair(entry.backendIdentifier, entry.station));
+    }
+    return stations;
+}
+
+void StationHistory::clear()
+{
+    Q_D(StationHistory);
+    d->entries.clear();
+    d->wordIndex.clear();
+    QFile::remove(StationHistoryPrivate::historyFile());
+    d->loaded = true;
+    d->lastModified = QDateTime();
+}
+
+}
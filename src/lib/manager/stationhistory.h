@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+#ifndef PT2_STATIONHISTORY_H
+#define PT2_STATIONHISTORY_H
+
+/**
+ * @file stationhistory.h
+ * @short Definition of PT2::StationHistory
+ */
+
+#include "pt2_global.h"
+
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QScopedPointer>
+
+namespace PT2
+{
+
+class Station;
+struct StationHistoryPrivate;
+/**
+ * @brief History of the selected stations
+ *
+ * This class stores the stations that were selected by the user,
+ * weighted by frequency and recency, so that searches can be
+ * completed locally, before any backend answers.
+ *
+ * Each time a station is selected with record(), its score is
+ * decayed by the time elapsed since it was last selected, and
+ * incremented. find() returns the stations whose name, or a word
+ * of the name, starts with a query, sorted by their decayed score.
+ * Only the best stations are kept.
+ *
+ * The history is stored on disk, and reloaded when another
+ * instance modified it.
+ */
+class PT2_EXPORT StationHistory
+{
+public:
+    /**
+     * @brief Default constructor
+     */
+    explicit StationHistory();
+    /**
+     * @brief Destructor
+     */
+    virtual ~StationHistory();
+    /**
+     * @brief Record a selected station
+     * @param backendIdentifier identifier of the backend that provided the station.
+     * @param station station.
+     */
+    void record(const QString &backendIdentifier, const Station &station);
+    /**
+     * @brief Find stations
+     * @param normalizedQuery query, normalized with normalizeForSearch().
+     * @param limit maximum number of stations, or -1 for all the stations.
+     * @return backend identifiers and stations, the most relevant first.
+     */
+    QList<QPair<QString, Station> > find(const QString &normalizedQuery, int limit = -1);
+    /**
+     * @brief Clear the history
+     */
+    void clear();
+protected:
+    /**
+     * @brief D-pointer
+     */
+    QScopedPointer<StationHistoryPrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(StationHistory)
+};
+
+}
+
+#endif // PT2_STATIONHISTORY_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef PT2_NORMALIZATION_H
+#define PT2_NORMALIZATION_H
+
+/**
+ * @file normalization.h
+ * @short String normalization used for searches
+ */
+
+#include <QtCore/QString>
+
+namespace PT2
+{
+
+/**
+ * @brief Normalize a string for searching
+ *
+ * This method lowers the case of the string and strips
+ * the diacritic marks, so that "Châtelet" and "chatelet"
+ * are normalized to the same string.
+ *
+ * Providers and models should use this method whenever
+ * they need to compare user input with station or line
+ * names, in order to share the same matching rules.
+ *
+ * @param string string to normalize.
+ * @return normalized string.
+ */
+inline QString normalizeForSearch(const QString &string)
+{
+    QString normalized = string.toLower().normalized(QString::NormalizationForm_KD);
+    QString out;
+    out.reserve(normalized.count());
+    for (int i = 0; i < normalized.count(); i++) {
+        // strip diacritic marks
+        if (normalized.at(i).category() != QChar::Mark_NonSpacing
+            && normalized.at(i).category() != QChar::Mark_SpacingCombining) {
+            out.append(normalized.at(i));
+        }
+    }
+    return out;
+}
+
+}
+
+#endif // PT2_NORMALIZATION_H
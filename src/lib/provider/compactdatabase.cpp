@@ -0,0 +1,852 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+/**
+ * @file compactdatabase.cpp
+ * @short Implementation of PT2::CompactDatabase
+ */
+
+#include "compactdatabase.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QPair>
+#include <QtCore/QSet>
+#include <QtCore/QtAlgorithms>
+#include <QtCore/QtEndian>
+
+#include "debug.h"
+#include "normalization.h"
+
+namespace PT2
+{
+
+/**
+ * @internal
+ * @brief Magic that starts a compact database file
+ */
+static const char *COMPACT_DATABASE_MAGIC = "PT2D";
+/**
+ * @internal
+ * @brief Version of the compact database format
+ */
+static const quint32 COMPACT_DATABASE_VERSION = 4;
+/**
+ * @internal
+ * @brief Size of the header, in bytes
+ */
+static const quint32 HEADER_SIZE = 68;
+/**
+ * @internal
+ * @brief Size of a station record, in bytes
+ */
+static const quint32 STATION_RECORD_SIZE = 28;
+/**
+ * @internal
+ * @brief Size of a line record, in bytes
+ */
+static const quint32 LINE_RECORD_SIZE = 24;
+/**
+ * @internal
+ * @brief Size of a ride record, in bytes
+ */
+static const quint32 RIDE_RECORD_SIZE = 24;
+/**
+ * @internal
+ * @brief Size of a line group record, in bytes
+ */
+static const quint32 GROUP_RECORD_SIZE = 12;
+/**
+ * @internal
+ * @brief Size of a link record, in bytes
+ */
+static const quint32 LINK_RECORD_SIZE = 12;
+
+/**
+ * @internal
+ * @brief Normalize a line code or name for searching
+ *
+ * Spaces are also removed, so that "RER B", "rerb" and "RERB"
+ * are normalized to the same string.
+ *
+ * @param string line code or name.
+ * @return normalized string.
+ */
+static inline QString normalizeLine(const QString &string)
+{
+    QString normalized = normalizeForSearch(string);
+    normalized.remove(QLatin1Char(' '));
+    return normalized;
+}
+
+/**
+ * @internal
+ * @brief Private class for PT2::CompactDatabase
+ */
+struct CompactDatabasePrivate
+{
+    /**
+     * @internal
+     * @brief Default constructor
+     */
+    explicit CompactDatabasePrivate();
+    /**
+     * @internal
+     * @brief Read an integer
+     * @param offset offset of the integer in the file.
+     * @return read integer.
+     */
+    inline quint32 read(quint32 offset) const;
+    /**
+     * @internal
+     * @brief Check if a table fits in the file
+     * @param offset offset of the table.
+     * @param count number of records.
+     * @param recordSize size of a record.
+     * @return if the table fits in the file.
+     */
+    bool checkTable(quint32 offset, quint32 count, quint32 recordSize) const;
+    /**
+     * @internal
+     * @brief Raw string
+     *
+     * The returned byte array do not copy the data, and is only
+     * valid while the file is mapped.
+     *
+     * @param offset offset of the string reference (offset and length).
+     * @return raw UTF-8 string.
+     */
+    QByteArray rawString(quint32 offset) const;
+    /**
+     * @internal
+     * @brief String
+     * @param offset offset of the string reference (offset and length).
+     * @return decoded string.
+     */
+    QString string(quint32 offset) const;
+    /**
+     * @internal
+     * @brief Offset of a station record
+     * @param station station index.
+     * @return offset of the station record.
+     */
+    inline quint32 stationOffset(int station) const;
+    /**
+     * @internal
+     * @brief Offset of a line record
+     * @param line line index.
+     * @return offset of the line record.
+     */
+    inline quint32 lineOffset(int line) const;
+    /**
+     * @internal
+     * @brief Offset of a ride record
+     * @param ride ride index.
+     * @return offset of the ride record.
+     */
+    inline quint32 rideOffset(int ride) const;
+    /**
+     * @internal
+     * @brief Offset of the line group record for a station
+     * @param station station index.
+     * @param lineIndex index of the line group for this station.
+     * @return offset of the line group record, or 0 if not found.
+     */
+    quint32 groupOffset(int station, int lineIndex) const;
+    /**
+     * @internal
+     * @brief Offset of the link record for a line group of a station
+     * @param station station index.
+     * @param lineIndex index of the line group for this station.
+     * @param index index of the link for this line group.
+     * @return offset of the link record, or 0 if not found.
+     */
+    quint32 linkOffset(int station, int lineIndex, int index) const;
+    /**
+     * @internal
+     * @brief Station at a given position in the prefix index
+     * @param position position in the prefix index.
+     * @return index of the station, or -1 if the entry is out of the station table.
+     */
+    int indexedStation(quint32 position) const;
+    /**
+     * @internal
+     * @brief Normalized name of the station at a given position in the prefix index
+     * @param position position in the prefix index.
+     * @return raw normalized name.
+     */
+    QByteArray indexedName(quint32 position) const;
+    /**
+     * @internal
+     * @brief First position in the prefix index that is not lesser than a string
+     * @param key string to search.
+     * @return position in the prefix index.
+     */
+    quint32 lowerBound(const QByteArray &key) const;
+    /**
+     * @internal
+     * @brief Build the line index
+     */
+    void buildLineIndex();
+    /**
+     * @internal
+     * @brief File
+     */
+    QFile file;
+    /**
+     * @internal
+     * @brief Mapped data
+     */
+    const uchar *data;
+    /**
+     * @internal
+     * @brief Size of the mapped data
+     */
+    qint64 size;
+    /**
+     * @internal
+     * @brief Offset of the string table
+     */
+    quint32 stringTableOffset;
+    /**
+     * @internal
+     * @brief Size of the string table
+     */
+    quint32 stringTableSize;
+    /**
+     * @internal
+     * @brief Number of stations
+     */
+    quint32 stationCount;
+    /**
+     * @internal
+     * @brief Offset of the station table
+     */
+    quint32 stationTableOffset;
+    /**
+     * @internal
+     * @brief Number of lines
+     */
+    quint32 lineCount;
+    /**
+     * @internal
+     * @brief Offset of the line table
+     */
+    quint32 lineTableOffset;
+    /**
+     * @internal
+     * @brief Number of rides
+     */
+    quint32 rideCount;
+    /**
+     * @internal
+     * @brief Offset of the ride table
+     */
+    quint32 rideTableOffset;
+    /**
+     * @internal
+     * @brief Number of line groups
+     */
+    quint32 groupCount;
+    /**
+     * @internal
+     * @brief Offset of the line group table
+     */
+    quint32 groupTableOffset;
+    /**
+     * @internal
+     * @brief Number of links
+     */
+    quint32 linkCount;
+    /**
+     * @internal
+     * @brief Offset of the link table
+     */
+    quint32 linkTableOffset;
+    /**
+     * @internal
+     * @brief Number of entries in the line station table
+     */
+    quint32 lineStationCount;
+    /**
+     * @internal
+     * @brief Offset of the line station table
+     */
+    quint32 lineStationTableOffset;
+    /**
+     * @internal
+     * @brief Offset of the prefix index
+     */
+    quint32 prefixIndexOffset;
+    /**
+     * @internal
+     * @brief Line index
+     *
+     * This index contains the normalized codes and names
+     * of the lines, associated to the line indexes, and
+     * is sorted by normalized code or name.
+     */
+    QList<QPair<QString, int> > lineIndex;
+};
+
+CompactDatabasePrivate::CompactDatabasePrivate()
+    : data(0), size(0), stringTableOffset(0), stringTableSize(0), stationCount(0)
+    , stationTableOffset(0), lineCount(0), lineTableOffset(0), rideCount(0), rideTableOffset(0)
+    , groupCount(0), groupTableOffset(0), linkCount(0), linkTableOffset(0), lineStationCount(0)
+    , lineStationTableOffset(0), prefixIndexOffset(0)
+{
+}
+
+quint32 CompactDatabasePrivate::read(quint32 offset) const
+{
+    return qFromLittleEndian<quint32>(data + offset);
+}
+
+bool CompactDatabasePrivate::checkTable(quint32 offset, quint32 count, quint32 recordSize) const
+{
+    return (qint64(offset) + qint64(count) * recordSize <= size);
+}
+
+QByteArray CompactDatabasePrivate::rawString(quint32 offset) const
+{
+    quint32 stringOffset = read(offset);
+    quint32 stringLength = read(offset + 4);
+    if (qint64(stringOffset) + stringLength > stringTableSize) {
+        return QByteArray();
+    }
+
+    const char *string = reinterpret_cast<const char *>(data + stringTableOffset + stringOffset);
+    return QByteArray::fromRawData(string, stringLength);
+}
+
+QString CompactDatabasePrivate::string(quint32 offset) const
+{
+    quint32 stringOffset = read(offset);
+    quint32 stringLength = read(offset + 4);
+    if (qint64(stringOffset) + stringLength > stringTableSize) {
+        return QString();
+    }
+
+    const char *string = reinterpret_cast<const char *>(data + stringTableOffset + stringOffset);
+    return QString::fromUtf8(string, stringLength);
+}
+
+quint32 CompactDatabasePrivate::stationOffset(int station) const
+{
+    return stationTableOffset + station * STATION_RECORD_SIZE;
+}
+
+quint32 CompactDatabasePrivate::lineOffset(int line) const
+{
+    return lineTableOffset + line * LINE_RECORD_SIZE;
+}
+
+quint32 CompactDatabasePrivate::rideOffset(int ride) const
+{
+    return rideTableOffset + ride * RIDE_RECORD_SIZE;
+}
+
+quint32 CompactDatabasePrivate::groupOffset(int station, int lineIndex) const
+{
+    if (station < 0 || quint32(station) >= stationCount) {
+        return 0;
+    }
+
+    quint32 firstGroup = read(stationOffset(station) + 16);
+    quint32 count = read(stationOffset(station) + 20);
+    if (lineIndex < 0 || quint32(lineIndex) >= count
+        || qint64(firstGroup) + lineIndex >= groupCount) {
+        return 0;
+    }
+
+    return groupTableOffset + (firstGroup + lineIndex) * GROUP_RECORD_SIZE;
+}
+
+quint32 CompactDatabasePrivate::linkOffset(int station, int lineIndex, int index) const
+{
+    quint32 offset = groupOffset(station, lineIndex);
+    if (offset == 0) {
+        return 0;
+    }
+
+    quint32 firstLink = read(offset + 4);
+    quint32 count = read(offset + 8);
+    if (index < 0 || quint32(index) >= count || qint64(firstLink) + index >= linkCount) {
+        return 0;
+    }
+
+    return linkTableOffset + (firstLink + index) * LINK_RECORD_SIZE;
+}
+
+int CompactDatabasePrivate::indexedStation(quint32 position) const
+{
+    quint32 station = read(prefixIndexOffset + position * 4);
+    if (station >= stationCount) {
+        return -1;
+    }
+    return station;
+}
+
+QByteArray CompactDatabasePrivate::indexedName(quint32 position) const
+{
+    int station = indexedStation(position);
+    if (station == -1) {
+        return QByteArray();
+    }
+    return rawString(stationOffset(station) + 8);
+}
+
+quint32 CompactDatabasePrivate::lowerBound(const QByteArray &key) const
+{
+    quint32 first = 0;
+    quint32 count = stationCount;
+    while (count > 0) {
+        quint32 step = count / 2;
+        quint32 middle = first + step;
+        if (indexedName(middle) < key) {
+            first = middle + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+void CompactDatabasePrivate::buildLineIndex()
+{
+    lineIndex.clear();
+    lineIndex.reserve(lineCount * 2);
+    for (quint32 i = 0; i < lineCount; ++i) {
+        lineIndex.append(qMakePair(normalizeLine(string(lineOffset(i))), int(i)));
+        lineIndex.append(qMakePair(normalizeLine(string(lineOffset(i) + 8)), int(i)));
+    }
+    qSort(lineIndex);
+}
+
+////// End of private class //////
+
+CompactDatabase::CompactDatabase()
+    : d_ptr(new CompactDatabasePrivate())
+{
+}
+
+CompactDatabase::~CompactDatabase()
+{
+    close();
+}
+
+bool CompactDatabase::open(const QString &fileName)
+{
+    Q_D(CompactDatabase);
+    close();
+
+    d->file.setFileName(fileName);
+    if (!d->file.open(QIODevice::ReadOnly)) {
+        warning("compact-database") << "Failed to open" << fileName;
+        return false;
+    }
+
+    d->size = d->file.size();
+    if (d->size < HEADER_SIZE) {
+        warning("compact-database") << fileName << "is too small to be a database";
+        close();
+        return false;
+    }
+
+    d->data = d->file.map(0, d->size);
+    if (!d->data) {
+        warning("compact-database") << "Failed to map" << fileName;
+        close();
+        return false;
+    }
+
+    if (qstrncmp(reinterpret_cast<const char *>(d->data), COMPACT_DATABASE_MAGIC, 4) != 0
+        || d->read(4) != COMPACT_DATABASE_VERSION) {
+        warning("compact-database") << fileName << "is not a supported database";
+        close();
+        return false;
+    }
+
+    d->stringTableOffset = d->read(8);
+    d->stringTableSize = d->read(12);
+    d->stationCount = d->read(16);
+    d->stationTableOffset = d->read(20);
+    d->lineCount = d->read(24);
+    d->lineTableOffset = d->read(28);
+    d->rideCount = d->read(32);
+    d->rideTableOffset = d->read(36);
+    d->groupCount = d->read(40);
+    d->groupTableOffset = d->read(44);
+    d->linkCount = d->read(48);
+    d->linkTableOffset = d->read(52);
+    d->lineStationCount = d->read(56);
+    d->lineStationTableOffset = d->read(60);
+    d->prefixIndexOffset = d->read(64);
+
+    if (!d->checkTable(d->stringTableOffset, d->stringTableSize, 1)
+        || !d->checkTable(d->stationTableOffset, d->stationCount, STATION_RECORD_SIZE)
+        || !d->checkTable(d->lineTableOffset, d->lineCount, LINE_RECORD_SIZE)
+        || !d->checkTable(d->rideTableOffset, d->rideCount, RIDE_RECORD_SIZE)
+        || !d->checkTable(d->groupTableOffset, d->groupCount, GROUP_RECORD_SIZE)
+        || !d->checkTable(d->linkTableOffset, d->linkCount, LINK_RECORD_SIZE)
+        || !d->checkTable(d->lineStationTableOffset, d->lineStationCount, 4)
+        || !d->checkTable(d->prefixIndexOffset, d->stationCount, 4)) {
+        warning("compact-database") << fileName << "is corrupted";
+        close();
+        return false;
+    }
+
+    d->buildLineIndex();
+
+    debug("compact-database") << "Opened" << fileName << "with" << d->stationCount
+                              << "stations," << d->lineCount << "lines and" << d->rideCount
+                              << "rides";
+    return true;
+}
+
+void CompactDatabase::close()
+{
+    Q_D(CompactDatabase);
+    if (d->data) {
+        d->file.unmap(const_cast<uchar *>(d->data));
+    }
+    d->file.close();
+    d->data = 0;
+    d->size = 0;
+    d->stationCount = 0;
+    d->lineCount = 0;
+    d->rideCount = 0;
+    d->groupCount = 0;
+    d->linkCount = 0;
+    d->lineStationCount = 0;
+    d->lineIndex.clear();
+}
+
+bool CompactDatabase::isOpen() const
+{
+    Q_D(const CompactDatabase);
+    return d->data != 0;
+}
+
+int CompactDatabase::stationCount() const
+{
+    Q_D(const CompactDatabase);
+    return d->stationCount;
+}
+
+QString CompactDatabase::stationName(int station) const
+{
+    Q_D(const CompactDatabase);
+    if (station < 0 || quint32(station) >= d->stationCount) {
+        return QString();
+    }
+    return d->string(d->stationOffset(station));
+}
+
+int CompactDatabase::stationIdentifier(int station) const
+{
+    Q_D(const CompactDatabase);
+    if (station < 0 || quint32(station) >= d->stationCount) {
+        return -1;
+    }
+    return d->read(d->stationOffset(station) + 24);
+}
+
+int CompactDatabase::stationFromIdentifier(int identifier) const
+{
+    Q_D(const CompactDatabase);
+    if (identifier < 0) {
+        return -1;
+    }
+
+    // Stations are sorted by identifier
+    quint32 first = 0;
+    quint32 count = d->stationCount;
+    while (count > 0) {
+        quint32 step = count / 2;
+        quint32 middle = first + step;
+        if (d->read(d->stationOffset(middle) + 24) < quint32(identifier)) {
+            first = middle + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    if (first >= d->stationCount || d->read(d->stationOffset(first) + 24) != quint32(identifier)) {
+        return -1;
+    }
+    return first;
+}
+
+QList<int> CompactDatabase::stationsStartingWith(const QString &partialName) const
+{
+    Q_D(const CompactDatabase);
+    QList<int> stations;
+    QByteArray key = normalizeForSearch(partialName).toUtf8();
+
+    for (quint32 i = d->lowerBound(key); i < d->stationCount; ++i) {
+        if (!d->indexedName(i).startsWith(key)) {
+            break;
+        }
+
+        // An empty key matches the entries of a corrupted index too
+        int station = d->indexedStation(i);
+        if (station != -1) {
+            stations.append(station);
+        }
+    }
+
+    return stations;
+}
+
+QList<int> CompactDatabase::searchStations(const QString &partialName) const
+{
+    Q_D(const CompactDatabase);
+    QList<int> stations = stationsStartingWith(partialName);
+    QByteArray key = normalizeForSearch(partialName).toUtf8();
+
+    for (quint32 i = 0; i < d->stationCount; ++i) {
+        QByteArray name = d->indexedName(i);
+        if (!name.startsWith(key) && name.contains(key)) {
+            stations.append(d->indexedStation(i));
+        }
+    }
+
+    return stations;
+}
+
+int CompactDatabase::lineCount() const
+{
+    Q_D(const CompactDatabase);
+    return d->lineCount;
+}
+
+QString CompactDatabase::lineCode(int line) const
+{
+    Q_D(const CompactDatabase);
+    if (line < 0 || quint32(line) >= d->lineCount) {
+        return QString();
+    }
+    return d->string(d->lineOffset(line));
+}
+
+QString CompactDatabase::lineName(int line) const
+{
+    Q_D(const CompactDatabase);
+    if (line < 0 || quint32(line) >= d->lineCount) {
+        return QString();
+    }
+    return d->string(d->lineOffset(line) + 8);
+}
+
+int CompactDatabase::lineStationCount(int line) const
+{
+    Q_D(const CompactDatabase);
+    if (line < 0 || quint32(line) >= d->lineCount) {
+        return 0;
+    }
+    return d->read(d->lineOffset(line) + 20);
+}
+
+int CompactDatabase::lineStation(int line, int index) const
+{
+    Q_D(const CompactDatabase);
+    if (line < 0 || quint32(line) >= d->lineCount) {
+        return -1;
+    }
+
+    quint32 firstStation = d->read(d->lineOffset(line) + 16);
+    quint32 count = d->read(d->lineOffset(line) + 20);
+    if (index < 0 || quint32(index) >= count
+        || qint64(firstStation) + index >= d->lineStationCount) {
+        return -1;
+    }
+
+    quint32 station = d->read(d->lineStationTableOffset + (firstStation + index) * 4);
+    if (station >= d->stationCount) {
+        return -1;
+    }
+    return station;
+}
+
+QList<int> CompactDatabase::searchLines(const QString &partialLine) const
+{
+    Q_D(const CompactDatabase);
+    QList<int> lines;
+    QString key = normalizeLine(partialLine);
+    if (key.isEmpty()) {
+        return lines;
+    }
+
+    // Exact matches on code or name first, then prefix matches,
+    // both sorted by normalized code or name
+    QList<int> prefixLines;
+    QList<QPair<QString, int> >::const_iterator i
+            = qLowerBound(d->lineIndex.constBegin(), d->lineIndex.constEnd(),
+                          qMakePair(key, -1));
+    for (; i != d->lineIndex.constEnd() && i->first.startsWith(key); ++i) {
+        if (i->first == key) {
+            lines.append(i->second);
+        } else {
+            prefixLines.append(i->second);
+        }
+    }
+
+    QSet<int> found = lines.toSet();
+    foreach (int line, prefixLines) {
+        if (!found.contains(line)) {
+            lines.append(line);
+            found.insert(line);
+        }
+    }
+
+    return lines;
+}
+
+int CompactDatabase::rideCount() const
+{
+    Q_D(const CompactDatabase);
+    return d->rideCount;
+}
+
+int CompactDatabase::rideLine(int ride) const
+{
+    Q_D(const CompactDatabase);
+    if (ride < 0 || quint32(ride) >= d->rideCount) {
+        return -1;
+    }
+
+    quint32 line = d->read(d->rideOffset(ride));
+    if (line >= d->lineCount) {
+        return -1;
+    }
+    return line;
+}
+
+int CompactDatabase::rideIdentifier(int ride) const
+{
+    Q_D(const CompactDatabase);
+    if (ride < 0 || quint32(ride) >= d->rideCount) {
+        return -1;
+    }
+    return d->read(d->rideOffset(ride) + 20);
+}
+
+QString CompactDatabase::rideLineCode(int ride) const
+{
+    return lineCode(rideLine(ride));
+}
+
+QString CompactDatabase::rideLineName(int ride) const
+{
+    return lineName(rideLine(ride));
+}
+
+QString CompactDatabase::rideDirectionCode(int ride) const
+{
+    Q_D(const CompactDatabase);
+    if (ride < 0 || quint32(ride) >= d->rideCount) {
+        return QString();
+    }
+    return d->string(d->rideOffset(ride) + 4);
+}
+
+QString CompactDatabase::rideDirectionName(int ride) const
+{
+    Q_D(const CompactDatabase);
+    if (ride < 0 || quint32(ride) >= d->rideCount) {
+        return QString();
+    }
+    return d->string(d->rideOffset(ride) + 12);
+}
+
+int CompactDatabase::stationLineCount(int station) const
+{
+    Q_D(const CompactDatabase);
+    if (station < 0 || quint32(station) >= d->stationCount) {
+        return 0;
+    }
+    return d->read(d->stationOffset(station) + 20);
+}
+
+int CompactDatabase::stationLine(int station, int lineIndex) const
+{
+    Q_D(const CompactDatabase);
+    quint32 offset = d->groupOffset(station, lineIndex);
+    if (offset == 0) {
+        return -1;
+    }
+
+    quint32 line = d->read(offset);
+    if (line >= d->lineCount) {
+        return -1;
+    }
+    return line;
+}
+
+int CompactDatabase::stationLineRideCount(int station, int lineIndex) const
+{
+    Q_D(const CompactDatabase);
+    quint32 offset = d->groupOffset(station, lineIndex);
+    if (offset == 0) {
+        return 0;
+    }
+    return d->read(offset + 8);
+}
+
+int CompactDatabase::stationLineRide(int station, int lineIndex, int index) const
+{
+    Q_D(const CompactDatabase);
+    quint32 offset = d->linkOffset(station, lineIndex, index);
+    if (offset == 0) {
+        return -1;
+    }
+
+    quint32 ride = d->read(offset);
+    if (ride >= d->rideCount) {
+        return -1;
+    }
+    return ride;
+}
+
+QString CompactDatabase::stationLineRideCode(int station, int lineIndex, int index) const
+{
+    Q_D(const CompactDatabase);
+    quint32 offset = d->linkOffset(station, lineIndex, index);
+    if (offset == 0) {
+        return QString();
+    }
+    return d->string(offset + 4);
+}
+
+}
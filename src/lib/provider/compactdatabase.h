@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef PT2_COMPACTDATABASE_H
+#define PT2_COMPACTDATABASE_H
+
+/**
+ * @file compactdatabase.h
+ * @short Definition of PT2::CompactDatabase
+ */
+
+#include "pt2_global.h"
+
+#include <QtCore/QList>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QString>
+
+namespace PT2
+{
+
+struct CompactDatabasePrivate;
+
+/**
+ * @brief Read-only, memory-mapped station and ride database
+ *
+ * This class is used by provider plugins to read static
+ * informations about stations and rides, without going through
+ * an SQL database. The database file is mapped in memory when
+ * calling open(), and every query is answered by reading
+ * directly in the mapped file.
+ *
+ * Stations, lines, rides and the links between them are referred
+ * by their index, that goes from 0 to stationCount() - 1 for stations,
+ * from 0 to lineCount() - 1 for lines and from 0 to rideCount() - 1
+ * for rides. These indexes only depend on the position of stations,
+ * lines and rides in the file, and change when the database is rebuilt.
+ * Stations and rides also carry the identifier they have in the source
+ * database, that is stable, and should be used when an identifier is
+ * stored, for example in an history or a cache.
+ *
+ * The lines and rides serving a station are precomputed when the
+ * database is built, and are grouped by line. Lines are sorted by
+ * line code, and the rides of each line are sorted by direction name,
+ * so that the tree of lines and rides can be built in a single pass
+ * with stationLineCount(), stationLine(), stationLineRideCount() and
+ * stationLineRide(). The stations served by a line are also
+ * precomputed, and are available with lineStationCount() and
+ * lineStation().
+ *
+ * Lines can be searched by code or name with searchLines(). This
+ * search uses an index that is built in memory when the database
+ * is opened.
+ *
+ * @section compactDatabaseFormat File format
+ *
+ * The file is a little-endian binary file, made of 32 bits unsigned
+ * integers, and starts with an header that contains the magic "PT2D",
+ * the format version, and the offsets and sizes of the following
+ * sections
+ * - a string table, that contains every string, encoded in UTF-8.
+ *   Strings are referred by an offset in the table and a length.
+ * - a station table, that contains, for each station, the name, the
+ *   name normalized with normalizeForSearch(), the range of line
+ *   groups that serve the station, and the identifier of the station
+ *   in the source database. Stations are sorted by identifier.
+ * - a line table, that contains, for each line, the line code and
+ *   name, and the range of stations served by the line.
+ * - a ride table, that contains, for each ride, the line index, the
+ *   direction code and name, and the identifier of the ride in the
+ *   source database.
+ * - a line group table, that contains, grouped by station, the line
+ *   index and the range of links to the rides of this line that serve
+ *   the station.
+ * - a link table, that contains, grouped by line group, the ride index
+ *   and the code of the station for this ride.
+ * - a line station table, that contains, grouped by line, the
+ *   indexes of the stations served by the line.
+ * - a prefix index, that lists station indexes sorted by normalized
+ *   name, and is used to search stations by prefix.
+ *
+ * These files are generated from the data gathered by providers.
+ * See ratp-build-compact-db.py in the RATP provider for an example.
+ */
+class PT2_EXPORT CompactDatabase
+{
+public:
+    /**
+     * @brief Default constructor
+     */
+    explicit CompactDatabase();
+    /**
+     * @brief Destructor
+     */
+    virtual ~CompactDatabase();
+    /**
+     * @brief Open a database file
+     *
+     * The file is checked and mapped in memory. If the file
+     * cannot be opened, or is not a valid database, this method
+     * returns false and the database stays closed.
+     *
+     * @param fileName path to the database file.
+     * @return if the database was successfully opened.
+     */
+    bool open(const QString &fileName);
+    /**
+     * @brief Close the database
+     */
+    void close();
+    /**
+     * @brief If the database is opened
+     * @return if the database is opened.
+     */
+    bool isOpen() const;
+    /**
+     * @brief Number of stations
+     * @return number of stations.
+     */
+    int stationCount() const;
+    /**
+     * @brief Name of a station
+     * @param station station index.
+     * @return name of the station.
+     */
+    QString stationName(int station) const;
+    /**
+     * @brief Identifier of a station
+     * @param station station index.
+     * @return identifier of the station in the source database, or -1 if not found.
+     */
+    int stationIdentifier(int station) const;
+    /**
+     * @brief Station from an identifier
+     * @param identifier identifier of the station in the source database.
+     * @return station index, or -1 if not found.
+     */
+    int stationFromIdentifier(int identifier) const;
+    /**
+     * @brief Stations starting with a string
+     *
+     * The provided string is normalized using normalizeForSearch()
+     * before being compared to station names. Stations are returned
+     * sorted by normalized name.
+     *
+     * @param partialName partial station name.
+     * @return indexes of the stations whose name start with the string.
+     */
+    QList<int> stationsStartingWith(const QString &partialName) const;
+    /**
+     * @brief Search stations
+     *
+     * This method returns the stations whose name start with the
+     * provided string, followed by the stations whose name only contain
+     * the provided string. Both lists are sorted by normalized name.
+     *
+     * @param partialName partial station name.
+     * @return indexes of the stations matching the string.
+     */
+    QList<int> searchStations(const QString &partialName) const;
+    /**
+     * @brief Number of lines
+     * @return number of lines.
+     */
+    int lineCount() const;
+    /**
+     * @brief Code of a line
+     * @param line line index.
+     * @return code of the line.
+     */
+    QString lineCode(int line) const;
+    /**
+     * @brief Name of a line
+     * @param line line index.
+     * @return name of the line.
+     */
+    QString lineName(int line) const;
+    /**
+     * @brief Number of stations served by a line
+     * @param line line index.
+     * @return number of stations served by the line.
+     */
+    int lineStationCount(int line) const;
+    /**
+     * @brief Station served by a line
+     * @param line line index.
+     * @param index index of the station, between 0 and lineStationCount() - 1.
+     * @return station index, or -1 if not found.
+     */
+    int lineStation(int line, int index) const;
+    /**
+     * @brief Search lines
+     *
+     * The provided string is compared to line codes and names,
+     * ignoring case, diacritic marks and spaces, so that "rer b"
+     * or "RB" both match the line "RER B", coded "RB".
+     *
+     * This method returns the lines whose code or name is equal to
+     * the provided string, followed by the lines whose code or name
+     * start with the provided string.
+     *
+     * @param partialLine partial line code or name.
+     * @return indexes of the lines matching the string.
+     */
+    QList<int> searchLines(const QString &partialLine) const;
+    /**
+     * @brief Number of rides
+     * @return number of rides.
+     */
+    int rideCount() const;
+    /**
+     * @brief Line of a ride
+     * @param ride ride index.
+     * @return line index, or -1 if not found.
+     */
+    int rideLine(int ride) const;
+    /**
+     * @brief Identifier of a ride
+     * @param ride ride index.
+     * @return identifier of the ride in the source database, or -1 if not found.
+     */
+    int rideIdentifier(int ride) const;
+    /**
+     * @brief Line code of a ride
+     * @param ride ride index.
+     * @return line code of the ride.
+     */
+    QString rideLineCode(int ride) const;
+    /**
+     * @brief Line name of a ride
+     * @param ride ride index.
+     * @return line name of the ride.
+     */
+    QString rideLineName(int ride) const;
+    /**
+     * @brief Direction code of a ride
+     * @param ride ride index.
+     * @return direction code of the ride.
+     */
+    QString rideDirectionCode(int ride) const;
+    /**
+     * @brief Direction name of a ride
+     * @param ride ride index.
+     * @return direction name of the ride.
+     */
+    QString rideDirectionName(int ride) const;
+    /**
+     * @brief Number of lines serving a station
+     * @param station station index.
+     * @return number of lines serving the station.
+     */
+    int stationLineCount(int station) const;
+    /**
+     * @brief Line serving a station
+     * @param station station index.
+     * @param lineIndex index of the line, between 0 and stationLineCount() - 1.
+     * @return line index, or -1 if not found.
+     */
+    int stationLine(int station, int lineIndex) const;
+    /**
+     * @brief Number of rides of a line serving a station
+     * @param station station index.
+     * @param lineIndex index of the line, between 0 and stationLineCount() - 1.
+     * @return number of rides of the line serving the station.
+     */
+    int stationLineRideCount(int station, int lineIndex) const;
+    /**
+     * @brief Ride of a line serving a station
+     * @param station station index.
+     * @param lineIndex index of the line, between 0 and stationLineCount() - 1.
+     * @param index index of the ride, between 0 and stationLineRideCount() - 1.
+     * @return ride index, or -1 if not found.
+     */
+    int stationLineRide(int station, int lineIndex, int index) const;
+    /**
+     * @brief Code of a station for a ride serving it
+     * @param station station index.
+     * @param lineIndex index of the line, between 0 and stationLineCount() - 1.
+     * @param index index of the ride, between 0 and stationLineRideCount() - 1.
+     * @return code of the station for the ride.
+     */
+    QString stationLineRideCode(int station, int lineIndex, int index) const;
+protected:
+    /**
+     * @brief D-pointer
+     */
+    QScopedPointer<CompactDatabasePrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(CompactDatabase)
+};
+
+}
+
+#endif // PT2_COMPACTDATABASE_H
@@ -1,9 +1,11 @@
 HEADERS += $$PWD/providerplugininterface.h \
     $$PWD/providerpluginobject.h \
-    $$PWD/providerplugindbuswrapper.h
+    $$PWD/providerplugindbuswrapper.h \
+    $$PWD/compactdatabase.h
 
 SOURCES += $$PWD/providerpluginobject.cpp \
-    $$PWD/providerplugindbuswrapper.cpp
+    $$PWD/providerplugindbuswrapper.cpp \
+    $$PWD/compactdatabase.cpp
 
 provider_headers.files = $$PWD/*.h
 provider_headers.path = $${INCLUDEDIR}/provider
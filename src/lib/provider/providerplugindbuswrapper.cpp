@@ -39,6 +39,8 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonObject>
 #include <QtCore/QList>
 #include <QtCore/QPluginLoader>
 #include <QtDBus/QDBusConnection>
@@ -129,6 +131,29 @@ ProviderPluginDBusWrapper::~ProviderPluginDBusWrapper()
 bool ProviderPluginDBusWrapper::load(const QString &plugin)
 {
     Q_D(ProviderPluginDBusWrapper);
+#ifdef PT2_STATIC_PROVIDER
+    // Plugins are linked in the provider, and are selected
+    // by name, so "libratp.so" selects the class "Ratp"
+    QString name = QFileInfo(plugin).completeBaseName();
+    if (name.startsWith("lib")) {
+        name = name.mid(3);
+    }
+
+    QObject *pluginObject = 0;
+    foreach (const QStaticPlugin &staticPlugin, QPluginLoader::staticPlugins()) {
+        QString className = staticPlugin.metaData().value("className").toString();
+        if (className.compare(name, Qt::CaseInsensitive) == 0) {
+            pluginObject = staticPlugin.instance();
+            break;
+        }
+    }
+
+    if (!pluginObject) {
+        warning("provider-wrapper") << "The plugin" << plugin.toLocal8Bit().constData()
+                                    << "is not linked in the provider";
+        return false;
+    }
+#else
     QDir dir (PLUGIN_FOLDER);
     if (!dir.exists(plugin)) {
         warning("provider-wrapper") << "The plugin" << plugin.toLocal8Bit().constData()
@@ -145,6 +170,7 @@ bool ProviderPluginDBusWrapper::load(const QString &plugin)
         warning("provider-wrapper") << pluginLoader.errorString();
         return false;
     }
+#endif
 
     d->provider = qobject_cast<ProviderPluginObject *>(pluginObject);
     if (!d->provider) {
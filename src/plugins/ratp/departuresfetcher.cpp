@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+/**
+ * @internal
+ * @file departuresfetcher.cpp
+ * @short Implementation of PT2::Provider::DeparturesFetcher
+ */
+
+#include "departuresfetcher.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkRequest>
+
+#include "debug.h"
+#include "base/linenodedata.h"
+#include "base/ridenodedata.h"
+
+namespace PT2
+{
+
+namespace Provider
+{
+
+/**
+ * @internal
+ * @brief Default maximum number of concurrent fetches
+ *
+ * This is the number of connections that QNetworkAccessManager
+ * keeps alive for a given host. Stations with more rides are
+ * fetched in several rounds.
+ */
+static const int DEFAULT_MAXIMUM_CONCURRENT_FETCHES = 6;
+/**
+ * @internal
+ * @brief Default timeout of a fetch, in milliseconds
+ */
+static const int DEFAULT_TIMEOUT = 5000;
+/**
+ * @internal
+ * @brief Key for the departures
+ */
+static const char *DEPARTURES_KEY = "departures";
+/**
+ * @internal
+ * @brief Key for the departure times
+ */
+static const char *DEPARTURE_TIMES_KEY = "departureTimes";
+
+DeparturesFetcher::DeparturesFetcher(QObject *parent) :
+    QObject(parent), m_networkAccessManager(new QNetworkAccessManager(this))
+  , m_maximumConcurrentFetches(DEFAULT_MAXIMUM_CONCURRENT_FETCHES), m_timeout(DEFAULT_TIMEOUT)
+{
+}
+
+int DeparturesFetcher::maximumConcurrentFetches() const
+{
+    return m_maximumConcurrentFetches;
+}
+
+void DeparturesFetcher::setMaximumConcurrentFetches(int maximumConcurrentFetches)
+{
+    m_maximumConcurrentFetches = qMax(1, maximumConcurrentFetches);
+    startFetches();
+}
+
+int DeparturesFetcher::timeout() const
+{
+    return m_timeout;
+}
+
+void DeparturesFetcher::setTimeout(int timeout)
+{
+    m_timeout = timeout;
+}
+
+void DeparturesFetcher::fetch(const QString &request, const QList<CompanyNodeData> &data,
+                              const QList<QUrl> &urls)
+{
+    if (m_batches.contains(request)) {
+        warning("ratp") << "Departures are already being fetched for" << request;
+        return;
+    }
+
+    Batch batch;
+    batch.data = data;
+    batch.properties.resize(urls.count());
+    batch.pending = 0;
+
+    for (int i = 0; i < urls.count(); ++i) {
+        if (!urls.at(i).isValid()) {
+            continue;
+        }
+
+        Fetch fetch;
+        fetch.request = request;
+        fetch.index = i;
+        fetch.url = urls.at(i);
+        m_queue.enqueue(fetch);
+        ++batch.pending;
+    }
+
+    m_batches.insert(request, batch);
+    finishBatch(request);
+    startFetches();
+}
+
+void DeparturesFetcher::startFetches()
+{
+    while (!m_queue.isEmpty() && m_running.count() < m_maximumConcurrentFetches) {
+        Fetch fetch = m_queue.dequeue();
+        debug("ratp") << "Fetching departures from" << fetch.url.toString();
+
+        QNetworkReply *reply = m_networkAccessManager->get(QNetworkRequest(fetch.url));
+        connect(reply, &QNetworkReply::finished, this, &DeparturesFetcher::slotFinished);
+
+        QTimer *timer = new QTimer(reply);
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, reply, &QNetworkReply::abort);
+        timer->start(m_timeout);
+
+        m_running.insert(reply, fetch);
+    }
+}
+
+void DeparturesFetcher::finishBatch(const QString &request)
+{
+    if (!m_batches.contains(request) || m_batches.value(request).pending > 0) {
+        return;
+    }
+
+    Batch batch = m_batches.take(request);
+    emit departuresFetched(request, merge(batch));
+}
+
+QVariantMap DeparturesFetcher::parseDepartures(const QByteArray &data)
+{
+    static const QRegularExpression departureRegExp ("<div class=\"schmsg\\d\"[^>]*><b>([^<]*)</b>");
+    static const QRegularExpression minutesRegExp ("^(\\d+)\\s*mn");
+
+    QStringList departures;
+    QVariantList departureTimes;
+    qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    QRegularExpressionMatchIterator i = departureRegExp.globalMatch(QString::fromUtf8(data));
+    while (i.hasNext()) {
+        QString departure = i.next().captured(1).trimmed();
+        departures.append(departure);
+
+        QRegularExpressionMatch minutes = minutesRegExp.match(departure);
+        if (minutes.hasMatch()) {
+            departureTimes.append(now + minutes.captured(1).toInt() * 60);
+        } else if (departure.contains("approche", Qt::CaseInsensitive)
+                   || departure.contains("quai", Qt::CaseInsensitive)) {
+            departureTimes.append(now);
+        } else {
+            departureTimes.append(-1);
+        }
+    }
+
+    QVariantMap properties;
+    properties.insert(DEPARTURES_KEY, departures);
+    properties.insert(DEPARTURE_TIMES_KEY, departureTimes);
+    return properties;
+}
+
+QList<CompanyNodeData> DeparturesFetcher::merge(const Batch &batch)
+{
+    QList<CompanyNodeData> data;
+    int index = 0;
+    foreach (CompanyNodeData company, batch.data) {
+        QList<LineNodeData> lines;
+        foreach (LineNodeData line, company.lineNodeDataList()) {
+            QList<RideNodeData> rides;
+            foreach (RideNodeData rideNodeData, line.rideNodeDataList()) {
+                if (index < batch.properties.count() && !batch.properties.at(index).isEmpty()) {
+                    Ride ride = rideNodeData.ride();
+                    QVariantMap properties = ride.properties();
+                    QMapIterator<QString, QVariant> i (batch.properties.at(index));
+                    while (i.hasNext()) {
+                        i.next();
+                        properties.insert(i.key(), i.value());
+                    }
+                    ride.setProperties(properties);
+                    rideNodeData.setRide(ride);
+                }
+                rides.append(rideNodeData);
+                ++index;
+            }
+            line.setRideNodeDataList(rides);
+            lines.append(line);
+        }
+        company.setLineNodeDataList(lines);
+        data.append(company);
+    }
+    return data;
+}
+
+void DeparturesFetcher::slotFinished()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (!reply || !m_running.contains(reply)) {
+        return;
+    }
+
+    Fetch fetch = m_running.take(reply);
+    reply->deleteLater();
+
+    if (reply->error() != QNetworkReply::NoError) {
+        warning("ratp") << "Failed to fetch departures from" << fetch.url.toString()
+                        << reply->errorString();
+    } else if (m_batches.contains(fetch.request)) {
+        m_batches[fetch.request].properties[fetch.index] = parseDepartures(reply->readAll());
+    }
+
+    if (m_batches.contains(fetch.request)) {
+        --m_batches[fetch.request].pending;
+        finishBatch(fetch.request);
+    }
+
+    startFetches();
+}
+
+}
+
+}
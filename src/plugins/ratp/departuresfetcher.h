@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef PT2_PROVIDER_DEPARTURESFETCHER_H
+#define PT2_PROVIDER_DEPARTURESFETCHER_H
+
+/**
+ * @internal
+ * @file departuresfetcher.h
+ * @short Definition of PT2::Provider::DeparturesFetcher
+ */
+
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QUrl>
+#include <QtCore/QVariantMap>
+#include <QtCore/QVector>
+#include "base/companynodedata.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+namespace PT2
+{
+
+namespace Provider
+{
+
+/**
+ * @internal
+ * @brief Fetcher for real-time departures
+ *
+ * This class fetches the next departures of rides from the
+ * wap.ratp.fr pages, and merges them into the properties of
+ * these rides.
+ *
+ * fetch() takes a tree of rides, and one URL per ride, given in
+ * the order of the tree. Every URL is fetched concurrently, up to
+ * maximumConcurrentFetches() at the same time, and through a single
+ * QNetworkAccessManager, so that connections to the server are
+ * kept alive and reused. Each fetch is aborted after timeout()
+ * milliseconds.
+ *
+ * The maximum number of concurrent fetches defaults to the number
+ * of connections that QNetworkAccessManager opens to a host, since
+ * more concurrent fetches would only be queued by the network access
+ * manager. A station with more rides than this limit is fetched in
+ * several rounds, and takes as long as the slowest fetch of each
+ * round, instead of the slowest single fetch.
+ *
+ * When every fetch of a request is finished, the rides are emitted
+ * through departuresFetched(), with the properties
+ * - "departures": the list of departures, as displayed by the server.
+ * - "departureTimes": the list of the expected departure times, in
+ *   seconds since epoch, or -1 if the departure time is not known.
+ *
+ * Rides whose departures cannot be fetched are emitted without
+ * these properties.
+ */
+class DeparturesFetcher : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @internal
+     * @brief Default constructor
+     * @param parent parent object.
+     */
+    explicit DeparturesFetcher(QObject *parent = 0);
+    /**
+     * @internal
+     * @brief Maximum number of concurrent fetches
+     * @return maximum number of concurrent fetches.
+     */
+    int maximumConcurrentFetches() const;
+    /**
+     * @internal
+     * @brief Set the maximum number of concurrent fetches
+     * @param maximumConcurrentFetches maximum number of concurrent fetches.
+     */
+    void setMaximumConcurrentFetches(int maximumConcurrentFetches);
+    /**
+     * @internal
+     * @brief Timeout of a fetch
+     * @return timeout of a fetch, in milliseconds.
+     */
+    int timeout() const;
+    /**
+     * @internal
+     * @brief Set the timeout of a fetch
+     * @param timeout timeout of a fetch, in milliseconds.
+     */
+    void setTimeout(int timeout);
+    /**
+     * @internal
+     * @brief Fetch departures
+     *
+     * The URLs should be given in the order of the rides in the
+     * tree: for each company, for each line, for each ride. An
+     * invalid URL skips the corresponding ride.
+     *
+     * A request whose identifier is already being processed is
+     * ignored, since the replies of both requests could not be told
+     * apart. The running request answers for it.
+     *
+     * @param request request identifier.
+     * @param data tree of rides.
+     * @param urls URLs of the departures of each ride.
+     */
+    void fetch(const QString &request, const QList<CompanyNodeData> &data,
+               const QList<QUrl> &urls);
+Q_SIGNALS:
+    /**
+     * @internal
+     * @brief Departures fetched
+     * @param request request identifier.
+     * @param data tree of rides, with departures.
+     */
+    void departuresFetched(const QString &request, const QList<CompanyNodeData> &data);
+private Q_SLOTS:
+    /**
+     * @internal
+     * @brief Slot for a finished fetch
+     */
+    void slotFinished();
+private:
+    /**
+     * @internal
+     * @brief A fetch
+     */
+    struct Fetch
+    {
+        /**
+         * @internal
+         * @brief Request identifier
+         */
+        QString request;
+        /**
+         * @internal
+         * @brief Index of the ride, in the order of the tree
+         */
+        int index;
+        /**
+         * @internal
+         * @brief URL
+         */
+        QUrl url;
+    };
+    /**
+     * @internal
+     * @brief A request being processed
+     */
+    struct Batch
+    {
+        /**
+         * @internal
+         * @brief Tree of rides
+         */
+        QList<CompanyNodeData> data;
+        /**
+         * @internal
+         * @brief Properties to add, for each ride
+         */
+        QVector<QVariantMap> properties;
+        /**
+         * @internal
+         * @brief Number of fetches that are not finished
+         */
+        int pending;
+    };
+    /**
+     * @internal
+     * @brief Start queued fetches, if possible
+     */
+    void startFetches();
+    /**
+     * @internal
+     * @brief Emit a request, if all of its fetches are finished
+     * @param request request identifier.
+     */
+    void finishBatch(const QString &request);
+    /**
+     * @internal
+     * @brief Parse departures
+     * @param data page returned by the server.
+     * @return properties containing the departures.
+     */
+    static QVariantMap parseDepartures(const QByteArray &data);
+    /**
+     * @internal
+     * @brief Merge departures into a tree of rides
+     * @param batch request being processed.
+     * @return tree of rides, with departures.
+     */
+    static QList<CompanyNodeData> merge(const Batch &batch);
+    /**
+     * @internal
+     * @brief Network access manager
+     */
+    QNetworkAccessManager *m_networkAccessManager;
+    /**
+     * @internal
+     * @brief Maximum number of concurrent fetches
+     */
+    int m_maximumConcurrentFetches;
+    /**
+     * @internal
+     * @brief Timeout of a fetch
+     */
+    int m_timeout;
+    /**
+     * @internal
+     * @brief Fetches waiting to be started
+     */
+    QQueue<Fetch> m_queue;
+    /**
+     * @internal
+     * @brief Running fetches
+     */
+    QHash<QNetworkReply *, Fetch> m_running;
+    /**
+     * @internal
+     * @brief Requests being processed
+     */
+    QMap<QString, Batch> m_batches;
+};
+
+}
+
+}
+
+#endif // PT2_PROVIDER_DEPARTURESFETCHER_H
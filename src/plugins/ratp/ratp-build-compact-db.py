@@ -0,0 +1,210 @@
+#!/usr/bin/python
+# -*- coding: utf-8 -*-
+# Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+#
+# You may use this file under the terms of the BSD license as follows:
+#
+# "Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#  *  Redistributions of source code must retain the above copyright
+#     notice, this list of conditions and the following disclaimer.
+#  *  Redistributions in binary form must reproduce the above copyright
+#     notice, this list of conditions and the following disclaimer in
+#     the documentation and/or other materials provided with the
+#     distribution.
+#  *  The names of its contributors may not be used to endorse or promote
+#     products derived from this software without specific prior written
+#     permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+
+# Builds the compact database used by the RATP provider.
+#
+# This script reads the SQLite database created by
+# ratp-auto-build-stations.py and writes a read-only binary
+# file that can be memory-mapped by PT2::CompactDatabase.
+# Run this script after updating ratp.db.
+#
+# The format is described in compactdatabase.h. All integers
+# are 32 bits unsigned little-endian integers, and strings are
+# stored in an UTF-8 string table.
+
+import sqlite3
+import struct
+import sys
+import unicodedata
+
+VERSION = 4
+MAGIC = b"PT2D"
+HEADER_SIZE = 68
+
+def remove_accents(input_str):
+    nkfd_form = unicodedata.normalize('NFKD', input_str)
+    return u"".join([c for c in nkfd_form if not unicodedata.combining(c)])
+
+# Should match PT2::normalizeForSearch
+def normalize(name):
+    return remove_accents(name.lower())
+
+def text(value):
+    return u"%s" % value
+
+class StringTable:
+    def __init__(self):
+        self.data = b""
+        self.strings = {}
+
+    def add(self, string):
+        encoded = string.encode("utf-8")
+        if encoded not in self.strings:
+            self.strings[encoded] = len(self.data)
+            self.data += encoded
+        return (self.strings[encoded], len(encoded))
+
+    def padded(self):
+        return self.data + b"\0" * ((4 - len(self.data) % 4) % 4)
+
+inputFile = "ratp.db"
+outputFile = "ratp.pt2db"
+if len(sys.argv) > 1:
+    inputFile = sys.argv[1]
+if len(sys.argv) > 2:
+    outputFile = sys.argv[2]
+
+connection = sqlite3.connect(inputFile)
+c = connection.cursor()
+
+strings = StringTable()
+
+# Stations
+stationIndexes = {}
+stations = []
+for (identifier, name) in c.execute("SELECT id, name FROM stations ORDER BY id"):
+    stationIndexes[identifier] = len(stations)
+    stations.append({"identifier": identifier, "name": text(name),
+                     "normalized": normalize(text(name)), "links": []})
+
+# Lines and rides
+lineIndexes = {}
+lines = []
+rideIndexes = {}
+rides = []
+for row in c.execute("SELECT id, lineCode, lineName, directionCode, directionName FROM rides "\
+                     "ORDER BY id"):
+    lineCode = text(row[1])
+    if lineCode not in lineIndexes:
+        lineIndexes[lineCode] = len(lines)
+        lines.append((lineCode, text(row[2])))
+    rideIndexes[row[0]] = len(rides)
+    rides.append((lineIndexes[lineCode], text(row[3]), text(row[4]), row[0]))
+
+# Links, grouped by station
+for (stationId, rideId, stationCode) in c.execute("SELECT DISTINCT stationId, rideId, "\
+                                                  "stationCode FROM link_station_ride "\
+                                                  "ORDER BY stationId, rideId"):
+    if stationId in stationIndexes and rideId in rideIndexes:
+        stations[stationIndexes[stationId]]["links"].append((rideIndexes[rideId],
+                                                             text(stationCode)))
+# Stations of each line, in the order they are listed for the rides of the line
+lineStations = [[] for line in lines]
+for (rideId, stationId) in c.execute("SELECT rideId, stationId FROM link_station_ride "\
+                                     "ORDER BY rideId, rowid"):
+    if stationId in stationIndexes and rideId in rideIndexes:
+        stationList = lineStations[rides[rideIndexes[rideId]][0]]
+        if stationIndexes[stationId] not in stationList:
+            stationList.append(stationIndexes[stationId])
+c.close()
+
+# Tables
+# Links of a station are grouped by line, lines being sorted by code
+# and rides by direction name, in the order used by the provider
+stationTable = b""
+groupTable = b""
+groupCount = 0
+linkTable = b""
+linkCount = 0
+for station in stations:
+    groups = {}
+    for (ride, code) in station["links"]:
+        groups.setdefault(rides[ride][0], []).append((ride, code))
+    sortedLines = sorted(groups.keys(), key=lambda line: (lines[line][0], line))
+
+    name = strings.add(station["name"])
+    normalized = strings.add(station["normalized"])
+    stationTable += struct.pack("<7I", name[0], name[1], normalized[0], normalized[1],
+                                groupCount, len(sortedLines), station["identifier"])
+    for line in sortedLines:
+        links = sorted(groups[line], key=lambda link: (rides[link[0]][2], link[0]))
+        groupTable += struct.pack("<3I", line, linkCount, len(links))
+        groupCount += 1
+        for (ride, code) in links:
+            codeString = strings.add(code)
+            linkTable += struct.pack("<3I", ride, codeString[0], codeString[1])
+            linkCount += 1
+
+lineTable = b""
+lineStationTable = b""
+lineStationCount = 0
+for (line, (code, name)) in enumerate(lines):
+    codeString = strings.add(code)
+    nameString = strings.add(name)
+    lineTable += struct.pack("<6I", codeString[0], codeString[1], nameString[0], nameString[1],
+                             lineStationCount, len(lineStations[line]))
+    for station in lineStations[line]:
+        lineStationTable += struct.pack("<I", station)
+        lineStationCount += 1
+
+rideTable = b""
+for (line, directionCode, directionName, identifier) in rides:
+    directionCodeString = strings.add(directionCode)
+    directionNameString = strings.add(directionName)
+    rideTable += struct.pack("<6I", line, directionCodeString[0], directionCodeString[1],
+                             directionNameString[0], directionNameString[1], identifier)
+
+# Prefix index, sorted by normalized name, as compared by PT2::CompactDatabase
+order = sorted(range(len(stations)),
+               key=lambda i: (stations[i]["normalized"].encode("utf-8"), i))
+prefixIndex = b"".join([struct.pack("<I", i) for i in order])
+
+# Write the file
+stringTable = strings.padded()
+stringTableOffset = HEADER_SIZE
+stationTableOffset = stringTableOffset + len(stringTable)
+lineTableOffset = stationTableOffset + len(stationTable)
+rideTableOffset = lineTableOffset + len(lineTable)
+groupTableOffset = rideTableOffset + len(rideTable)
+linkTableOffset = groupTableOffset + len(groupTable)
+lineStationTableOffset = linkTableOffset + len(linkTable)
+prefixIndexOffset = lineStationTableOffset + len(lineStationTable)
+
+header = MAGIC + struct.pack("<16I", VERSION, stringTableOffset, len(strings.data),
+                             len(stations), stationTableOffset, len(lines), lineTableOffset,
+                             len(rides), rideTableOffset, groupCount, groupTableOffset,
+                             linkCount, linkTableOffset, lineStationCount,
+                             lineStationTableOffset, prefixIndexOffset)
+
+f = open(outputFile, "wb")
+f.write(header)
+f.write(stringTable)
+f.write(stationTable)
+f.write(lineTable)
+f.write(rideTable)
+f.write(groupTable)
+f.write(linkTable)
+f.write(lineStationTable)
+f.write(prefixIndex)
+f.close()
+
+print("Wrote " + outputFile + ": " + str(len(stations)) + " stations, " + str(len(lines))
+      + " lines, " + str(len(rides)) + " rides, " + str(linkCount) + " links")
@@ -37,6 +37,7 @@
 
 #include "ratp.h"
 
+#include <QtCore/QUrlQuery>
 #include "debug.h"
 #include "errorid.h"
 #include "capabilitiesconstants.h"
@@ -45,8 +46,6 @@
 #include "base/station.h"
 #include "base/companynodedata.h"
 #include "base/ridenodedata.h"
-#include <QtSql/QSqlQuery>
-#include <QtSql/QSqlError>
 
 namespace PT2
 {
@@ -57,29 +56,23 @@ namespace Provider
 static const char *IDENTIFIER_TEMPLATE = "org.SfietKonstantin.pt2.ratp/%1";
 static const char *DB_IDENTIFIER_KEY = "db_identifier";
 static const char *RATP_IDENTIFIER_KEY = "ratp_identifier";
-
-static inline QString unaccent(const QString &string)
-{
-    QString normalized = string.normalized(QString::NormalizationForm_D);
-    QString out;
-    for (int i = 0; i < normalized.count(); i++) {
-        // strip diacritic marks
-        if (normalized.at(i).category() != QChar::Mark_NonSpacing
-            && normalized.at(i).category() != QChar::Mark_SpacingCombining) {
-            out.append(normalized.at(i));
-        }
-    }
-    return out;
-}
+static const char *STATIONS_KEY = "stations";
+static const char *BASE_URL_ENVIRONMENT_VARIABLE = "PT2_RATP_BASE_URL";
+static const char *DEFAULT_BASE_URL = "http://wap.ratp.fr/siv/schedule";
 
 Ratp::Ratp(QObject *parent) :
-    ProviderPluginObject(parent)
+    ProviderPluginObject(parent), m_departuresFetcher(new DeparturesFetcher(this))
 {
-    m_db = QSqlDatabase::addDatabase("QSQLITE");
-    m_db.setDatabaseName(QString("%1/ratp/ratp.db").arg(PLUGIN_FOLDER));
-    if (!m_db.open()) {
-        return;
+    m_db.open(QString("%1/ratp/ratp.pt2db").arg(PLUGIN_FOLDER));
+
+    QByteArray baseUrl = qgetenv(BASE_URL_ENVIRONMENT_VARIABLE);
+    if (baseUrl.isEmpty()) {
+        baseUrl = DEFAULT_BASE_URL;
     }
+    m_baseUrl = QUrl(QString::fromUtf8(baseUrl));
+
+    connect(m_departuresFetcher, &DeparturesFetcher::departuresFetched,
+            this, &Ratp::realTimeRidesFromStationRetrieved);
 }
 
 Ratp::~Ratp()
@@ -91,6 +84,7 @@ QStringList Ratp::capabilities() const
 {
     QStringList capabilities;
     capabilities.append(CAPABILITY_REAL_TIME_SUGGEST_STATION_FROM_STRING);
+    capabilities.append(CAPABILITY_REAL_TIME_SUGGEST_STATION_COMPLETE);
     capabilities.append(CAPABILITY_REAL_TIME_SUGGEST_LINE_FROM_STRING);
     capabilities.append(CAPABILITY_REAL_TIME_RIDES_FROM_STATION);
     return capabilities;
@@ -110,45 +104,17 @@ void Ratp::retrieveRealTimeSuggestedStations(const QString &request, const QStri
         return;
     }
 
-    QString stationQuery = unaccent(partialStation);
-    stationQuery.append("%");
-    QSqlQuery query (m_db);
-    query.prepare("SELECT id, name FROM stations WHERE nameUnaccented LIKE :station "\
-                  "ORDER BY nameUnaccented");
-    query.bindValue(":station", stationQuery);
-    if (!query.exec()) {
-        warning("ratp") << "Error:" << query.lastError().text() << query.lastQuery();
+    if (!m_db.isOpen()) {
         emit errorRetrieved(request, ERROR_BACKEND_WARNING, "Failed to query stations from DB.");
         return;
     }
 
-    while (query.next()) {
-        QString identifier = QString(IDENTIFIER_TEMPLATE).arg(query.value(0).toInt());
+    foreach (int stationIndex, m_db.searchStations(partialStation)) {
+        int stationDbId = m_db.stationIdentifier(stationIndex);
+        QString identifier = QString(IDENTIFIER_TEMPLATE).arg(stationDbId);
         QVariantMap internal;
-        internal.insert(DB_IDENTIFIER_KEY, query.value(0).toInt());
-        Station station (identifier, internal, query.value(1).toString(), QVariantMap());
-        stations.append(station);
-    }
-
-    query.prepare("SELECT id, name FROM stations WHERE nameUnaccented LIKE :station1 "\
-                  "AND nameUnaccented NOT LIKE :station2 ORDER BY nameUnaccented");
-    QString otherStationQuery = unaccent(partialStation);
-    otherStationQuery.prepend("%");
-    otherStationQuery.append("%");
-
-    query.bindValue(":station1", otherStationQuery);
-    query.bindValue(":station2", stationQuery);
-    if (!query.exec()) {
-        warning("ratp") << "Error:" << query.lastError().text() << query.lastQuery();
-        emit errorRetrieved(request, ERROR_BACKEND_WARNING, "Failed to query stations from DB.");
-        return;
-    }
-
-    while (query.next()) {
-        QString identifier = QString(IDENTIFIER_TEMPLATE).arg(query.value(0).toInt());
-        QVariantMap internal;
-        internal.insert(DB_IDENTIFIER_KEY, query.value(0).toInt());
-        Station station (identifier, internal, query.value(1).toString(), QVariantMap());
+        internal.insert(DB_IDENTIFIER_KEY, stationDbId);
+        Station station (identifier, internal, m_db.stationName(stationIndex), QVariantMap());
         stations.append(station);
     }
 
@@ -163,71 +129,138 @@ void Ratp::retrieveRealTimeRidesFromStation(const QString &request, const Statio
 
     Company company (QString(IDENTIFIER_TEMPLATE).arg(0), QVariantMap(), tr("RATP"), QVariantMap());
 
-    QList<LineNodeData> lines;
-    QMap<QString, LineNodeData> lineMap;
-
-
-    QSqlQuery query (m_db);
-    query.prepare("SELECT DISTINCT id, lineCode, lineName, directionCode, directionName, "\
-                  "link_station_ride.stationCode FROM rides "\
-                  "INNER JOIN link_station_ride ON rides.id = link_station_ride.rideId "\
-                  "WHERE link_station_ride.stationId = :stationId");
-    query.bindValue(":stationId", stationDbId);
+    if (!m_db.isOpen()) {
+        emit errorRetrieved(request, ERROR_BACKEND_WARNING, "Failed to query stations from DB.");
+        return;
+    }
 
-    if (!query.exec()) {
-        warning("ratp") << "Error:" << query.lastError().text() << query.lastQuery();
+    int stationIndex = m_db.stationFromIdentifier(stationDbId);
+    if (stationIndex < 0) {
         emit errorRetrieved(request, ERROR_BACKEND_WARNING, "Failed to query stations from DB.");
         return;
     }
 
-    // Create lines and populate them with the ride
-    while (query.next()) {
-        QString lineCode = query.value(1).toString();
-        if (!lineMap.contains(lineCode)) {
-            QString lineName = query.value(2).toString();
-            debug("ratp") << "Found line" << lineName;
-            QString lineIdentifier = QString(IDENTIFIER_TEMPLATE).arg(lineCode);
-            QVariantMap lineInternal;
-            lineInternal.insert(RATP_IDENTIFIER_KEY, lineCode);
-            Line line (lineIdentifier, lineInternal, lineName, QVariantMap());
-            lineMap.insert(lineCode, LineNodeData (line));
+    // Lines and rides are already grouped and sorted in the DB
+    QList<LineNodeData> lines;
+    QList<QUrl> urls;
+    int lineCount = m_db.stationLineCount(stationIndex);
+    lines.reserve(lineCount);
+    for (int i = 0; i < lineCount; ++i) {
+        int lineIndex = m_db.stationLine(stationIndex, i);
+        if (lineIndex < 0) {
+            continue;
         }
 
-        // Ride
-        QString rideName = query.value(4).toString();
-        QString rideIdentifier = QString(IDENTIFIER_TEMPLATE).arg(query.value(0).toInt());
-        QVariantMap rideInternal;
-        rideInternal.insert(RATP_IDENTIFIER_KEY, query.value(3).toString());
-        Ride ride (rideIdentifier, rideInternal, rideName, QVariantMap());
-
-        // Station
-        QVariantMap stationInternal = station.internal();
-        stationInternal.insert(RATP_IDENTIFIER_KEY, query.value(5).toString());
-        Station newStation (station.identifier(), stationInternal, station.name(),
-                            station.properties());
-        QList<Station> stationList;
-        stationList.append(newStation);
-
-        // Just in case
-        if (lineMap.contains(lineCode)) {
-            QList<RideNodeData> rideNodeDataList = lineMap[lineCode].rideNodeDataList();
+        // Line
+        QString lineCode = m_db.lineCode(lineIndex);
+        QString lineName = m_db.lineName(lineIndex);
+        debug("ratp") << "Found line" << lineName;
+        QString lineIdentifier = QString(IDENTIFIER_TEMPLATE).arg(lineCode);
+        QVariantMap lineInternal;
+        lineInternal.insert(RATP_IDENTIFIER_KEY, lineCode);
+        Line line (lineIdentifier, lineInternal, lineName, QVariantMap());
+
+        QList<RideNodeData> rideNodeDataList;
+        int rideCount = m_db.stationLineRideCount(stationIndex, i);
+        rideNodeDataList.reserve(rideCount);
+        for (int j = 0; j < rideCount; ++j) {
+            int rideIndex = m_db.stationLineRide(stationIndex, i, j);
+            if (rideIndex < 0) {
+                continue;
+            }
+
+            // Ride
+            QString rideName = m_db.rideDirectionName(rideIndex);
+            int rideDbId = m_db.rideIdentifier(rideIndex);
+            QString rideIdentifier = QString(IDENTIFIER_TEMPLATE).arg(rideDbId);
+            QVariantMap rideInternal;
+            rideInternal.insert(RATP_IDENTIFIER_KEY, m_db.rideDirectionCode(rideIndex));
+            Ride ride (rideIdentifier, rideInternal, rideName, QVariantMap());
+
+            // Station
+            QString stationCode = m_db.stationLineRideCode(stationIndex, i, j);
+            QVariantMap stationInternal = station.internal();
+            stationInternal.insert(RATP_IDENTIFIER_KEY, stationCode);
+            Station newStation (station.identifier(), stationInternal, station.name(),
+                                station.properties());
+            QList<Station> stationList;
+            stationList.append(newStation);
+
             rideNodeDataList.append(RideNodeData(ride, stationList));
-            lineMap[lineCode].setRideNodeDataList(rideNodeDataList);
+            urls.append(departuresUrl(lineCode, m_db.rideDirectionCode(rideIndex), stationCode));
         }
-    }
 
-    foreach (const LineNodeData &line, lineMap) {
-        lines.append(line);
+        lines.append(LineNodeData(line, rideNodeDataList));
     }
 
     rides.append(CompanyNodeData(company, lines));
 
-    emit realTimeRidesFromStationRetrieved(request, rides);
+    // Departures are fetched concurrently, and rides are emitted
+    // when all of them are fetched
+    m_departuresFetcher->fetch(request, rides, urls);
+}
+
+QUrl Ratp::departuresUrl(const QString &lineCode, const QString &directionCode,
+                         const QString &stationCode) const
+{
+    QString network;
+    if (lineCode.startsWith("M")) {
+        network = "metro";
+    } else if (lineCode.startsWith("R")) {
+        network = "rer";
+    } else {
+        return QUrl();
+    }
+
+    QUrlQuery query;
+    query.addQueryItem("service", "next");
+    query.addQueryItem("reseau", network);
+    query.addQueryItem("lineid", lineCode);
+    query.addQueryItem("directionsens", directionCode);
+    query.addQueryItem("stationid", stationCode);
+
+    QUrl url (m_baseUrl);
+    url.setQuery(query);
+    return url;
 }
 
 void Ratp::retrieveRealTimeSuggestedLines(const QString &request, const QString &partialLine)
 {
     QList<Line> lines;
+    if (!m_db.isOpen()) {
+        emit errorRetrieved(request, ERROR_BACKEND_WARNING, "Failed to query lines from DB.");
+        return;
+    }
+
+    foreach (int lineIndex, m_db.searchLines(partialLine)) {
+        QString lineCode = m_db.lineCode(lineIndex);
+        QString identifier = QString(IDENTIFIER_TEMPLATE).arg(lineCode);
+
+        // Stations served by the line are precomputed, so that
+        // they can be displayed as soon as the line is selected
+        QVariantList stationIdentifiers;
+        QStringList stationNames;
+        int stationCount = m_db.lineStationCount(lineIndex);
+        stationIdentifiers.reserve(stationCount);
+        stationNames.reserve(stationCount);
+        for (int i = 0; i < stationCount; ++i) {
+            int stationIndex = m_db.lineStation(lineIndex, i);
+            if (stationIndex < 0) {
+                continue;
+            }
+            stationIdentifiers.append(m_db.stationIdentifier(stationIndex));
+            stationNames.append(m_db.stationName(stationIndex));
+        }
+
+        QVariantMap internal;
+        internal.insert(RATP_IDENTIFIER_KEY, lineCode);
+        internal.insert(STATIONS_KEY, stationIdentifiers);
+        QVariantMap properties;
+        properties.insert(STATIONS_KEY, stationNames);
+        Line line (identifier, internal, m_db.lineName(lineIndex), properties);
+        lines.append(line);
+    }
+
     emit realTimeSuggestedLinesRetrieved(request, lines);
 }
 
@@ -39,8 +39,10 @@
  */
 
 #include <QtCore/QObject>
-#include <QtSql/QSqlDatabase>
+#include <QtCore/QUrl>
+#include "provider/compactdatabase.h"
 #include "provider/providerpluginobject.h"
+#include "departuresfetcher.h"
 
 namespace PT2
 {
@@ -55,6 +57,13 @@ namespace Provider
  * This provider uses wap.ratp.fr to fetch
  * information about public transportation in
  * Paris.
+ *
+ * Stations, lines and rides are read from a
+ * CompactDatabase, and the next departures of
+ * each ride are fetched with a DeparturesFetcher.
+ * The server used to fetch departures can be
+ * changed with the PT2_RATP_BASE_URL environment
+ * variable.
  */
 class Ratp : public ProviderPluginObject
 {
@@ -75,7 +84,18 @@ public Q_SLOTS:
     void retrieveRealTimeRidesFromStation(const QString &request, const Station &station);
     void retrieveRealTimeSuggestedLines(const QString &request, const QString &partialLine);
 private:
-    QSqlDatabase m_db;
+    /**
+     * @brief URL of the departures of a ride
+     * @param lineCode line code.
+     * @param directionCode direction code.
+     * @param stationCode station code.
+     * @return URL of the departures.
+     */
+    QUrl departuresUrl(const QString &lineCode, const QString &directionCode,
+                       const QString &stationCode) const;
+    CompactDatabase m_db;
+    DeparturesFetcher *m_departuresFetcher;
+    QUrl m_baseUrl;
 };
 
 }
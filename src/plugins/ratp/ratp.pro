@@ -2,17 +2,20 @@ include(../../../common.pri)
 
 TARGET = ratp
 TEMPLATE = lib
-QT = core network sql
+QT = core network
 CONFIG += plugin
+CONFIG(staticprovider): CONFIG += static
 INCLUDEPATH += ../../lib
 LIBS += -L../../lib/ -l$${NAME}
 !CONFIG(semistatic): {
 LIBS += -L../../3rdparty/mlitedesktop/ -lmlitedesktop
 }
 
-HEADERS +=      ratp.h
+HEADERS +=      ratp.h \
+                departuresfetcher.h
 
-SOURCES +=      ratp.cpp
+SOURCES +=      ratp.cpp \
+                departuresfetcher.cpp
 
 OTHER_FILES +=  ratp.desktop
 
@@ -23,6 +26,7 @@ desktopFile.path = $${PLUGIN_FOLDER}
 desktopFile.files = $${OTHER_FILES}
 
 db.path = $${PLUGIN_FOLDER}/ratp
-db.files = ratp.db
+db.files = ratp.pt2db
 
-INSTALLS += target desktopFile db
+!CONFIG(staticprovider): INSTALLS += target
+INSTALLS += desktopFile db
@@ -53,11 +53,14 @@ namespace Provider
  *
  * This provider is a simple test provider. It do not
  * do anything useful.
+ *
+ * Its capabilities are declared in the plugin metadata,
+ * in test.json, so that it can be launched on demand.
  */
 class Test : public ProviderPluginObject
 {
     Q_OBJECT
-    Q_PLUGIN_METADATA(IID "org.SfietKonstantin.pt2.Plugin.ProviderPluginInterface")
+    Q_PLUGIN_METADATA(IID "org.SfietKonstantin.pt2.Plugin.ProviderPluginInterface" FILE "test.json")
     Q_INTERFACES(PT2::ProviderPluginInterface)
 public:
     /**
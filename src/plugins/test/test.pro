@@ -4,6 +4,7 @@ TARGET = test
 TEMPLATE = lib
 QT = core
 CONFIG += plugin
+CONFIG(staticprovider): CONFIG += static
 INCLUDEPATH += ../../lib
 LIBS += -L../../lib/ -l$${NAME}
 !CONFIG(semistatic): {
@@ -22,4 +23,5 @@ target.path = $${PLUGIN_FOLDER}
 desktopFile.path = $${PLUGIN_FOLDER}
 desktopFile.files = $${OTHER_FILES}
 
-INSTALLS += target desktopFile
+!CONFIG(staticprovider): INSTALLS += target
+INSTALLS += desktopFile
@@ -36,15 +36,38 @@
 
 #include "abstractmodel.h"
 #include "abstractmodel_p.h"
+
+#include <QtCore/QElapsedTimer>
+
 #include "manager/abstractbackendwrapper.h"
 #include "manager/abstractbackendmanager.h"
 
 namespace PT2
 {
 
+/**
+ * @internal
+ * @brief Time that can be spent inserting rows, in a frame, in milliseconds
+ */
+static const int INSERTION_BUDGET = 8;
+/**
+ * @internal
+ * @brief Number of rows inserted at once
+ */
+static const int INSERTION_CHUNK_SIZE = 10;
+/**
+ * @internal
+ * @brief Number of rows fetched at once
+ */
+static const int FETCH_SIZE = 50;
+
 AbstractModelPrivate::AbstractModelPrivate(AbstractModel *q)
-    : QObject(), q_ptr(q)
+    : QObject(), q_ptr(q), m_fetchLimit(FETCH_SIZE), m_insertionTimer(new QTimer(this))
 {
+    m_insertionTimer->setSingleShot(true);
+    m_insertionTimer->setInterval(0);
+    connect(m_insertionTimer, &QTimer::timeout,
+            this, &AbstractModelPrivate::slotInsertPendingRows);
 }
 
 void AbstractModelPrivate::slotStatusChanged()
@@ -54,12 +77,53 @@ void AbstractModelPrivate::slotStatusChanged()
         return;
     }
 
+    // Backends launched on demand stay connected, since they can
+    // answer from the result cache without being launched
+    if (backend->isLaunchedOnDemand()) {
+        return;
+    }
+
     if (backend->status() == AbstractBackendWrapper::Launched) {
         connectBackend(backend);
     }
 
-    if (backend->status() == AbstractBackendWrapper::Stopping) {
+    // Requests queued while a backend is launched on demand
+    // fail after the backend becomes invalid
+    if (backend->status() == AbstractBackendWrapper::Invalid) {
         disconnectBackend(backend);
+        connectBackend(backend);
+    }
+
+    if (backend->status() == AbstractBackendWrapper::Stopping
+        || backend->status() == AbstractBackendWrapper::Launching) {
+        disconnectBackend(backend);
+    }
+}
+
+void AbstractModelPrivate::slotInsertPendingRows()
+{
+    Q_Q(AbstractModel);
+    int oldCount = m_rows.count();
+    QElapsedTimer timer;
+    timer.start();
+
+    while (!m_pendingRows.isEmpty() && m_rows.count() < m_fetchLimit
+           && timer.elapsed() < INSERTION_BUDGET) {
+        int count = qMin(qMin(INSERTION_CHUNK_SIZE, m_pendingRows.count()),
+                         m_fetchLimit - m_rows.count());
+        q->beginInsertRows(QModelIndex(), m_rows.count(), m_rows.count() + count - 1);
+        m_rows.append(m_pendingRows.mid(0, count));
+        m_pendingRows.erase(m_pendingRows.begin(), m_pendingRows.begin() + count);
+        q->endInsertRows();
+    }
+
+    if (m_rows.count() != oldCount) {
+        emit q->countChanged();
+    }
+
+    // Continue in the next frame
+    if (!m_pendingRows.isEmpty() && m_rows.count() < m_fetchLimit) {
+        m_insertionTimer->start();
     }
 }
 
@@ -96,20 +160,127 @@ bool AbstractModelPrivate::requestRunning(const QString &request)
     return m_requests.contains(request);
 }
 
-const ModelData & AbstractModelPrivate::data(int index) const
+const ModelRowPointer & AbstractModelPrivate::row(int index) const
 {
-    return m_data.at(index);
+    return m_rows.at(index);
 }
 
-void AbstractModelPrivate::addData(const ModelDataList &data)
+const ModelRowList & AbstractModelPrivate::rows() const
+{
+    return m_rows;
+}
+
+void AbstractModelPrivate::addRows(const ModelRowList &rows)
+{
+    if (rows.count() > 0) {
+        m_pendingRows.append(rows);
+        slotInsertPendingRows();
+    }
+}
+
+void AbstractModelPrivate::setRows(const ModelRowList &newRows)
 {
     Q_Q(AbstractModel);
-    if (data.count() > 0) {
-        q->beginInsertRows(QModelIndex(), q->rowCount(), q->rowCount() + data.count() - 1);
-        m_data.append(data);
+    m_pendingRows.clear();
+    if (m_rows.isEmpty()) {
+        addRows(newRows);
+        return;
+    }
+
+    // Only the rows that are fetched are diffed
+    int oldCount = m_rows.count();
+    int limit = qMax(m_fetchLimit, oldCount);
+    m_fetchLimit = limit;
+    ModelRowList rows = newRows.mid(0, limit);
+
+    QSet<QString> keys;
+    foreach (const ModelRowPointer &row, rows) {
+        keys.insert(row->key());
+    }
+
+    // Remove rows that are not present anymore, by ranges
+    int i = m_rows.count() - 1;
+    while (i >= 0) {
+        if (keys.contains(m_rows.at(i)->key())) {
+            --i;
+            continue;
+        }
+
+        int last = i;
+        while (i >= 0 && !keys.contains(m_rows.at(i)->key())) {
+            --i;
+        }
+        q->beginRemoveRows(QModelIndex(), i + 1, last);
+        for (int j = last; j > i; --j) {
+            m_rows.removeAt(j);
+        }
+        q->endRemoveRows();
+    }
+
+    // Move, insert and update rows so that they match the new rows
+    for (i = 0; i < rows.count(); ++i) {
+        const ModelRowPointer &row = rows.at(i);
+        QString key = row->key();
+
+        int j = i;
+        while (j < m_rows.count() && m_rows.at(j)->key() != key) {
+            ++j;
+        }
+
+        if (j == m_rows.count()) {
+            q->beginInsertRows(QModelIndex(), i, i);
+            m_rows.insert(i, row);
+            q->endInsertRows();
+            continue;
+        }
+
+        if (j != i) {
+            q->beginMoveRows(QModelIndex(), j, j, QModelIndex(), i);
+            m_rows.move(j, i);
+            q->endMoveRows();
+        }
+
+        bool changed = !m_rows.at(i)->equals(row.data());
+        m_rows[i] = row;
+        if (changed) {
+            emit q->dataChanged(q->index(i), q->index(i));
+        }
+    }
+
+    // Remaining rows are duplicated keys
+    if (m_rows.count() > rows.count()) {
+        q->beginRemoveRows(QModelIndex(), rows.count(), m_rows.count() - 1);
+        while (m_rows.count() > rows.count()) {
+            m_rows.removeLast();
+        }
+        q->endRemoveRows();
+    }
+
+    if (m_rows.count() != oldCount) {
         emit q->countChanged();
-        q->endInsertRows();
     }
+
+    m_pendingRows = newRows.mid(limit);
+}
+
+void AbstractModelPrivate::clearRows()
+{
+    Q_Q(AbstractModel);
+    m_pendingRows.clear();
+    m_insertionTimer->stop();
+    m_fetchLimit = FETCH_SIZE;
+    if (m_rows.count() > 0) {
+        q->beginRemoveRows(QModelIndex(), 0, m_rows.count() - 1);
+        m_rows.clear();
+        q->endRemoveRows();
+        emit q->countChanged();
+    }
+}
+
+void AbstractModelPrivate::fetchMore()
+{
+    m_fetchLimit = m_rows.count() + FETCH_SIZE;
+    slotInsertPendingRows();
 }
 
 void AbstractModelPrivate::connectBackend(AbstractBackendWrapper *backend)
@@ -150,7 +321,7 @@ int AbstractModel::rowCount(const QModelIndex &parent) const
 {
     Q_D(const AbstractModel);
     Q_UNUSED(parent)
-    return d->m_data.count();
+    return d->m_rows.count();
 }
 
 QVariant AbstractModel::data(const QModelIndex &index, int role) const
@@ -160,19 +331,32 @@ QVariant AbstractModel::data(const QModelIndex &index, int role) const
         return QVariant();
     }
 
-    return d->m_data.at(index.row()).value(role);
+    return d->m_rows.at(index.row())->data(role);
+}
+
+bool AbstractModel::canFetchMore(const QModelIndex &parent) const
+{
+    Q_D(const AbstractModel);
+    if (parent.isValid()) {
+        return false;
+    }
+    return !d->m_pendingRows.isEmpty();
+}
+
+void AbstractModel::fetchMore(const QModelIndex &parent)
+{
+    Q_D(AbstractModel);
+    if (parent.isValid()) {
+        return;
+    }
+    d->fetchMore();
 }
 
 void AbstractModel::clear()
 {
     Q_D(AbstractModel);
     d->m_requests.clear();
-    if (d->m_data.count() > 0) {
-        beginRemoveRows(QModelIndex(), 0, rowCount() - 1);
-        d->m_data.clear();
-        endRemoveRows();
-        emit countChanged();
-    }
+    d->clearRows();
 }
 
 }
@@ -100,6 +100,22 @@ public:
      * @return retrieved data as a variant.
      */
     virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    /**
+     * @short Reimplementation of canFetchMore
+     *
+     * Large results are not inserted at once in the model.
+     * Instead, the first rows are inserted, and the other rows
+     * are inserted when the view needs them.
+     *
+     * @param parent parent model index.
+     * @return if there are more rows to insert.
+     */
+    bool canFetchMore(const QModelIndex &parent) const;
+    /**
+     * @short Reimplementation of fetchMore
+     * @param parent parent model index.
+     */
+    void fetchMore(const QModelIndex &parent);
 public Q_SLOTS:
     /**
      * @brief Clear
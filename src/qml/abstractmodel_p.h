@@ -38,27 +38,76 @@
  */
 
 #include <QtCore/QObject>
-#include <QtCore/QMap>
+#include <QtCore/QList>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QVariant>
 #include <QtCore/QSet>
+#include <QtCore/QTimer>
 
 namespace PT2
 {
 
 /**
  * @internal
- * @brief Model data
+ * @brief Model row
+ *
+ * Base for the rows stored in PT2::AbstractModelPrivate.
+ *
+ * Each model defines its own row, that stores the
+ * row data as typed members, and implements data()
+ * by switching on the roles of the model.
+ *
+ * Rows also provide a key, that identifies the item
+ * that they represent, and that is used to compute
+ * the differences between two lists of rows in
+ * PT2::AbstractModelPrivate::setRows().
+ */
+struct ModelRow
+{
+    /**
+     * @internal
+     * @brief Destructor
+     */
+    virtual ~ModelRow() {}
+    /**
+     * @internal
+     * @brief Data for a role
+     * @param role role to retrieve.
+     * @return retrieved data as a variant.
+     */
+    virtual QVariant data(int role) const = 0;
+    /**
+     * @internal
+     * @brief Key
+     *
+     * Two rows with the same key represent the same item,
+     * possibly with different data.
+     *
+     * @return key.
+     */
+    virtual QString key() const = 0;
+    /**
+     * @internal
+     * @brief If this row have the same data as another row
+     * @param other other row, that have the same key.
+     * @return if this row have the same data as the other row.
+     */
+    virtual bool equals(const ModelRow *other) const = 0;
+};
+/**
+ * @internal
+ * @brief Model row pointer
  *
  * Used in PT2::AbstractModelPrivate.
  */
-typedef QMap<int, QVariant> ModelData;
+typedef QSharedPointer<ModelRow> ModelRowPointer;
 /**
  * @internal
- * @brief Model data list
+ * @brief Model row list
  *
  * Used in PT2::AbstractModelPrivate.
  */
-typedef QList<ModelData> ModelDataList;
+typedef QList<ModelRowPointer> ModelRowList;
 
 class AbstractBackendWrapper;
 class AbstractModel;
@@ -82,6 +131,14 @@ public Q_SLOTS:
      * @brief Slot status changed
      */
     void slotStatusChanged();
+    /**
+     * @internal
+     * @brief Slot insert queued rows
+     *
+     * Rows are inserted until the time budget for this
+     * frame is spent, or until enough rows are fetched.
+     */
+    void slotInsertPendingRows();
     /**
      * @internal
      * @brief Slot error registered
@@ -111,13 +168,61 @@ protected:
      * @return if the model is running the request.
      */
     bool requestRunning(const QString &request);
-    const ModelData & data(int index) const;
     /**
      * @internal
-     * @brief Add data
-     * @param data data to add.
+     * @brief Row
+     * @param index index of the row.
+     * @return row.
+     */
+    const ModelRowPointer & row(int index) const;
+    /**
+     * @internal
+     * @brief Rows
+     * @return rows.
+     */
+    const ModelRowList & rows() const;
+    /**
+     * @internal
+     * @brief Add rows
+     *
+     * Rows are not inserted immediately, but are queued, and
+     * inserted by chunks, without spending more than a fraction
+     * of a frame for each chunk. Only the first rows are inserted,
+     * the other rows being inserted when the view asks for them,
+     * through AbstractModel::fetchMore().
+     *
+     * @param rows rows to add.
+     */
+    void addRows(const ModelRowList &rows);
+    /**
+     * @internal
+     * @brief Set rows
+     *
+     * The current rows are replaced by the new rows, by
+     * removing, moving and inserting rows, and by updating
+     * the rows whose data changed. Rows are matched using
+     * their keys, so that views keep the delegates of the
+     * rows that are still present.
+     *
+     * If the model is empty, the rows are added using addRows().
+     * Otherwise, only the rows that fits in the already fetched
+     * rows are diffed, the others being queued.
+     *
+     * @param rows new rows.
+     */
+    void setRows(const ModelRowList &rows);
+    /**
+     * @internal
+     * @brief Clear rows
+     *
+     * Both the displayed and queued rows are removed.
      */
-    void addData(const ModelDataList &data);
+    void clearRows();
+    /**
+     * @internal
+     * @brief Fetch more rows
+     */
+    void fetchMore();
     /**
      * @internal
      * @brief Connect backend
@@ -144,9 +249,24 @@ protected:
 private:
     /**
      * @internal
-     * @brief Data
+     * @brief Rows
+     */
+    ModelRowList m_rows;
+    /**
+     * @internal
+     * @brief Rows that are not inserted yet
+     */
+    ModelRowList m_pendingRows;
+    /**
+     * @internal
+     * @brief Number of rows that should be inserted
+     */
+    int m_fetchLimit;
+    /**
+     * @internal
+     * @brief Timer used to insert queued rows
      */
-    ModelDataList m_data;
+    QTimer *m_insertionTimer;
     /**
      * @internal
      * @brief Requests
@@ -48,9 +48,25 @@ void AbstractMultiBackendModelPrivate::slotBackendAdded(const QString &identifie
     Q_UNUSED(identifier)
     connect(backend, &AbstractBackendWrapper::statusChanged,
             this, &AbstractModelPrivate::slotStatusChanged);
+    if (backend->isLaunchedOnDemand()) {
+        connectBackend(backend);
+    }
 }
 
 
+QList<AbstractBackendWrapper *> AbstractMultiBackendModelPrivate::availableBackends() const
+{
+    if (!backendManager) {
+        return QList<AbstractBackendWrapper *>();
+    }
+
+    return backendManager->availableBackends(country, city);
+}
+
+void AbstractMultiBackendModelPrivate::regionChanged()
+{
+}
+
 ////// End of private class //////
 
 AbstractMultiBackendModel::AbstractMultiBackendModel(AbstractMultiBackendModelPrivate &dd,
@@ -73,7 +89,10 @@ void AbstractMultiBackendModel::setBackendManager(AbstractBackendManager *backen
         if (d->backendManager) {
             disconnect(d->backendManager, &AbstractBackendManager::backendAdded,
                        d, &AbstractMultiBackendModelPrivate::slotBackendAdded);
-            foreach (AbstractBackendWrapper *backend, d->backendManager->backends()) {
+            foreach (const QString &identifier, d->backendManager->identifiers()) {
+                AbstractBackendWrapper *backend = d->backendManager->backend(identifier);
+                disconnect(backend, &AbstractBackendWrapper::statusChanged,
+                           d, &AbstractModelPrivate::slotStatusChanged);
                 d->disconnectBackend(backend);
             }
         }
@@ -83,8 +102,15 @@ void AbstractMultiBackendModel::setBackendManager(AbstractBackendManager *backen
         if (d->backendManager) {
             connect(d->backendManager, &AbstractBackendManager::backendAdded,
                     d, &AbstractMultiBackendModelPrivate::slotBackendAdded);
+            // Backends launched on demand are always connected, and
+            // other backends are connected when they are launched
+            foreach (const QString &identifier, d->backendManager->identifiers()) {
+                d->slotBackendAdded(identifier, d->backendManager->backend(identifier));
+            }
             foreach (AbstractBackendWrapper *backend, d->backendManager->backends()) {
-                d->connectBackend(backend);
+                if (!backend->isLaunchedOnDemand()) {
+                    d->connectBackend(backend);
+                }
             }
         }
 
@@ -92,5 +118,37 @@ void AbstractMultiBackendModel::setBackendManager(AbstractBackendManager *backen
     }
 }
 
+QString AbstractMultiBackendModel::country() const
+{
+    Q_D(const AbstractMultiBackendModel);
+    return d->country;
+}
+
+void AbstractMultiBackendModel::setCountry(const QString &country)
+{
+    Q_D(AbstractMultiBackendModel);
+    if (d->country != country) {
+        d->country = country;
+        emit countryChanged();
+        d->regionChanged();
+    }
+}
+
+QString AbstractMultiBackendModel::city() const
+{
+    Q_D(const AbstractMultiBackendModel);
+    return d->city;
+}
+
+void AbstractMultiBackendModel::setCity(const QString &city)
+{
+    Q_D(AbstractMultiBackendModel);
+    if (d->city != city) {
+        d->city = city;
+        emit cityChanged();
+        d->regionChanged();
+    }
+}
+
 
 }
@@ -47,6 +47,14 @@ class AbstractMultiBackendModel : public AbstractModel
      */
     Q_PROPERTY(PT2::AbstractBackendManager * backendManager READ backendManager
                WRITE setBackendManager NOTIFY backendManagerChanged)
+    /**
+     * @short Country
+     */
+    Q_PROPERTY(QString country READ country WRITE setCountry NOTIFY countryChanged)
+    /**
+     * @short City
+     */
+    Q_PROPERTY(QString city READ city WRITE setCity NOTIFY cityChanged)
 public:
     /**
      * @brief Backend manager
@@ -58,11 +66,47 @@ public:
      * @param backendManager backend manager to set.
      */
     void setBackendManager(AbstractBackendManager *backendManager);
+    /**
+     * @brief Country
+     *
+     * The country and the city are the region where requests
+     * are performed. Only the backends that cover this region
+     * are queried. An empty country queries all the backends.
+     *
+     * @return country code.
+     */
+    QString country() const;
+    /**
+     * @brief Set country
+     * @param country country code to set.
+     */
+    void setCountry(const QString &country);
+    /**
+     * @brief City
+     *
+     * An empty city queries all the backends of the country.
+     *
+     * @return city.
+     */
+    QString city() const;
+    /**
+     * @brief Set city
+     * @param city city to set.
+     */
+    void setCity(const QString &city);
 Q_SIGNALS:
     /**
      * @brief Backend manager changed
      */
     void backendManagerChanged();
+    /**
+     * @brief Country changed
+     */
+    void countryChanged();
+    /**
+     * @brief City changed
+     */
+    void cityChanged();
 protected:
     /**
      * @brief D-pointer based constructor
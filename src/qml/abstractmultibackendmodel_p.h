@@ -63,6 +63,31 @@ public:
      * @brief Backend manager
      */
     AbstractBackendManager *backendManager;
+    /**
+     * @internal
+     * @brief Country
+     */
+    QString country;
+    /**
+     * @internal
+     * @brief City
+     */
+    QString city;
+protected:
+    /**
+     * @internal
+     * @brief Available backends in the region of the model
+     * @return available backends in the region of the model.
+     */
+    QList<AbstractBackendWrapper *> availableBackends() const;
+    /**
+     * @internal
+     * @brief Region changed
+     *
+     * Called when the country or the city changed. The default
+     * implementation does nothing.
+     */
+    virtual void regionChanged();
 private Q_SLOTS:
     /**
      * @internal
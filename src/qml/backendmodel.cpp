@@ -36,6 +36,10 @@
 
 #include "backendmodel.h"
 
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
+
 #include "manager/backendlistmanager.h"
 #include "manager/abstractbackendmanager.h"
 #include "manager/backendinfo.h"
@@ -65,11 +69,41 @@ public:
      * @return status of the backend.
      */
     BackendModel::BackendStatus status(const BackendInfo &backendInfo) const;
+    /**
+     * @internal
+     * @brief Rebuild the indexes of the backends
+     */
+    void updateBackendIndexes();
+    /**
+     * @internal
+     * @brief Backends matching the filter
+     * @return indexes of the backends matching the filter, in increasing order.
+     */
+    QList<int> filteredBackends() const;
     /**
      * @internal
      * @brief Apply filter
+     *
+     * Only the rows that do not match the filter anymore are
+     * removed, and only the rows that now match the filter are
+     * inserted, using as few ranges as possible.
      */
     void applyfilter();
+    /**
+     * @internal
+     * @brief Remove the rows of backends
+     *
+     * Rows are removed by contiguous ranges. The indexes
+     * of the rows are not updated.
+     *
+     * @param indexes indexes of the backends whose rows should be removed.
+     */
+    void removeRows(const QSet<int> &indexes);
+    /**
+     * @internal
+     * @brief Rebuild the index of the rows
+     */
+    void updateRowIndex();
     /**
      * @internal
      * @brief Filter
@@ -90,17 +124,56 @@ public:
      * @short Backends
      */
     QList<BackendInfo> backends;
+    /**
+     * @internal
+     * @short Index of the backends, by identifier
+     */
+    QHash<QString, int> backendIndex;
+    /**
+     * @internal
+     * @short Index of the backends, by country
+     *
+     * Indexes of the backends of each country, in increasing order.
+     * There is no index by city, since the filter only matches
+     * countries.
+     */
+    QHash<QString, QList<int> > countryIndex;
     /**
      * @internal
      * @short Data
+     *
+     * Indexes of the displayed backends, in increasing order.
+     */
+    QList<int> data;
+    /**
+     * @internal
+     * @short Index of the rows, by backend identifier
      */
-    QList<BackendInfo> data;
+    QHash<QString, int> rowIndex;
 public Q_SLOTS:
     /**
      * @internal
      * @brief Slot for status changed
      */
     void slotStatusChanged();
+    /**
+     * @internal
+     * @brief Slot for backend list changed
+     *
+     * Only the rows of the removed backends are removed, and
+     * the added backends that match the filter are appended.
+     *
+     * @param added backends that were added.
+     * @param removed identifiers of the backends that were removed.
+     */
+    void slotBackendListChanged(const QList<PT2::BackendInfo> &added, const QStringList &removed);
+    /**
+     * @internal
+     * @brief Slot for backend added
+     * @param identifier identifier.
+     * @param backend backend.
+     */
+    void slotBackendAdded(const QString &identifier, AbstractBackendWrapper *backend);
 private:
     /**
      * @internal
@@ -115,6 +188,10 @@ BackendModelPrivate::BackendModelPrivate(BackendModel *q):
 {
     backendManager = 0;
     backendListManager = new BackendListManager(q);
+    connect(backendListManager, &BackendListManager::backendListChanged,
+            this, &BackendModelPrivate::slotBackendListChanged);
+    connect(backendListManager, &BackendListManager::loadingChanged,
+            q, &BackendModel::loadingChanged);
 }
 
 BackendModel::BackendStatus BackendModelPrivate::status(const BackendInfo &backendInfo) const
@@ -129,25 +206,98 @@ BackendModel::BackendStatus BackendModelPrivate::status(const BackendInfo &backe
     return (BackendModel::BackendStatus) backendWrapper->status();
 }
 
+void BackendModelPrivate::updateBackendIndexes()
+{
+    backendIndex.clear();
+    countryIndex.clear();
+    for (int i = 0; i < backends.count(); ++i) {
+        const BackendInfo &backendInfo = backends.at(i);
+        backendIndex.insert(backendInfo.backendIdentifier(), i);
+        countryIndex[backendInfo.backendCountry()].append(i);
+    }
+}
+
+QList<int> BackendModelPrivate::filteredBackends() const
+{
+    if (!filter.isEmpty()) {
+        return countryIndex.value(filter);
+    }
+
+    QList<int> indexes;
+    indexes.reserve(backends.count());
+    for (int i = 0; i < backends.count(); ++i) {
+        indexes.append(i);
+    }
+    return indexes;
+}
+
 void BackendModelPrivate::applyfilter()
 {
     Q_Q(BackendModel);
-    if (data.count() > 0) {
-        q->beginRemoveRows(QModelIndex(), 0, data.count() - 1);
-        data.clear();
-        q->endRemoveRows();
-    }
+    int oldCount = data.count();
+    QList<int> newData = filteredBackends();
+
+    // Rows that do not match the filter anymore are removed first
+    removeRows(data.toSet().subtract(newData.toSet()));
+
+    // Both lists are sorted, so the rows to insert are
+    // found by walking them together
+
+    int row = 0;
+    int i = 0;
+    while (i < newData.count()) {
+        if (row < data.count() && data.at(row) == newData.at(i)) {
+            ++row;
+            ++i;
+            continue;
+        }
 
-    foreach (BackendInfo backendInfo, backends) {
-        if (filter.isEmpty() || backendInfo.backendCountry() == filter) {
-            data.append(backendInfo);
+        int count = 0;
+        while (i + count < newData.count()
+               && (row >= data.count() || newData.at(i + count) < data.at(row))) {
+            ++count;
+        }
+        q->beginInsertRows(QModelIndex(), row, row + count - 1);
+        for (int j = 0; j < count; ++j) {
+            data.insert(row + j, newData.at(i + j));
         }
+        q->endInsertRows();
+        row += count;
+        i += count;
     }
 
-    if (data.count() > 0) {
-        q->beginInsertRows(QModelIndex(), 0, data.count() - 1);
+    updateRowIndex();
+    if (data.count() != oldCount) {
         emit q->countChanged();
-        q->endInsertRows();
+    }
+}
+
+void BackendModelPrivate::removeRows(const QSet<int> &indexes)
+{
+    Q_Q(BackendModel);
+    int end = data.count();
+    while (end > 0) {
+        if (!indexes.contains(data.at(end - 1))) {
+            --end;
+            continue;
+        }
+
+        int start = end - 1;
+        while (start > 0 && indexes.contains(data.at(start - 1))) {
+            --start;
+        }
+        q->beginRemoveRows(QModelIndex(), start, end - 1);
+        data.erase(data.begin() + start, data.begin() + end);
+        q->endRemoveRows();
+        end = start;
+    }
+}
+
+void BackendModelPrivate::updateRowIndex()
+{
+    rowIndex.clear();
+    for (int i = 0; i < data.count(); ++i) {
+        rowIndex.insert(backends.at(data.at(i)).backendIdentifier(), i);
     }
 }
 
@@ -163,20 +313,92 @@ void BackendModelPrivate::slotStatusChanged()
         return;
     }
 
-    QString identifier = backendWrapper->identifier();
+    int index = rowIndex.value(backendWrapper->identifier(), -1);
+    if (index == -1) {
+        return;
+    }
 
-    int index = -1;
-    for (int i = 0; i < data.size(); i++) {
-        if (backends.at(i).backendIdentifier() == identifier) {
-            index = i;
+    emit q->dataChanged(q->index(index), q->index(index),
+                        QVector<int>() << BackendModel::StatusRole);
+}
+
+void BackendModelPrivate::slotBackendAdded(const QString &identifier,
+                                           AbstractBackendWrapper *backend)
+{
+    Q_Q(BackendModel);
+    connect(backend, &AbstractBackendWrapper::statusChanged,
+            this, &BackendModelPrivate::slotStatusChanged);
+
+    int index = rowIndex.value(identifier, -1);
+    if (index != -1) {
+        emit q->dataChanged(q->index(index), q->index(index),
+                            QVector<int>() << BackendModel::StatusRole);
+    }
+}
+
+void BackendModelPrivate::slotBackendListChanged(const QList<BackendInfo> &added,
+                                                 const QStringList &removed)
+{
+    Q_Q(BackendModel);
+    int oldCount = data.count();
+
+    // Removed backends are dropped in a single pass
+    QSet<int> removedIndexes;
+    foreach (const QString &identifier, removed) {
+        int index = backendIndex.value(identifier, -1);
+        if (index != -1) {
+            removedIndexes.insert(index);
         }
     }
 
-    if (index == -1) {
-        return;
+    if (!removedIndexes.isEmpty()) {
+        removeRows(removedIndexes);
+
+        // Indexes of the following backends are shifted
+        QVector<int> newIndexes (backends.count(), -1);
+        QList<BackendInfo> newBackends;
+        newBackends.reserve(backends.count() - removedIndexes.count());
+        for (int i = 0; i < backends.count(); ++i) {
+            if (!removedIndexes.contains(i)) {
+                newIndexes[i] = newBackends.count();
+                newBackends.append(backends.at(i));
+            }
+        }
+        backends = newBackends;
+        for (int i = 0; i < data.count(); ++i) {
+            data[i] = newIndexes.at(data.at(i));
+        }
+    }
+
+    // Enabled backends are started with their stored informations,
+    // that are updated when their desktop file changed
+    QStringList enabledBackends;
+    if (backendManager) {
+        enabledBackends = backendManager->enabledBackends();
+    }
+
+    QList<int> addedRows;
+    foreach (const BackendInfo &backendInfo, added) {
+        if (filter.isEmpty() || backendInfo.backendCountry() == filter) {
+            addedRows.append(backends.count());
+        }
+        backends.append(backendInfo);
+        if (enabledBackends.contains(backendInfo.backendIdentifier())) {
+            backendManager->setBackendEnabled(backendInfo, true);
+        }
     }
+    updateBackendIndexes();
 
-    emit q->dataChanged(q->index(index), q->index(index));
+    if (!addedRows.isEmpty()) {
+        q->beginInsertRows(QModelIndex(), data.count(), data.count() + addedRows.count() - 1);
+        data.append(addedRows);
+        q->endInsertRows();
+    }
+    updateRowIndex();
+
+    if (data.count() != oldCount) {
+        emit q->countChanged();
+    }
 }
 
 
@@ -213,7 +435,26 @@ void BackendModel::setBackendManager(AbstractBackendManager *backendManager)
 {
     Q_D(BackendModel);
     if (d->backendManager != backendManager) {
+        if (d->backendManager) {
+            disconnect(d->backendManager, &AbstractBackendManager::backendAdded,
+                       d, &BackendModelPrivate::slotBackendAdded);
+            foreach (const QString &identifier, d->backendManager->identifiers()) {
+                disconnect(d->backendManager->backend(identifier),
+                           &AbstractBackendWrapper::statusChanged,
+                           d, &BackendModelPrivate::slotStatusChanged);
+            }
+        }
+
         d->backendManager = backendManager;
+
+        // Enabled backends might already be started by the manager
+        if (d->backendManager) {
+            connect(d->backendManager, &AbstractBackendManager::backendAdded,
+                    d, &BackendModelPrivate::slotBackendAdded);
+            foreach (const QString &identifier, d->backendManager->identifiers()) {
+                d->slotBackendAdded(identifier, d->backendManager->backend(identifier));
+            }
+        }
         emit backendManagerChanged();
     }
 }
@@ -237,6 +478,7 @@ void BackendModel::setFilter(const QString &filter)
     if (d->filter != filter) {
         d->filter = filter;
         d->applyfilter();
+        emit filterChanged();
     }
 }
 
@@ -245,13 +487,19 @@ int BackendModel::count() const
     return rowCount();
 }
 
+bool BackendModel::isLoading() const
+{
+    Q_D(const BackendModel);
+    return d->backendListManager->isLoading();
+}
+
 QVariant BackendModel::data(const QModelIndex &index, int role) const
 {
     Q_D(const BackendModel);
     if (index.row() < 0 or index.row() >= rowCount()) {
         return QVariant();
     }
-    BackendInfo backendInfo = d->data.at(index.row());
+    const BackendInfo &backendInfo = d->backends.at(d->data.at(index.row()));
 
     switch(role) {
     case NameRole:
@@ -276,11 +524,8 @@ void BackendModel::reload()
 {
     Q_D(BackendModel);
     d->backendListManager->reload();
-    QList<BackendInfo> availableBackendList = d->backendListManager->backendList();
-    d->backends = availableBackendList;
-    d->applyfilter();
 
-    debug("backend-model") << "Reloaded information in the model. Number of rows:" << rowCount();
+    debug("backend-model") << "Reloading information in the model";
 }
 
 void BackendModel::startBackend(const QString &identifier)
@@ -290,12 +535,21 @@ void BackendModel::startBackend(const QString &identifier)
         return;
     }
 
+    int index = d->backendIndex.value(identifier, -1);
+    if (index != -1) {
+        d->backendManager->setBackendEnabled(d->backends.at(index), true);
+    }
+
     if (d->backendManager->contains(identifier)) {
         AbstractBackendWrapper *backend = d->backendManager->backend(identifier);
 
         if (backend->status() == AbstractBackendWrapper::Stopped) {
             backend->launch();
             return;
+        } else if (backend->status() == AbstractBackendWrapper::Launching
+                   || backend->status() == AbstractBackendWrapper::Launched) {
+            // Already started with the enabled backends
+            return;
         } else {
             backend->kill();
             backend->launch();
@@ -303,18 +557,40 @@ void BackendModel::startBackend(const QString &identifier)
         }
     }
 
-    QMap<QString, BackendInfo> identifierToBackend;
-    foreach (BackendInfo backendInfo, d->backendListManager->backendList()) {
-        identifierToBackend.insert(backendInfo.backendIdentifier(), backendInfo);
+    if (index == -1) {
+        return;
+    }
+
+    // The backend informations are used, so that the backend
+    // is routed by region and can be launched on demand
+    d->backendManager->addBackend(d->backends.at(index));
+    d->backendManager->launchBackend(identifier);
+}
+
+void BackendModel::enableBackend(const QString &identifier)
+{
+    Q_D(BackendModel);
+    if (!d->backendManager) {
+        return;
+    }
+
+    int index = d->backendIndex.value(identifier, -1);
+    if (index == -1) {
+        return;
     }
 
-    d->backendManager->addBackend(identifier, identifierToBackend.value(identifier).executable(),
-                                  QMap<QString, QString>());
+    const BackendInfo &backendInfo = d->backends.at(index);
+    if (backendInfo.capabilities().isEmpty()) {
+        startBackend(identifier);
+        return;
+    }
 
-    connect(d->backendManager->backend(identifier), &AbstractBackendWrapper::statusChanged,
-            d, &BackendModelPrivate::slotStatusChanged);
+    d->backendManager->setBackendEnabled(backendInfo, true);
+    if (d->backendManager->contains(identifier)) {
+        return;
+    }
 
-    d->backendManager->launchBackend(identifier);
+    d->backendManager->addBackend(backendInfo);
 }
 
 void BackendModel::stopBackend(const QString &identifier)
@@ -324,6 +600,11 @@ void BackendModel::stopBackend(const QString &identifier)
         return;
     }
 
+    int index = d->backendIndex.value(identifier, -1);
+    if (index != -1) {
+        d->backendManager->setBackendEnabled(d->backends.at(index), false);
+    }
+
     if (!d->backendManager->contains(identifier)) {
         return;
     }
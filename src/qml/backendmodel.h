@@ -59,9 +59,10 @@ class BackendModelPrivate;
  *
  * When a backend have been previously started, and not
  * stopped, it is considered as useful, and should be
- * restart. When the list of backends are reloaded, these
- * backends are then restarted automatically (that happen,
- * for example, while the application is launched again).
+ * restart. These backends are stored as enabled in the
+ * backend manager, that restarts them automatically when
+ * the application is launched again, without waiting for
+ * the backend list to be loaded.
  *
  * This model can also be filtered, using the filter() property.
  * This filter takes a country code, or an empty string for all countries,
@@ -79,6 +80,10 @@ class BackendModel : public QAbstractListModel
      * @short Count
      */
     Q_PROPERTY(int count READ count NOTIFY countChanged)
+    /**
+     * @short Loading
+     */
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
     /**
      * @short Backend manager
      */
@@ -178,6 +183,15 @@ public:
      * @return count.
      */
     int count() const;
+    /**
+     * @brief Is loading
+     *
+     * The backend list is loaded asynchronously, and
+     * rows are inserted when it is loaded.
+     *
+     * @return if the backend list is loading.
+     */
+    bool isLoading() const;
     /**
      * @short Reimplementation of data
      *
@@ -198,6 +212,17 @@ public Q_SLOTS:
      * @param identifier backend identifier.
      */
     void startBackend(const QString &identifier);
+    /**
+     * @brief Enable a backend
+     *
+     * If the backend declares its capabilities, it is not
+     * started immediately, but when a model performs the first
+     * request that needs it, and it is stopped when it is idle.
+     * Otherwise, it is started with startBackend().
+     *
+     * @param identifier backend identifier.
+     */
+    void enableBackend(const QString &identifier);
     /**
      * @brief Stop a backend.
      * @param identifier backend identifier.
@@ -212,6 +237,10 @@ Q_SIGNALS:
      * @short Count changed
      */
     void countChanged();
+    /**
+     * @brief Loading changed
+     */
+    void loadingChanged();
     /**
      * @brief Backend manager changed
      */
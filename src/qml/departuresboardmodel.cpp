@@ -0,0 +1,679 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+/**
+ * @file departuresboardmodel.cpp
+ * @short Implementation of PT2::DeparturesBoardModel
+ */
+
+#include "departuresboardmodel.h"
+#include "abstractmultibackendmodel_p.h"
+
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QVariantMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include "realtimestationsearchmodel.h"
+#include "debug.h"
+#include "base/station.h"
+#include "base/ride.h"
+#include "base/companynodedata.h"
+#include "base/linenodedata.h"
+#include "base/ridenodedata.h"
+#include "manager/abstractbackendmanager.h"
+#include "manager/abstractbackendwrapper.h"
+
+namespace PT2
+{
+
+/**
+ * @internal
+ * @brief Ride property containing the next departures
+ */
+static const char *DEPARTURES_KEY = "departures";
+/**
+ * @internal
+ * @brief Default interval between two refreshes, in milliseconds
+ */
+static const int DEFAULT_REFRESH_INTERVAL = 60000;
+/**
+ * @internal
+ * @brief Key for the backend identifier of a station, in the stations property
+ */
+static const char *BACKEND_IDENTIFIER_KEY = "backendIdentifier";
+/**
+ * @internal
+ * @brief Key for the identifier of a station, in the stations property
+ */
+static const char *IDENTIFIER_KEY = "identifier";
+/**
+ * @internal
+ * @brief Key for the name of a station, in the stations property
+ */
+static const char *NAME_KEY = "name";
+/**
+ * @internal
+ * @brief Key for the internal data of a station, in the stations property
+ */
+static const char *INTERNAL_KEY = "internal";
+/**
+ * @internal
+ * @brief Key for the properties of a station, in the stations property
+ */
+static const char *PROPERTIES_KEY = "properties";
+
+/**
+ * @internal
+ * @short Row for PT2::DeparturesBoardModel
+ */
+struct DepartureRow: public ModelRow
+{
+    QVariant data(int role) const;
+    QString key() const;
+    bool equals(const ModelRow *other) const;
+    /**
+     * @internal
+     * @short Key of the station
+     */
+    QString stationKey;
+    /**
+     * @internal
+     * @short Station name
+     */
+    QString station;
+    /**
+     * @internal
+     * @short Line identifier
+     */
+    QString lineIdentifier;
+    /**
+     * @internal
+     * @short Ride identifier
+     */
+    QString rideIdentifier;
+    /**
+     * @internal
+     * @short Line name
+     */
+    QString line;
+    /**
+     * @internal
+     * @short Ride name
+     */
+    QString name;
+    /**
+     * @internal
+     * @short Next departures
+     */
+    QStringList departures;
+};
+
+QVariant DepartureRow::data(int role) const
+{
+    switch (role) {
+    case DeparturesBoardModel::StationRole:
+        return station;
+        break;
+    case DeparturesBoardModel::LineRole:
+        return line;
+        break;
+    case DeparturesBoardModel::NameRole:
+        return name;
+        break;
+    case DeparturesBoardModel::DeparturesRole:
+        return departures;
+        break;
+    default:
+        return QVariant();
+        break;
+    }
+}
+
+QString DepartureRow::key() const
+{
+    return stationKey + QLatin1Char('\n') + lineIdentifier + QLatin1Char('\n') + rideIdentifier;
+}
+
+bool DepartureRow::equals(const ModelRow *other) const
+{
+    const DepartureRow *otherRow = static_cast<const DepartureRow *>(other);
+    return station == otherRow->station && line == otherRow->line && name == otherRow->name
+            && departures == otherRow->departures;
+}
+
+/**
+ * @internal
+ * @short Sort and flatten the rides of a station into rows
+ *
+ * Rides that are provided several times are only
+ * added once. This method is run in a worker thread.
+ *
+ * @param rides rides to flatten.
+ * @param stationKey key of the station.
+ * @param station station name.
+ * @return rows.
+ */
+static ModelRowList flattenDepartures(QList<CompanyNodeData> rides, const QString &stationKey,
+                                      const QString &station)
+{
+    ModelRowList rows;
+    QSet<QString> keys;
+    for (int i = 0; i < rides.count(); ++i) {
+        CompanyNodeData &companyNodeData = rides[i];
+        companyNodeData.sort();
+
+        foreach (const LineNodeData &lineNodeData, companyNodeData.lineNodeDataList()) {
+            foreach (const RideNodeData &rideNodeData, lineNodeData.rideNodeDataList()) {
+                DepartureRow *row = new DepartureRow;
+                row->stationKey = stationKey;
+                row->station = station;
+                row->lineIdentifier = lineNodeData.line().identifier();
+                row->rideIdentifier = rideNodeData.ride().identifier();
+                row->line = lineNodeData.line().name();
+                row->name = rideNodeData.ride().name();
+                row->departures = rideNodeData.ride().properties().value(DEPARTURES_KEY).toStringList();
+
+                if (keys.contains(row->key())) {
+                    delete row;
+                    continue;
+                }
+                keys.insert(row->key());
+                rows.append(ModelRowPointer(row));
+            }
+        }
+    }
+    return rows;
+}
+
+/**
+ * @internal
+ * @short Station displayed in PT2::DeparturesBoardModel
+ */
+struct BoardStation
+{
+    /**
+     * @internal
+     * @short Identifier of the backend that provided the station
+     */
+    QString backendIdentifier;
+    /**
+     * @internal
+     * @short Station
+     */
+    Station station;
+    /**
+     * @internal
+     * @short Latest request for the rides of the station
+     */
+    QString request;
+    /**
+     * @internal
+     * @short Rows of the station
+     */
+    ModelRowList rows;
+};
+
+/**
+ * @internal
+ * @short Private class for PT2::DeparturesBoardModel
+ */
+class DeparturesBoardModelPrivate: public AbstractMultiBackendModelPrivate
+{
+    Q_OBJECT
+public:
+    /**
+     * @internal
+     * @short Default constructor
+     * @param q Q-pointer.
+     */
+    explicit DeparturesBoardModelPrivate(DeparturesBoardModel *q);
+    /**
+     * @internal
+     * @brief Key of a station
+     * @param backendIdentifier identifier of the backend that provided the station.
+     * @param station station.
+     * @return key of the station.
+     */
+    static QString stationKey(const QString &backendIdentifier, const Station &station);
+    /**
+     * @internal
+     * @brief Index of a station
+     * @param key key of the station.
+     * @return index of the station, or -1.
+     */
+    int indexOfStation(const QString &key) const;
+    /**
+     * @internal
+     * @brief Index of the station being requested by a request
+     * @param request request identifier.
+     * @return index of the station, or -1.
+     */
+    int indexOfRequest(const QString &request) const;
+    /**
+     * @internal
+     * @brief Request the rides of stations
+     *
+     * Stations are grouped by backend, but each station is still
+     * sent in its own request, since backends do not provide a
+     * request for the rides of several stations. Stations whose
+     * rides are still being requested are not requested again.
+     *
+     * @param backendIdentifier identifier of the backend whose stations
+     * should be requested, or an empty string for all the backends.
+     */
+    void requestStations(const QString &backendIdentifier = QString());
+    /**
+     * @internal
+     * @brief Update the refresh timer
+     */
+    void updateRefreshTimer();
+    /**
+     * @internal
+     * @brief Display the rows of all the stations
+     */
+    void updateRows();
+    /**
+     * @internal
+     * @brief Stations, in the order they were added
+     */
+    QList<BoardStation> stations;
+    /**
+     * @internal
+     * @brief Running flatten jobs, with their request
+     */
+    QHash<QFutureWatcher<ModelRowList> *, QString> jobs;
+    /**
+     * @internal
+     * @brief Flatten jobs of stale cached rides, whose request is still running
+     */
+    QSet<QFutureWatcher<ModelRowList> *> revalidatingJobs;
+    /**
+     * @internal
+     * @brief Refresh timer, shared by all the stations
+     */
+    QTimer *refreshTimer;
+public Q_SLOTS:
+    /**
+     * @internal
+     * @brief Slot rides from station registered
+     * @param request request identifier.
+     * @param rides rides.
+     */
+    void slotRidesFromStationRegistered(const QString &request, const QList<CompanyNodeData> &rides);
+    /**
+     * @internal
+     * @brief Slot departures flattened
+     */
+    void slotDeparturesFlattened();
+    /**
+     * @internal
+     * @brief Slot refresh
+     */
+    void slotRefresh();
+protected:
+    void connectBackend(AbstractBackendWrapper *backend);
+    void disconnectBackend(AbstractBackendWrapper *backend);
+private:
+    Q_DECLARE_PUBLIC(DeparturesBoardModel)
+};
+
+DeparturesBoardModelPrivate::DeparturesBoardModelPrivate(DeparturesBoardModel *q)
+    : AbstractMultiBackendModelPrivate(q), refreshTimer(new QTimer(this))
+{
+    refreshTimer->setInterval(DEFAULT_REFRESH_INTERVAL);
+    connect(refreshTimer, &QTimer::timeout, this, &DeparturesBoardModelPrivate::slotRefresh);
+}
+
+QString DeparturesBoardModelPrivate::stationKey(const QString &backendIdentifier,
+                                                const Station &station)
+{
+    return backendIdentifier + QLatin1Char('\n') + station.identifier();
+}
+
+int DeparturesBoardModelPrivate::indexOfStation(const QString &key) const
+{
+    for (int i = 0; i < stations.count(); ++i) {
+        if (stationKey(stations.at(i).backendIdentifier, stations.at(i).station) == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int DeparturesBoardModelPrivate::indexOfRequest(const QString &request) const
+{
+    for (int i = 0; i < stations.count(); ++i) {
+        if (stations.at(i).request == request) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void DeparturesBoardModelPrivate::requestStations(const QString &backendIdentifier)
+{
+    if (!backendManager) {
+        return;
+    }
+
+    // Group the stations by backend, so that each backend
+    // receives its requests at once
+    QMap<QString, QList<int> > groups;
+    for (int i = 0; i < stations.count(); ++i) {
+        const BoardStation &station = stations.at(i);
+        if (!backendIdentifier.isEmpty() && station.backendIdentifier != backendIdentifier) {
+            continue;
+        }
+        if (requestRunning(station.request)) {
+            continue;
+        }
+        groups[station.backendIdentifier].append(i);
+    }
+
+    QMap<QString, QList<int> >::const_iterator i;
+    for (i = groups.constBegin(); i != groups.constEnd(); ++i) {
+        if (!backendManager->contains(i.key())) {
+            continue;
+        }
+
+        AbstractBackendWrapper *backend = backendManager->backend(i.key());
+        if (backend->status() != AbstractBackendWrapper::Launched
+            && !backend->isLaunchedOnDemand()) {
+            continue;
+        }
+
+        debug("departures-board-model") << "Requesting" << i.value().count() << "stations from"
+                                         << i.key();
+        foreach (int index, i.value()) {
+            BoardStation &station = stations[index];
+            station.request = backend->requestRealTimeRidesFromStation(station.station);
+            addRequest(station.request);
+        }
+    }
+}
+
+void DeparturesBoardModelPrivate::updateRefreshTimer()
+{
+    if (stations.isEmpty() || refreshTimer->interval() <= 0) {
+        refreshTimer->stop();
+    } else if (!refreshTimer->isActive()) {
+        refreshTimer->start();
+    }
+}
+
+void DeparturesBoardModelPrivate::updateRows()
+{
+    ModelRowList rows;
+    foreach (const BoardStation &station, stations) {
+        rows.append(station.rows);
+    }
+    setRows(rows);
+}
+
+void DeparturesBoardModelPrivate::slotRidesFromStationRegistered(const QString &request,
+                                                                 const QList<CompanyNodeData> &rides)
+{
+    if (!requestRunning(request)) {
+        return;
+    }
+
+    int index = indexOfRequest(request);
+    if (index == -1) {
+        removeRequest(request);
+        return;
+    }
+
+    // Stale cached rides are displayed until the backend answers
+    AbstractBackendWrapper *backend = qobject_cast<AbstractBackendWrapper *>(sender());
+    bool revalidating = backend && backend->isRevalidating(request);
+    if (!revalidating) {
+        debug("departures-board-model") << "Request" << request << "finished";
+    }
+
+    // Sorting and flattening is done in a worker thread
+    const BoardStation &station = stations.at(index);
+    QFutureWatcher<ModelRowList> *watcher = new QFutureWatcher<ModelRowList>(this);
+    connect(watcher, &QFutureWatcher<ModelRowList>::finished,
+            this, &DeparturesBoardModelPrivate::slotDeparturesFlattened);
+    jobs.insert(watcher, request);
+    if (revalidating) {
+        revalidatingJobs.insert(watcher);
+    }
+    watcher->setFuture(QtConcurrent::run(flattenDepartures, rides,
+                                         stationKey(station.backendIdentifier, station.station),
+                                         station.station.name()));
+}
+
+void DeparturesBoardModelPrivate::slotDeparturesFlattened()
+{
+    QFutureWatcher<ModelRowList> *watcher = static_cast<QFutureWatcher<ModelRowList> *>(sender());
+    if (!watcher || !jobs.contains(watcher)) {
+        return;
+    }
+
+    QString request = jobs.take(watcher);
+    bool revalidating = revalidatingJobs.remove(watcher);
+    ModelRowList rows = watcher->result();
+    watcher->deleteLater();
+
+    if (!requestRunning(request)) {
+        return;
+    }
+    if (!revalidating) {
+        removeRequest(request);
+    }
+
+    // The station might have been removed in the meantime
+    int index = indexOfRequest(request);
+    if (index == -1) {
+        return;
+    }
+
+    stations[index].rows = rows;
+    updateRows();
+}
+
+void DeparturesBoardModelPrivate::slotRefresh()
+{
+    requestStations();
+}
+
+void DeparturesBoardModelPrivate::connectBackend(AbstractBackendWrapper *backend)
+{
+    connect(backend, &AbstractBackendWrapper::realTimeRidesFromStationRegistered,
+            this, &DeparturesBoardModelPrivate::slotRidesFromStationRegistered);
+    AbstractMultiBackendModelPrivate::connectBackend(backend);
+
+    // Stations of a backend that was just launched are requested
+    // without waiting for the next refresh
+    if (backend->status() == AbstractBackendWrapper::Launched) {
+        requestStations(backend->identifier());
+    }
+}
+
+void DeparturesBoardModelPrivate::disconnectBackend(AbstractBackendWrapper *backend)
+{
+    disconnect(backend, &AbstractBackendWrapper::realTimeRidesFromStationRegistered,
+               this, &DeparturesBoardModelPrivate::slotRidesFromStationRegistered);
+    AbstractMultiBackendModelPrivate::disconnectBackend(backend);
+}
+
+////// End of private class //////
+
+DeparturesBoardModel::DeparturesBoardModel(QObject *parent)
+    : AbstractMultiBackendModel(*(new DeparturesBoardModelPrivate(this)), parent)
+{
+}
+
+QHash<int, QByteArray> DeparturesBoardModel::roleNames() const
+{
+    QHash <int, QByteArray> roles;
+    roles.insert(StationRole, "station");
+    roles.insert(LineRole, "line");
+    roles.insert(NameRole, "name");
+    roles.insert(DeparturesRole, "departures");
+    return roles;
+}
+
+int DeparturesBoardModel::stationCount() const
+{
+    Q_D(const DeparturesBoardModel);
+    return d->stations.count();
+}
+
+QVariantList DeparturesBoardModel::stations() const
+{
+    Q_D(const DeparturesBoardModel);
+    QVariantList stations;
+    foreach (const BoardStation &boardStation, d->stations) {
+        QVariantMap station;
+        station.insert(BACKEND_IDENTIFIER_KEY, boardStation.backendIdentifier);
+        station.insert(IDENTIFIER_KEY, boardStation.station.identifier());
+        station.insert(NAME_KEY, boardStation.station.name());
+        station.insert(INTERNAL_KEY, boardStation.station.internal());
+        station.insert(PROPERTIES_KEY, boardStation.station.properties());
+        stations.append(station);
+    }
+    return stations;
+}
+
+void DeparturesBoardModel::setStations(const QVariantList &stations)
+{
+    clearStations();
+    foreach (const QVariant &value, stations) {
+        QVariantMap station = value.toMap();
+        addStation(station.value(BACKEND_IDENTIFIER_KEY).toString(),
+                   Station(station.value(IDENTIFIER_KEY).toString(),
+                           station.value(INTERNAL_KEY).toMap(),
+                           station.value(NAME_KEY).toString(),
+                           station.value(PROPERTIES_KEY).toMap()));
+    }
+}
+
+int DeparturesBoardModel::refreshInterval() const
+{
+    Q_D(const DeparturesBoardModel);
+    return d->refreshTimer->interval();
+}
+
+void DeparturesBoardModel::setRefreshInterval(int refreshInterval)
+{
+    Q_D(DeparturesBoardModel);
+    if (d->refreshTimer->interval() != refreshInterval) {
+        d->refreshTimer->setInterval(refreshInterval);
+        d->refreshTimer->stop();
+        d->updateRefreshTimer();
+        emit refreshIntervalChanged();
+    }
+}
+
+void DeparturesBoardModel::addStation(const QString &backendIdentifier, const Station &station)
+{
+    Q_D(DeparturesBoardModel);
+    if (backendIdentifier.isEmpty() || station.isNull()) {
+        return;
+    }
+
+    // Overlapping stations share the same requests and rows
+    int index = d->indexOfStation(DeparturesBoardModelPrivate::stationKey(backendIdentifier,
+                                                                          station));
+    if (index != -1) {
+        return;
+    }
+
+    BoardStation boardStation;
+    boardStation.backendIdentifier = backendIdentifier;
+    boardStation.station = station;
+    d->stations.append(boardStation);
+    emit stationCountChanged();
+    emit stationsChanged();
+
+    d->requestStations(backendIdentifier);
+    d->updateRefreshTimer();
+}
+
+void DeparturesBoardModel::addStationFromSearchModel(RealTimeStationSearchModel *searchModel,
+                                                     int index)
+{
+    if (!searchModel) {
+        return;
+    }
+
+    addStation(searchModel->backendIdentifier(index), searchModel->station(index));
+}
+
+void DeparturesBoardModel::removeStation(int index)
+{
+    Q_D(DeparturesBoardModel);
+    if (index < 0 || index >= d->stations.count()) {
+        return;
+    }
+
+    d->removeRequest(d->stations.at(index).request);
+    d->stations.removeAt(index);
+    emit stationCountChanged();
+    emit stationsChanged();
+
+    d->updateRows();
+    d->updateRefreshTimer();
+}
+
+void DeparturesBoardModel::refresh()
+{
+    Q_D(DeparturesBoardModel);
+    d->requestStations();
+}
+
+void DeparturesBoardModel::clearStations()
+{
+    Q_D(DeparturesBoardModel);
+    if (d->stations.isEmpty()) {
+        return;
+    }
+
+    foreach (const BoardStation &station, d->stations) {
+        d->removeRequest(station.request);
+    }
+    d->stations.clear();
+    emit stationCountChanged();
+    emit stationsChanged();
+
+    clear();
+    d->updateRefreshTimer();
+}
+
+}
+
+#include "departuresboardmodel.moc"
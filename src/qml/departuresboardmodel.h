@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef PT2_DEPARTURESBOARDMODEL_H
+#define PT2_DEPARTURESBOARDMODEL_H
+
+/**
+ * @file departuresboardmodel.h
+ * @short Definition of PT2::DeparturesBoardModel
+ */
+
+#include "abstractmultibackendmodel.h"
+
+#include <QtCore/QVariantList>
+
+namespace PT2
+{
+
+class Station;
+class RealTimeStationSearchModel;
+class DeparturesBoardModelPrivate;
+/**
+ * @brief A model for the departures of several stations
+ *
+ * This class provides a model for QML that contains the
+ * rides of a list of stations, as a flat list of rows. The
+ * station of each row is provided by the station role, that
+ * can be used as a section by views.
+ *
+ * Stations are added with addStation() or with
+ * addStationFromSearchModel(), or are all set with the stations
+ * property, that can also be used to save and restore the board.
+ * A station that is added several times is only requested and
+ * displayed once.
+ *
+ * All the stations are refreshed together, using a single
+ * timer. At each refresh, the requests are grouped by backend,
+ * and a station is not requested again while a request for it
+ * is still running. Each station is still requested on its own,
+ * as backends cannot request the rides of several stations at once.
+ */
+class DeparturesBoardModel : public AbstractMultiBackendModel
+{
+    Q_OBJECT
+    /**
+     * @short Station count
+     */
+    Q_PROPERTY(int stationCount READ stationCount NOTIFY stationCountChanged)
+    /**
+     * @short Stations
+     */
+    Q_PROPERTY(QVariantList stations READ stations WRITE setStations NOTIFY stationsChanged)
+    /**
+     * @short Refresh interval
+     */
+    Q_PROPERTY(int refreshInterval READ refreshInterval WRITE setRefreshInterval
+               NOTIFY refreshIntervalChanged)
+public:
+    /**
+     * @short Model roles
+     */
+    enum DeparturesBoardModelRole {
+        /**
+         * @short Station role
+         */
+        StationRole = Qt::UserRole + 1,
+        /**
+         * @short Line role
+         */
+        LineRole,
+        /**
+         * @short Name role
+         */
+        NameRole,
+        /**
+         * @short Departures role
+         */
+        DeparturesRole
+    };
+    /**
+     * @short Default constructor
+     * @param parent parent object.
+     */
+    explicit DeparturesBoardModel(QObject *parent = 0);
+    /**
+     * @short Role names
+     * @return role names.
+     */
+    QHash<int, QByteArray> roleNames() const;
+    /**
+     * @brief Station count
+     * @return number of stations in the board.
+     */
+    int stationCount() const;
+    /**
+     * @brief Stations
+     *
+     * Each station is described by a map containing the
+     * "backendIdentifier" of the backend that provided the station,
+     * and the "identifier", "name", "internal" and "properties"
+     * of the station.
+     *
+     * @return stations in the board, in the order they were added.
+     */
+    QVariantList stations() const;
+    /**
+     * @brief Set the stations
+     *
+     * The stations of the board are replaced by the given stations,
+     * described as in stations(). Invalid stations are skipped.
+     *
+     * @param stations stations.
+     */
+    void setStations(const QVariantList &stations);
+    /**
+     * @brief Refresh interval
+     *
+     * If the interval is 0, the stations are not refreshed
+     * automatically.
+     *
+     * @return refresh interval, in milliseconds.
+     */
+    int refreshInterval() const;
+    /**
+     * @brief Set refresh interval
+     * @param refreshInterval refresh interval, in milliseconds.
+     */
+    void setRefreshInterval(int refreshInterval);
+    /**
+     * @brief Add a station
+     *
+     * Adding a station that is already in the board does nothing.
+     *
+     * @param backendIdentifier identifier of the backend that provided the station.
+     * @param station station to add.
+     */
+    void addStation(const QString &backendIdentifier, const Station &station);
+    /**
+     * @brief Add a station from a search model
+     * @param searchModel search model.
+     * @param index index of the station in the search model.
+     */
+    Q_INVOKABLE void addStationFromSearchModel(PT2::RealTimeStationSearchModel *searchModel,
+                                               int index);
+    /**
+     * @brief Remove a station
+     * @param index index of the station, in the order the stations were added.
+     */
+    Q_INVOKABLE void removeStation(int index);
+public Q_SLOTS:
+    /**
+     * @brief Refresh
+     *
+     * Request the rides of all the stations again.
+     */
+    void refresh();
+    /**
+     * @brief Clear stations
+     */
+    void clearStations();
+Q_SIGNALS:
+    /**
+     * @brief Station count changed
+     */
+    void stationCountChanged();
+    /**
+     * @brief Stations changed
+     */
+    void stationsChanged();
+    /**
+     * @brief Refresh interval changed
+     */
+    void refreshIntervalChanged();
+private:
+    Q_DECLARE_PRIVATE(DeparturesBoardModel)
+};
+
+}
+
+#endif // PT2_DEPARTURESBOARDMODEL_H
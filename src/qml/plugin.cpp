@@ -43,10 +43,12 @@
 #include <QTranslator>
 #include <QLocale>
 
+#include "daemon/daemonbackendmanager.h"
 #include "manager/dbusbackendmanager.h"
 #include "backendmodel.h"
 #include "realtimestationsearchmodel.h"
 #include "realtimeridesfromstationmodel.h"
+#include "departuresboardmodel.h"
 
 // using custom translator so it gets properly removed from qApp when engine is deleted
 /**
@@ -112,10 +114,12 @@ public:
         qmlRegisterUncreatableType<PT2::AbstractBackendManager>(uri, 1, 0, "AbstractBackendManager",
                                                                 "Cannot create");
         qmlRegisterType<PT2::DBusBackendManager>(uri, 1, 0, "DBusBackendManager");
+        qmlRegisterType<PT2::DaemonBackendManager>(uri, 1, 0, "DaemonBackendManager");
         qmlRegisterType<PT2::BackendModel>(uri, 1, 0, "BackendModel");
         qmlRegisterType<PT2::RealTimeStationSearchModel>(uri, 1, 0, "RealTimeStationSearchModel");
         qmlRegisterType<PT2::RealTimeRidesFromStationModel>(uri, 1, 0,
                                                             "RealTimeRidesFromStationModel");
+        qmlRegisterType<PT2::DeparturesBoardModel>(uri, 1, 0, "DeparturesBoardModel");
     }
 };
 
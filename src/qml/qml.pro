@@ -7,7 +7,7 @@ TARGET = $$qtLibraryTarget($$TARGET)
 LIBS += -L../lib -lpt2
 INCLUDEPATH += ../lib/
 
-QT += gui qml dbus
+QT += gui qml dbus concurrent
 CONFIG += plugin
 
 OTHER_FILES += qmldir
@@ -22,14 +22,16 @@ HEADERS += backendmodel.h \
     abstractmultibackendmodel.h \
     abstractmultibackendmodel_p.h \
     realtimestationsearchmodel.h \
-    realtimeridesfromstationmodel.h
+    realtimeridesfromstationmodel.h \
+    departuresboardmodel.h
 
 SOURCES += plugin.cpp \
     backendmodel.cpp \
     abstractmodel.cpp \
     abstractmultibackendmodel.cpp \
     realtimestationsearchmodel.cpp \
-    realtimeridesfromstationmodel.cpp
+    realtimeridesfromstationmodel.cpp \
+    departuresboardmodel.cpp
 
 INSTALLS += target import
 
@@ -31,6 +31,18 @@
 
 #include "realtimeridesfromstationmodel.h"
 #include "abstractmodel_p.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/QMetaMethod>
+#include <QtCore/QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtGui/QGuiApplication>
+
 #include "realtimestationsearchmodel.h"
 #include "debug.h"
 #include "base/station.h"
@@ -41,13 +53,296 @@
 namespace PT2
 {
 
+/**
+ * @internal
+ * @brief Ride property containing the next departures
+ */
+static const char *DEPARTURES_KEY = "departures";
+/**
+ * @internal
+ * @brief Ride property containing the next departure times, in seconds since epoch
+ */
+static const char *DEPARTURE_TIMES_KEY = "departureTimes";
+/**
+ * @internal
+ * @brief Minimum interval between two refreshes, in milliseconds
+ */
+static const int MINIMUM_REFRESH_INTERVAL = 15000;
+/**
+ * @internal
+ * @brief Maximum interval between two refreshes, in milliseconds
+ */
+static const int MAXIMUM_REFRESH_INTERVAL = 120000;
+/**
+ * @internal
+ * @brief Interval between two refreshes if no departure time is known, in milliseconds
+ */
+static const int DEFAULT_REFRESH_INTERVAL = 60000;
+/**
+ * @internal
+ * @brief Minimum ratio between the refresh interval and the backend latency
+ */
+static const int LATENCY_FACTOR = 5;
+/**
+ * @internal
+ * @brief Factor applied to the refresh interval when the application is not active
+ */
+static const int BACKGROUND_FACTOR = 4;
+/**
+ * @internal
+ * @brief Interval between two updates of the minutes until departure, in milliseconds
+ */
+static const int COUNTDOWN_INTERVAL = 10000;
+
+/**
+ * @internal
+ * @short Row for PT2::RealTimeRidesFromStationModel
+ */
+struct RideRow: public ModelRow
+{
+    QVariant data(int role) const;
+    QString key() const;
+    bool equals(const ModelRow *other) const;
+    /**
+     * @internal
+     * @short Line identifier
+     */
+    QString lineIdentifier;
+    /**
+     * @internal
+     * @short Ride identifier
+     */
+    QString rideIdentifier;
+    /**
+     * @internal
+     * @short Line name
+     */
+    QString line;
+    /**
+     * @internal
+     * @short Ride name
+     */
+    QString name;
+    /**
+     * @internal
+     * @short Next departures
+     */
+    QStringList departures;
+    /**
+     * @internal
+     * @short Next departure times, in seconds since epoch
+     */
+    QList<qint64> departureTimes;
+};
+
+QVariant RideRow::data(int role) const
+{
+    switch (role) {
+    case RealTimeRidesFromStationModel::LineRole:
+        return line;
+        break;
+    case RealTimeRidesFromStationModel::NameRole:
+        return name;
+        break;
+    case RealTimeRidesFromStationModel::DeparturesRole:
+        return departures;
+        break;
+    case RealTimeRidesFromStationModel::MinutesUntilDepartureRole:
+    {
+        // Extrapolated from the current time
+        qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+        QVariantList minutes;
+        foreach (qint64 departureTime, departureTimes) {
+            if (departureTime >= now) {
+                minutes.append(int((departureTime - now) / 60));
+            }
+        }
+        return minutes;
+        break;
+    }
+    default:
+        return QVariant();
+        break;
+    }
+}
+
+QString RideRow::key() const
+{
+    return lineIdentifier + QLatin1Char('\n') + rideIdentifier;
+}
+
+bool RideRow::equals(const ModelRow *other) const
+{
+    const RideRow *otherRow = static_cast<const RideRow *>(other);
+    return line == otherRow->line && name == otherRow->name
+            && departures == otherRow->departures && departureTimes == otherRow->departureTimes;
+}
+
+/**
+ * @internal
+ * @short Rows created from rides
+ *
+ * Result of flattenRides().
+ */
+struct FlattenedRides
+{
+    /**
+     * @internal
+     * @short Default constructor
+     */
+    explicit FlattenedRides(): valid(true) {}
+    /**
+     * @internal
+     * @short Rows
+     */
+    ModelRowList rows;
+    /**
+     * @internal
+     * @short If the rides were valid
+     */
+    bool valid;
+};
+
+/**
+ * @internal
+ * @short Sort and flatten rides into rows
+ *
+ * This method is run in a worker thread.
+ *
+ * @param rides rides to flatten.
+ * @return rows.
+ */
+static FlattenedRides flattenRides(QList<CompanyNodeData> rides)
+{
+    FlattenedRides flattenedRides;
+    debug("realtime-rides-from-station-model") << "Received" << rides.count() << "root data";
+    for (int i = 0; i < rides.count(); ++i) {
+        CompanyNodeData &companyNodeData = rides[i];
+        companyNodeData.sort();
+        debug("realtime-rides-from-station-model") << "Received"
+                                                   << companyNodeData.lineNodeDataList().count()
+                                                   << "line data";
+
+        foreach (const LineNodeData &lineNodeData, companyNodeData.lineNodeDataList()) {
+            QString line = lineNodeData.line().name();
+            QString lineIdentifier = lineNodeData.line().identifier();
+
+            foreach (const RideNodeData &rideNodeData, lineNodeData.rideNodeDataList()) {
+                if (rideNodeData.stationList().count() != 1) {
+                    warning("realtime-rides-from-station-model") << "The number of stations "\
+                                                                    "should be 1.";
+                    flattenedRides.rows.clear();
+                    flattenedRides.valid = false;
+                    return flattenedRides;
+                }
+
+                RideRow *row = new RideRow;
+                row->lineIdentifier = lineIdentifier;
+                row->rideIdentifier = rideNodeData.ride().identifier();
+                row->line = line;
+                row->name = rideNodeData.ride().name();
+
+                QVariantMap properties = rideNodeData.ride().properties();
+                row->departures = properties.value(DEPARTURES_KEY).toStringList();
+                foreach (const QVariant &departureTime,
+                         properties.value(DEPARTURE_TIMES_KEY).toList()) {
+                    if (departureTime.toLongLong() >= 0) {
+                        row->departureTimes.append(departureTime.toLongLong());
+                    }
+                }
+                flattenedRides.rows.append(ModelRowPointer(row));
+            }
+        }
+    }
+    return flattenedRides;
+}
+
 class RealTimeRidesFromStationModelPrivate: public AbstractModelPrivate
 {
     Q_OBJECT
 public:
     explicit RealTimeRidesFromStationModelPrivate(RealTimeRidesFromStationModel *q);
     RealTimeStationSearchModel * stationSearchModel;
+    QPointer<AbstractBackendWrapper> currentBackend;
     Station currentStation;
+    /**
+     * @internal
+     * @brief Latest request that was sent
+     *
+     * Replies to older requests, and results of the worker thread
+     * for these replies, are superseded, and are discarded, even if
+     * they arrive after the reply to the latest request.
+     */
+    QString latestRequest;
+    /**
+     * @internal
+     * @brief Running flatten jobs, with their request
+     */
+    QHash<QFutureWatcher<FlattenedRides> *, QString> jobs;
+    /**
+     * @internal
+     * @brief Flatten jobs of stale cached rides, whose request is still running
+     */
+    QSet<QFutureWatcher<FlattenedRides> *> revalidatingJobs;
+    /**
+     * @internal
+     * @brief Start measuring the latency of a request
+     */
+    void startRequest();
+    /**
+     * @internal
+     * @brief Schedule the next refresh
+     * @param interval interval before the next refresh, in milliseconds.
+     */
+    void scheduleRefresh(int interval);
+    /**
+     * @internal
+     * @brief Interval before the next refresh
+     *
+     * Departures are refreshed twice until the next departure,
+     * but not faster than the backend can answer.
+     *
+     * @return interval before the next refresh, in milliseconds.
+     */
+    int refreshInterval() const;
+    /**
+     * @internal
+     * @brief If the application is active
+     * @return if the application is active.
+     */
+    static bool isApplicationActive();
+    /**
+     * @internal
+     * @brief If auto refresh is enabled
+     */
+    bool autoRefresh;
+    /**
+     * @internal
+     * @brief If auto refresh is paused, because no view is attached
+     */
+    bool paused;
+    /**
+     * @internal
+     * @brief Refresh timer
+     */
+    QTimer *refreshTimer;
+    /**
+     * @internal
+     * @brief Countdown timer
+     *
+     * Used to update the minutes until departure.
+     */
+    QTimer *countdownTimer;
+    /**
+     * @internal
+     * @brief Timer measuring the latency of the current request
+     */
+    QElapsedTimer requestTimer;
+    /**
+     * @internal
+     * @brief Latency of the last request, in milliseconds
+     */
+    qint64 latency;
 public Q_SLOTS:
     void slotRidesFromStationRequested(AbstractBackendWrapper *backend, const QString &request,
                                        const Station &station);
@@ -58,23 +353,118 @@ public Q_SLOTS:
      * @param rides rides.
      */
     void slotRidesFromStationRegistered(const QString &request, const QList<CompanyNodeData> &rides);
+    /**
+     * @internal
+     * @brief Slot rides flattened
+     */
+    void slotRidesFlattened();
+    /**
+     * @internal
+     * @brief Slot refresh
+     */
+    void slotRefresh();
+    /**
+     * @internal
+     * @brief Slot countdown
+     */
+    void slotCountdown();
+    /**
+     * @internal
+     * @brief Slot application state changed
+     * @param state application state.
+     */
+    void slotApplicationStateChanged(Qt::ApplicationState state);
 protected:
     void connectBackend(AbstractBackendWrapper *backend);
     void disconnectBackend(AbstractBackendWrapper *backend);
+private:
+    Q_DECLARE_PUBLIC(RealTimeRidesFromStationModel)
 };
 
 RealTimeRidesFromStationModelPrivate::RealTimeRidesFromStationModelPrivate(RealTimeRidesFromStationModel *q)
-    : AbstractModelPrivate(q), stationSearchModel(0)
+    : AbstractModelPrivate(q), stationSearchModel(0), autoRefresh(false)
+    , paused(false), refreshTimer(new QTimer(this)), countdownTimer(new QTimer(this)), latency(0)
+{
+    refreshTimer->setSingleShot(true);
+    connect(refreshTimer, &QTimer::timeout,
+            this, &RealTimeRidesFromStationModelPrivate::slotRefresh);
+    countdownTimer->setInterval(COUNTDOWN_INTERVAL);
+    connect(countdownTimer, &QTimer::timeout,
+            this, &RealTimeRidesFromStationModelPrivate::slotCountdown);
+
+    QGuiApplication *application = qobject_cast<QGuiApplication *>(QCoreApplication::instance());
+    if (application) {
+        connect(application, &QGuiApplication::applicationStateChanged,
+                this, &RealTimeRidesFromStationModelPrivate::slotApplicationStateChanged);
+    }
+}
+
+void RealTimeRidesFromStationModelPrivate::startRequest()
+{
+    requestTimer.start();
+    // In case the request fails, a refresh is still scheduled
+    if (autoRefresh) {
+        scheduleRefresh(MAXIMUM_REFRESH_INTERVAL);
+    }
+}
+
+void RealTimeRidesFromStationModelPrivate::scheduleRefresh(int interval)
+{
+    if (!isApplicationActive()) {
+        interval *= BACKGROUND_FACTOR;
+    }
+    debug("realtime-rides-from-station-model") << "Next refresh in" << interval << "ms";
+    refreshTimer->start(interval);
+}
+
+int RealTimeRidesFromStationModelPrivate::refreshInterval() const
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+    qint64 nextDeparture = -1;
+    foreach (const ModelRowPointer &row, rows()) {
+        foreach (qint64 departureTime, static_cast<const RideRow *>(row.data())->departureTimes) {
+            if (departureTime >= now && (nextDeparture == -1 || departureTime < nextDeparture)) {
+                nextDeparture = departureTime;
+            }
+        }
+    }
+
+    qint64 interval = DEFAULT_REFRESH_INTERVAL;
+    if (nextDeparture != -1) {
+        interval = (nextDeparture - now) * 1000 / 2;
+    }
+    interval = qMax(interval, latency * LATENCY_FACTOR);
+    return qBound<qint64>(MINIMUM_REFRESH_INTERVAL, interval, MAXIMUM_REFRESH_INTERVAL);
+}
+
+bool RealTimeRidesFromStationModelPrivate::isApplicationActive()
 {
+    QGuiApplication *application = qobject_cast<QGuiApplication *>(QCoreApplication::instance());
+    if (!application) {
+        return true;
+    }
+    return application->applicationState() == Qt::ApplicationActive;
 }
 
 void RealTimeRidesFromStationModelPrivate::slotRidesFromStationRequested(AbstractBackendWrapper *backend,
                                                                          const QString &request,
                                                                          const Station &station)
 {
+    Q_Q(RealTimeRidesFromStationModel);
+    // Rides of another station are not diffed against the current ones
+    if (backend != currentBackend || station.identifier() != currentStation.identifier()) {
+        q->clear();
+    }
+
+    if (currentBackend) {
+        disconnectBackend(currentBackend);
+    }
+    currentBackend = backend;
     connectBackend(backend);
     addRequest(request);
     currentStation = station;
+    latestRequest = request;
+    startRequest();
 }
 
 void RealTimeRidesFromStationModelPrivate::slotRidesFromStationRegistered(const QString &request,
@@ -89,40 +479,115 @@ void RealTimeRidesFromStationModelPrivate::slotRidesFromStationRegistered(const
         return;
     }
 
-    ModelDataList dataList;
+    // Stale cached rides are displayed until the backend answers
+    bool revalidating = backend->isRevalidating(request);
+    if (request != latestRequest) {
+        debug("realtime-rides-from-station-model") << "Discarding superseded request" << request;
+        if (!revalidating) {
+            removeRequest(request);
+        }
+        return;
+    }
 
-    debug("realtime-rides-from-station-model") << "Request" << request << "finished";
-    debug("realtime-rides-from-station-model") << "Received" << rides.count() << "root data";
-    foreach (CompanyNodeData companyNodeData, rides) {
-        companyNodeData.sort();
-        debug("realtime-rides-from-station-model") << "Received"
-                                                   << companyNodeData.lineNodeDataList().count()
-                                                   << "line data";
+    if (!revalidating) {
+        debug("realtime-rides-from-station-model") << "Request" << request << "finished";
+        if (requestTimer.isValid()) {
+            latency = requestTimer.elapsed();
+        }
+    }
 
-        foreach (const LineNodeData &lineNodeData, companyNodeData.lineNodeDataList()) {
-            QString line = lineNodeData.line().name();
+    // Sorting and flattening is done in a worker thread
+    QFutureWatcher<FlattenedRides> *watcher = new QFutureWatcher<FlattenedRides>(this);
+    connect(watcher, &QFutureWatcher<FlattenedRides>::finished,
+            this, &RealTimeRidesFromStationModelPrivate::slotRidesFlattened);
+    jobs.insert(watcher, request);
+    if (revalidating) {
+        revalidatingJobs.insert(watcher);
+    }
+    watcher->setFuture(QtConcurrent::run(flattenRides, rides));
+}
 
-            foreach (const RideNodeData &rideNodeData, lineNodeData.rideNodeDataList()) {
-                if (rideNodeData.stationList().count() != 1) {
-                    warning("realtime-rides-from-station-model") << "The number of stations "\
-                                                                    "should be 1.";
-                    removeRequest(request);
-                    return;
-                }
+void RealTimeRidesFromStationModelPrivate::slotRidesFlattened()
+{
+    QFutureWatcher<FlattenedRides> *watcher
+            = static_cast<QFutureWatcher<FlattenedRides> *>(sender());
+    if (!watcher || !jobs.contains(watcher)) {
+        return;
+    }
 
-                QString ride = rideNodeData.ride().name();
-                ModelData data;
-                data.insert(RealTimeRidesFromStationModel::LineRole, line);
-                data.insert(RealTimeRidesFromStationModel::NameRole, ride);
-                dataList.append(data);
-            }
-        }
+    QString request = jobs.take(watcher);
+    bool revalidating = revalidatingJobs.remove(watcher);
+    FlattenedRides flattenedRides = watcher->result();
+    watcher->deleteLater();
+
+    if (!requestRunning(request)) {
+        return;
+    }
+    if (!revalidating) {
+        removeRequest(request);
+    }
+
+    if (request != latestRequest) {
+        debug("realtime-rides-from-station-model") << "Discarding results of request"
+                                                   << request;
+        return;
+    }
+
+    if (!flattenedRides.valid) {
+        return;
     }
 
-    debug("realtime-rides-from-station-model") << "Displaying" << dataList.count() << "entries";
+    debug("realtime-rides-from-station-model") << "Displaying" << flattenedRides.rows.count()
+                                               << "entries";
+    setRows(flattenedRides.rows);
 
-    addData(dataList);
-    removeRequest(request);
+    countdownTimer->start();
+    if (autoRefresh) {
+        scheduleRefresh(refreshInterval());
+    }
+}
+
+void RealTimeRidesFromStationModelPrivate::slotRefresh()
+{
+    Q_Q(RealTimeRidesFromStationModel);
+    if (!autoRefresh) {
+        return;
+    }
+
+    if (!q->isViewAttached()) {
+        debug("realtime-rides-from-station-model") << "No view attached, pausing refresh";
+        paused = true;
+        countdownTimer->stop();
+        return;
+    }
+
+    q->refresh();
+}
+
+void RealTimeRidesFromStationModelPrivate::slotCountdown()
+{
+    Q_Q(RealTimeRidesFromStationModel);
+    if (rows().isEmpty()) {
+        countdownTimer->stop();
+        return;
+    }
+
+    emit q->dataChanged(q->index(0), q->index(rows().count() - 1),
+                        QVector<int>() << RealTimeRidesFromStationModel::MinutesUntilDepartureRole);
+}
+
+void RealTimeRidesFromStationModelPrivate::slotApplicationStateChanged(Qt::ApplicationState state)
+{
+    Q_Q(RealTimeRidesFromStationModel);
+    if (!autoRefresh || !refreshTimer->isActive()) {
+        return;
+    }
+
+    // Refresh when the application becomes active again, since
+    // the refresh was slowed down
+    if (state == Qt::ApplicationActive) {
+        q->refresh();
+    }
 }
 
 void RealTimeRidesFromStationModelPrivate::connectBackend(AbstractBackendWrapper *backend)
@@ -151,9 +616,65 @@ QHash<int, QByteArray> RealTimeRidesFromStationModel::roleNames() const
     QHash <int, QByteArray> roles;
     roles.insert(LineRole, "line");
     roles.insert(NameRole, "name");
+    roles.insert(DeparturesRole, "departures");
+    roles.insert(MinutesUntilDepartureRole, "minutesUntilDeparture");
     return roles;
 }
 
+void RealTimeRidesFromStationModel::refresh()
+{
+    Q_D(RealTimeRidesFromStationModel);
+    if (!d->currentBackend || d->currentStation.isNull()) {
+        return;
+    }
+
+    QString request = d->currentBackend->requestRealTimeRidesFromStation(d->currentStation);
+    d->addRequest(request);
+    d->latestRequest = request;
+    d->startRequest();
+}
+
+bool RealTimeRidesFromStationModel::autoRefresh() const
+{
+    Q_D(const RealTimeRidesFromStationModel);
+    return d->autoRefresh;
+}
+
+void RealTimeRidesFromStationModel::setAutoRefresh(bool autoRefresh)
+{
+    Q_D(RealTimeRidesFromStationModel);
+    if (d->autoRefresh != autoRefresh) {
+        d->autoRefresh = autoRefresh;
+        d->paused = false;
+        if (d->autoRefresh) {
+            d->scheduleRefresh(d->refreshInterval());
+        } else {
+            d->refreshTimer->stop();
+        }
+        emit autoRefreshChanged();
+    }
+}
+
+void RealTimeRidesFromStationModel::connectNotify(const QMetaMethod &signal)
+{
+    Q_D(RealTimeRidesFromStationModel);
+    AbstractModel::connectNotify(signal);
+    if (signal != QMetaMethod::fromSignal(&QAbstractItemModel::rowsInserted)) {
+        return;
+    }
+
+    // Resume refreshing, since a view was attached
+    if (d->autoRefresh && d->paused) {
+        d->paused = false;
+        refresh();
+    }
+}
+
+bool RealTimeRidesFromStationModel::isViewAttached() const
+{
+    return isSignalConnected(QMetaMethod::fromSignal(&QAbstractItemModel::rowsInserted));
+}
+
 RealTimeStationSearchModel * RealTimeRidesFromStationModel::stationSearchModel() const
 {
     Q_D(const RealTimeRidesFromStationModel);
@@ -44,6 +44,10 @@ class RealTimeRidesFromStationModel : public AbstractModel
     Q_OBJECT
     Q_PROPERTY(PT2::RealTimeStationSearchModel * stationSearchModel READ stationSearchModel
                WRITE setStationSearchModel NOTIFY stationSearchModelChanged)
+    /**
+     * @short Auto refresh
+     */
+    Q_PROPERTY(bool autoRefresh READ autoRefresh WRITE setAutoRefresh NOTIFY autoRefreshChanged)
 public:
     /**
      * @short Model roles
@@ -57,6 +61,20 @@ public:
          * @short Name role
          */
         NameRole,
+        /**
+         * @short Departures role
+         *
+         * List of the next departures, as provided by the backend.
+         */
+        DeparturesRole,
+        /**
+         * @short Minutes until departure role
+         *
+         * List of the number of minutes until each of the next
+         * departures whose time is known. This list is updated
+         * locally between two refreshes.
+         */
+        MinutesUntilDepartureRole
     };
     explicit RealTimeRidesFromStationModel(QObject *parent = 0);
     /**
@@ -66,9 +84,53 @@ public:
     QHash<int, QByteArray> roleNames() const;
     RealTimeStationSearchModel * stationSearchModel() const;
     void setStationSearchModel(RealTimeStationSearchModel *stationSearchModel);
+    /**
+     * @brief Auto refresh
+     *
+     * If auto refresh is enabled, the rides are refreshed
+     * periodically. The interval between two refreshes depends
+     * on the time until the next departure and on the time taken
+     * by the backend to answer. Refreshes are less frequent when
+     * the application is not active, and are paused when no view
+     * displays this model.
+     *
+     * @return if auto refresh is enabled.
+     */
+    bool autoRefresh() const;
+    /**
+     * @brief Set auto refresh
+     * @param autoRefresh if auto refresh is enabled.
+     */
+    void setAutoRefresh(bool autoRefresh);
+public Q_SLOTS:
+    /**
+     * @brief Refresh
+     *
+     * Request the rides of the current station again. Rides
+     * that are still present are updated in place.
+     */
+    void refresh();
 Q_SIGNALS:
     void stationSearchModelChanged();
+    /**
+     * @brief Auto refresh changed
+     */
+    void autoRefreshChanged();
+protected:
+    /**
+     * @short Reimplementation of connectNotify
+     *
+     * Used to resume auto refresh when a view is attached.
+     *
+     * @param signal connected signal.
+     */
+    void connectNotify(const QMetaMethod &signal);
 private:
+    /**
+     * @short If a view is attached to this model
+     * @return if a view is attached to this model.
+     */
+    bool isViewAttached() const;
     Q_DECLARE_PRIVATE(RealTimeRidesFromStationModel)
 };
 
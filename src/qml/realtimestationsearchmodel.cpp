@@ -37,17 +37,173 @@
 #include "realtimestationsearchmodel.h"
 #include "abstractmultibackendmodel_p.h"
 
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+#include <QtCore/QtAlgorithms>
+
 #include "capabilitiesconstants.h"
+#include "normalization.h"
 #include "base/station.h"
 #include "manager/abstractbackendmanager.h"
 #include "manager/abstractbackendwrapper.h"
+#include "manager/stationhistory.h"
 #include "debug.h"
 
 namespace PT2
 {
 
-static int STATION_INDEX = 10;
-static int BACKEND_IDENTIFIER_INDEX = 11;
+/**
+ * @internal
+ * @brief Default debounce interval, in milliseconds
+ */
+static const int DEFAULT_DEBOUNCE_INTERVAL = 300;
+/**
+ * @internal
+ * @brief Time during which suggestions should not change before prefetching, in milliseconds
+ */
+static const int PREFETCH_DELAY = 500;
+/**
+ * @internal
+ * @brief Maximum number of stations suggested from the history
+ */
+static const int HISTORY_LIMIT = 5;
+
+/**
+ * @internal
+ * @short Row for PT2::RealTimeStationSearchModel
+ */
+struct StationRow: public ModelRow
+{
+    QVariant data(int role) const;
+    QString key() const;
+    bool equals(const ModelRow *other) const;
+    /**
+     * @internal
+     * @short Station
+     */
+    Station station;
+    /**
+     * @internal
+     * @short Station name, normalized for searching
+     */
+    QString normalizedName;
+    /**
+     * @internal
+     * @short Identifier of the backend that provided the station
+     */
+    QString backendIdentifier;
+    /**
+     * @internal
+     * @short If the backend supports rides from station
+     */
+    bool supportRidesFromStation;
+};
+
+QVariant StationRow::data(int role) const
+{
+    switch (role) {
+    case RealTimeStationSearchModel::NameRole:
+        return station.name();
+        break;
+    // TODO ProviderNameRole
+    case RealTimeStationSearchModel::SupportRidesFromStationRole:
+        return supportRidesFromStation;
+        break;
+    default:
+        return QVariant();
+        break;
+    }
+}
+
+QString StationRow::key() const
+{
+    return backendIdentifier + QLatin1Char('\n') + station.identifier();
+}
+
+bool StationRow::equals(const ModelRow *other) const
+{
+    const StationRow *otherRow = static_cast<const StationRow *>(other);
+    return station == otherRow->station
+            && supportRidesFromStation == otherRow->supportRidesFromStation;
+}
+
+/**
+ * @internal
+ * @brief Relevance of a station for a query
+ *
+ * The lower the score, the more relevant the station is. Stations
+ * whose name is the query come first, then stations whose name
+ * start with the query, then stations having a word that start with
+ * the query, and finally stations whose name only contain the query.
+ *
+ * @param normalizedName normalized station name.
+ * @param normalizedQuery normalized query.
+ * @return relevance score.
+ */
+static int relevance(const QString &normalizedName, const QString &normalizedQuery)
+{
+    if (normalizedName == normalizedQuery) {
+        return 0;
+    } else if (normalizedName.startsWith(normalizedQuery)) {
+        return 1;
+    }
+
+    int index = normalizedName.indexOf(normalizedQuery);
+    if (index > 0 && !normalizedName.at(index - 1).isLetterOrNumber()) {
+        return 2;
+    }
+    return 3;
+}
+
+/**
+ * @internal
+ * @short Comparison of station rows
+ *
+ * Rows are sorted by relevance score, then by normalized name. Between
+ * two stations having the same name, the one that supports rides from
+ * station comes first.
+ */
+struct StationRowLessThan
+{
+    /**
+     * @internal
+     * @short Constructor
+     * @param normalizedQuery normalized query.
+     */
+    explicit StationRowLessThan(const QString &normalizedQuery)
+        : normalizedQuery(normalizedQuery)
+    {
+    }
+    /**
+     * @internal
+     * @short Compare two rows
+     * @param first first row.
+     * @param second second row.
+     * @return if the first row is lesser than the second row.
+     */
+    bool operator()(const ModelRowPointer &first, const ModelRowPointer &second) const
+    {
+        const StationRow *firstRow = static_cast<const StationRow *>(first.data());
+        const StationRow *secondRow = static_cast<const StationRow *>(second.data());
+        int firstRelevance = relevance(firstRow->normalizedName, normalizedQuery);
+        int secondRelevance = relevance(secondRow->normalizedName, normalizedQuery);
+        if (firstRelevance != secondRelevance) {
+            return firstRelevance < secondRelevance;
+        }
+        if (firstRow->normalizedName != secondRow->normalizedName) {
+            return firstRow->normalizedName < secondRow->normalizedName;
+        }
+        return firstRow->supportRidesFromStation && !secondRow->supportRidesFromStation;
+    }
+    /**
+     * @internal
+     * @short Normalized query
+     */
+    QString normalizedQuery;
+};
 
 /**
  * @internal
@@ -64,9 +220,123 @@ public:
      */
     explicit RealTimeStationSearchModelPrivate(RealTimeStationSearchModel *q);
     void setShort(bool isShort);
+    /**
+     * @internal
+     * @brief Filter and sort rows
+     *
+     * Only the rows whose normalized name contains the normalized
+     * query are kept, and they are sorted using StationRowLessThan.
+     *
+     * @param rows rows to filter.
+     * @param normalizedQuery normalized query.
+     * @return filtered and sorted rows.
+     */
+    static ModelRowList filterRows(const ModelRowList &rows, const QString &normalizedQuery);
+    /**
+     * @internal
+     * @brief Merge the rows of all backends
+     *
+     * The sorted rows of each backend are merged into a single
+     * sorted list, after the rows from the history. A station is
+     * only displayed once, and stations from different backends
+     * that have the same normalized name are only displayed once,
+     * from the first backend. Stations from the same backend that
+     * share a name, but are different stations, are all displayed.
+     *
+     * @return merged rows.
+     */
+    ModelRowList mergeRows() const;
+    /**
+     * @internal
+     * @brief Find the stations of the history matching a query
+     *
+     * Only the stations of the backends covering the region
+     * of the model are used.
+     *
+     * @param normalizedQuery normalized query.
+     */
+    void updateHistoryRows(const QString &normalizedQuery);
+    /**
+     * @internal
+     * @brief Reset the search state
+     */
+    void resetSearch();
+    /**
+     * @internal
+     * @brief Cancel the running prefetches
+     */
+    void cancelPrefetches();
+    /**
+     * @internal
+     * @brief Debounce timer
+     */
+    QTimer *debounceTimer;
+    /**
+     * @internal
+     * @brief Prefetch timer
+     */
+    QTimer *prefetchTimer;
+    /**
+     * @internal
+     * @brief Number of stations to prefetch
+     */
+    int prefetchCount;
+    /**
+     * @internal
+     * @brief Backends that received prefetches
+     */
+    QSet<QString> prefetchBackends;
+    /**
+     * @internal
+     * @brief Current query
+     */
+    QString query;
+    /**
+     * @internal
+     * @brief Current query, normalized
+     */
+    QString normalizedQuery;
+    /**
+     * @internal
+     * @brief Normalized query of each running request
+     */
+    QHash<QString, QString> requestQueries;
+    /**
+     * @internal
+     * @brief Latest request sent to each backend
+     */
+    QHash<QString, QString> latestRequests;
+    /**
+     * @internal
+     * @brief Normalized query whose results are displayed, for each backend
+     */
+    QHash<QString, QString> displayedQueries;
+    /**
+     * @internal
+     * @brief Sorted rows, for each backend
+     */
+    QMap<QString, ModelRowList> backendRows;
+    /**
+     * @internal
+     * @brief History of the selected stations
+     */
+    StationHistory history;
+    /**
+     * @internal
+     * @brief Rows from the history, the most relevant first
+     */
+    ModelRowList historyRows;
 protected:
     void connectBackend(AbstractBackendWrapper *backend);
     void disconnectBackend(AbstractBackendWrapper *backend);
+    /**
+     * @internal
+     * @brief Reimplementation of regionChanged
+     *
+     * The current query is searched again in the backends
+     * that cover the new region.
+     */
+    void regionChanged();
 public Q_SLOTS:
     /**
      * @internal
@@ -75,14 +345,33 @@ public Q_SLOTS:
      * @param stations stations.
      */
     void slotStationsRegistered(const QString & request, const QList<PT2::Station> &stations);
+    /**
+     * @internal
+     * @brief Slot to send requests to backends
+     */
+    void slotSendRequests();
+    /**
+     * @internal
+     * @brief Slot to prefetch the rides from the first stations
+     */
+    void slotPrefetch();
 private:
     bool m_short;
     Q_DECLARE_PUBLIC(RealTimeStationSearchModel)
 };
 
 RealTimeStationSearchModelPrivate::RealTimeStationSearchModelPrivate(RealTimeStationSearchModel *q):
-    AbstractMultiBackendModelPrivate(q), m_short(false)
+    AbstractMultiBackendModelPrivate(q), debounceTimer(new QTimer(this))
+  , prefetchTimer(new QTimer(this)), prefetchCount(0), m_short(false)
 {
+    debounceTimer->setSingleShot(true);
+    debounceTimer->setInterval(DEFAULT_DEBOUNCE_INTERVAL);
+    connect(debounceTimer, &QTimer::timeout,
+            this, &RealTimeStationSearchModelPrivate::slotSendRequests);
+    prefetchTimer->setSingleShot(true);
+    prefetchTimer->setInterval(PREFETCH_DELAY);
+    connect(prefetchTimer, &QTimer::timeout,
+            this, &RealTimeStationSearchModelPrivate::slotPrefetch);
 }
 
 void RealTimeStationSearchModelPrivate::setShort(bool isShort)
@@ -94,6 +383,165 @@ void RealTimeStationSearchModelPrivate::setShort(bool isShort)
     }
 }
 
+ModelRowList RealTimeStationSearchModelPrivate::filterRows(const ModelRowList &rows,
+                                                           const QString &normalizedQuery)
+{
+    ModelRowList filteredRows;
+    foreach (const ModelRowPointer &row, rows) {
+        if (static_cast<const StationRow *>(row.data())->normalizedName.contains(normalizedQuery)) {
+            filteredRows.append(row);
+        }
+    }
+    qStableSort(filteredRows.begin(), filteredRows.end(), StationRowLessThan(normalizedQuery));
+    return filteredRows;
+}
+
+/**
+ * @internal
+ * @brief If a row should be displayed when merging rows
+ *
+ * A row is rejected if the same station was already displayed, or
+ * if a station with the same normalized name was already displayed
+ * from another backend.
+ *
+ * @param row row.
+ * @param nameBackends backend that first displayed each normalized name.
+ * @param keys keys of the displayed rows.
+ * @return if the row should be displayed.
+ */
+static bool acceptRow(const ModelRowPointer &row, QHash<QString, QString> &nameBackends,
+                      QSet<QString> &keys)
+{
+    const StationRow *stationRow = static_cast<const StationRow *>(row.data());
+    QString key = stationRow->key();
+    if (keys.contains(key)) {
+        return false;
+    }
+
+    QHash<QString, QString>::const_iterator i = nameBackends.constFind(stationRow->normalizedName);
+    if (i != nameBackends.constEnd() && i.value() != stationRow->backendIdentifier) {
+        return false;
+    }
+
+    nameBackends.insert(stationRow->normalizedName, stationRow->backendIdentifier);
+    keys.insert(key);
+    return true;
+}
+
+ModelRowList RealTimeStationSearchModelPrivate::mergeRows() const
+{
+    StationRowLessThan lessThan (normalizedQuery);
+    QList<ModelRowList> runs = backendRows.values();
+    QVector<int> positions (runs.count(), 0);
+    QHash<QString, QString> nameBackends;
+    QSet<QString> keys;
+    ModelRowList mergedRows;
+    foreach (const ModelRowPointer &row, historyRows) {
+        if (acceptRow(row, nameBackends, keys)) {
+            mergedRows.append(row);
+        }
+    }
+
+    // The number of backends is small, so the smallest head
+    // is found with a linear scan of the runs
+    forever {
+        int smallest = -1;
+        for (int i = 0; i < runs.count(); ++i) {
+            if (positions.at(i) >= runs.at(i).count()) {
+                continue;
+            }
+            if (smallest == -1 || lessThan(runs.at(i).at(positions.at(i)),
+                                           runs.at(smallest).at(positions.at(smallest)))) {
+                smallest = i;
+            }
+        }
+
+        if (smallest == -1) {
+            break;
+        }
+
+        const ModelRowPointer &row = runs.at(smallest).at(positions.at(smallest));
+        ++positions[smallest];
+
+        if (acceptRow(row, nameBackends, keys)) {
+            mergedRows.append(row);
+        }
+    }
+
+    return mergedRows;
+}
+
+void RealTimeStationSearchModelPrivate::updateHistoryRows(const QString &normalizedQuery)
+{
+    historyRows.clear();
+    if (!backendManager) {
+        return;
+    }
+
+    QHash<QString, AbstractBackendWrapper *> backends;
+    foreach (AbstractBackendWrapper *backend, availableBackends()) {
+        backends.insert(backend->identifier(), backend);
+    }
+
+    QList<QPair<QString, Station> > stations = history.find(normalizedQuery);
+    for (int i = 0; i < stations.count() && historyRows.count() < HISTORY_LIMIT; ++i) {
+        AbstractBackendWrapper *backend = backends.value(stations.at(i).first);
+        if (!backend) {
+            continue;
+        }
+
+        StationRow *row = new StationRow;
+        row->station = stations.at(i).second;
+        row->normalizedName = normalizeForSearch(row->station.name());
+        row->backendIdentifier = backend->identifier();
+        row->supportRidesFromStation
+                = backend->capabilities().contains(CAPABILITY_REAL_TIME_RIDES_FROM_STATION);
+        historyRows.append(ModelRowPointer(row));
+    }
+}
+
+void RealTimeStationSearchModelPrivate::resetSearch()
+{
+    query.clear();
+    normalizedQuery.clear();
+    requestQueries.clear();
+    latestRequests.clear();
+    displayedQueries.clear();
+    backendRows.clear();
+    historyRows.clear();
+}
+
+void RealTimeStationSearchModelPrivate::cancelPrefetches()
+{
+    prefetchTimer->stop();
+    if (!backendManager) {
+        prefetchBackends.clear();
+        return;
+    }
+
+    foreach (const QString &identifier, prefetchBackends) {
+        if (backendManager->contains(identifier)) {
+            backendManager->backend(identifier)->cancelPrefetches();
+        }
+    }
+    prefetchBackends.clear();
+}
+
+void RealTimeStationSearchModelPrivate::regionChanged()
+{
+    Q_Q(RealTimeStationSearchModel);
+    if (query.isEmpty()) {
+        return;
+    }
+
+    QString currentQuery = query;
+    debounceTimer->stop();
+    cancelPrefetches();
+    resetSearch();
+    q->clear();
+    q->search(currentQuery);
+}
+
 void RealTimeStationSearchModelPrivate::connectBackend(AbstractBackendWrapper *backend)
 {
     connect(backend, &AbstractBackendWrapper::realTimeSuggestedStationsRegistered,
@@ -111,6 +559,7 @@ void RealTimeStationSearchModelPrivate::disconnectBackend(AbstractBackendWrapper
 void RealTimeStationSearchModelPrivate::slotStationsRegistered(const QString & request,
                                                                const QList<Station> &stations)
 {
+    Q_Q(RealTimeStationSearchModel);
     if (!requestRunning(request)) {
         return;
     }
@@ -120,26 +569,114 @@ void RealTimeStationSearchModelPrivate::slotStationsRegistered(const QString & r
         return;
     }
 
-    debug("realtime-station-search-model") << "Request" << request << "finished";
+    // Stale cached results are displayed, and replaced
+    // when the backend answers the same request
+    QString requestQuery;
+    if (backend->isRevalidating(request)) {
+        requestQuery = requestQueries.value(request);
+    } else {
+        debug("realtime-station-search-model") << "Request" << request << "finished";
+        removeRequest(request);
+        requestQuery = requestQueries.take(request);
+    }
 
-    removeRequest(request);
+    // Results of older requests, or of queries that are not
+    // compatible with the current query anymore, are dropped
+    if (latestRequests.value(backend->identifier()) != request
+        || !normalizedQuery.contains(requestQuery)) {
+        return;
+    }
+    displayedQueries.insert(backend->identifier(), requestQuery);
 
     bool support = backend->capabilities().contains(CAPABILITY_REAL_TIME_RIDES_FROM_STATION);
 
-    ModelDataList addedData;
-    foreach (Station station, stations) {
-        ModelData data;
-        data.insert(Qt::UserRole + STATION_INDEX, QVariant::fromValue(station));
-        data.insert(Qt::UserRole + BACKEND_IDENTIFIER_INDEX, backend->identifier());
-        data.insert(RealTimeStationSearchModel::NameRole, station.name());
-        // TODO ProviderNameRole
-        data.insert(RealTimeStationSearchModel::SupportRidesFromStationRole, support);
-        addedData.append(data);
+    ModelRowList addedRows;
+    addedRows.reserve(stations.count());
+    foreach (const Station &station, stations) {
+        StationRow *row = new StationRow;
+        row->station = station;
+        row->normalizedName = normalizeForSearch(station.name());
+        row->backendIdentifier = backend->identifier();
+        row->supportRidesFromStation = support;
+        addedRows.append(ModelRowPointer(row));
+    }
+
+    // The query changed while the request was running
+    if (requestQuery != normalizedQuery) {
+        addedRows = filterRows(addedRows, normalizedQuery);
+    } else {
+        qStableSort(addedRows.begin(), addedRows.end(), StationRowLessThan(normalizedQuery));
+    }
+    backendRows.insert(backend->identifier(), addedRows);
+
+    debug("station-search-model") << "Inserting" << addedRows.count() << "elements";
+    setRows(mergeRows());
+
+    // Suggestions are considered stable when all backends answered,
+    // and did not change for a short time
+    if (prefetchCount > 0 && !q->isLoading()) {
+        prefetchTimer->start();
+    }
+}
+
+void RealTimeStationSearchModelPrivate::slotPrefetch()
+{
+    if (!backendManager) {
+        return;
+    }
+
+    int count = qMin(prefetchCount, rows().count());
+    for (int i = 0; i < count; ++i) {
+        const StationRow *row = static_cast<const StationRow *>(this->row(i).data());
+        if (!row->supportRidesFromStation || !backendManager->contains(row->backendIdentifier)) {
+            continue;
+        }
+
+        // Prefetching should not launch a backend
+        AbstractBackendWrapper *backend = backendManager->backend(row->backendIdentifier);
+        if (backend->status() != AbstractBackendWrapper::Launched) {
+            continue;
+        }
+
+        backend->prefetchRealTimeRidesFromStation(row->station);
+        prefetchBackends.insert(row->backendIdentifier);
     }
-    debug("station-search-model") << "Inserting" << addedData.count() << "elements";
-    addData(addedData);
 }
 
+void RealTimeStationSearchModelPrivate::slotSendRequests()
+{
+    if (!backendManager || query.isEmpty()) {
+        return;
+    }
+
+    // Only the backends covering the region of the model are queried
+    foreach (AbstractBackendWrapper *backend, availableBackends()) {
+        QStringList capabilities = backend->capabilities();
+        if (!capabilities.contains(CAPABILITY_REAL_TIME_SUGGEST_STATION_FROM_STRING)) {
+            continue;
+        }
+
+        // Results of complete backends only need to be filtered
+        // if the query is refining a previous query
+        QString identifier = backend->identifier();
+        if (capabilities.contains(CAPABILITY_REAL_TIME_SUGGEST_STATION_COMPLETE)) {
+            QString latestRequest = latestRequests.value(identifier);
+            if (displayedQueries.contains(identifier)
+                && normalizedQuery.contains(displayedQueries.value(identifier))) {
+                continue;
+            }
+            if (requestRunning(latestRequest)
+                && normalizedQuery.contains(requestQueries.value(latestRequest))) {
+                continue;
+            }
+        }
+
+        QString request = backend->requestRealTimeSuggestedStations(query);
+        requestQueries.insert(request, normalizedQuery);
+        latestRequests.insert(identifier, request);
+        addRequest(request);
+    }
+}
 
 ////// End of private class //////
 
@@ -154,6 +691,36 @@ bool RealTimeStationSearchModel::isShort() const
     return d->m_short;
 }
 
+int RealTimeStationSearchModel::debounceInterval() const
+{
+    Q_D(const RealTimeStationSearchModel);
+    return d->debounceTimer->interval();
+}
+
+void RealTimeStationSearchModel::setDebounceInterval(int debounceInterval)
+{
+    Q_D(RealTimeStationSearchModel);
+    if (d->debounceTimer->interval() != debounceInterval) {
+        d->debounceTimer->setInterval(debounceInterval);
+        emit debounceIntervalChanged();
+    }
+}
+
+int RealTimeStationSearchModel::prefetchCount() const
+{
+    Q_D(const RealTimeStationSearchModel);
+    return d->prefetchCount;
+}
+
+void RealTimeStationSearchModel::setPrefetchCount(int prefetchCount)
+{
+    Q_D(RealTimeStationSearchModel);
+    if (d->prefetchCount != prefetchCount) {
+        d->prefetchCount = prefetchCount;
+        emit prefetchCountChanged();
+    }
+}
+
 QHash<int, QByteArray> RealTimeStationSearchModel::roleNames() const
 {
     QHash <int, QByteArray> roles;
@@ -167,21 +734,69 @@ void RealTimeStationSearchModel::search(const QString &partialStation)
 {
     Q_D(RealTimeStationSearchModel);
 
-    clear();
-
     d->setShort(false);
     QString partialStationTrimmed = partialStation.trimmed();
     if (partialStationTrimmed.count() < 3) {
+        d->debounceTimer->stop();
+        d->cancelPrefetches();
+        d->resetSearch();
+        clear();
         d->setShort(true);
+
+        // Short queries are only completed from the history
+        d->updateHistoryRows(normalizeForSearch(partialStationTrimmed));
+        d->setRows(d->mergeRows());
         return;
     }
 
-    foreach (AbstractBackendWrapper *backend, d->backendManager->backends()) {
-        if (backend->capabilities().contains(CAPABILITY_REAL_TIME_SUGGEST_STATION_FROM_STRING)) {
-            QString request = backend->requestRealTimeSuggestedStations(partialStationTrimmed);
-            d->addRequest(request);
+    QString normalizedQuery = normalizeForSearch(partialStationTrimmed);
+    if (normalizedQuery == d->normalizedQuery) {
+        return;
+    }
+
+    d->cancelPrefetches();
+
+    bool refining = !d->normalizedQuery.isEmpty() && normalizedQuery.contains(d->normalizedQuery);
+    if (!refining) {
+        d->resetSearch();
+        clear();
+    }
+
+    d->query = partialStationTrimmed;
+    d->normalizedQuery = normalizedQuery;
+
+    // Stations from the history are displayed immediately,
+    // and displayed results are refined, while backends are queried
+    d->updateHistoryRows(normalizedQuery);
+    if (refining) {
+        QMap<QString, ModelRowList>::iterator i;
+        for (i = d->backendRows.begin(); i != d->backendRows.end(); ++i) {
+            i.value() = d->filterRows(i.value(), normalizedQuery);
         }
     }
+    d->setRows(d->mergeRows());
+
+    d->debounceTimer->start();
+}
+
+Station RealTimeStationSearchModel::station(int index) const
+{
+    Q_D(const RealTimeStationSearchModel);
+    if (index < 0 || index >= rowCount()) {
+        return Station();
+    }
+
+    return static_cast<const StationRow *>(d->row(index).data())->station;
+}
+
+QString RealTimeStationSearchModel::backendIdentifier(int index) const
+{
+    Q_D(const RealTimeStationSearchModel);
+    if (index < 0 || index >= rowCount()) {
+        return QString();
+    }
+
+    return static_cast<const StationRow *>(d->row(index).data())->backendIdentifier;
 }
 
 void RealTimeStationSearchModel::requestRidesFromStation(int index)
@@ -192,8 +807,8 @@ void RealTimeStationSearchModel::requestRidesFromStation(int index)
         return;
     }
 
-    const ModelData &data = d->data(index);
-    if (!data.value(SupportRidesFromStationRole).toBool()) {
+    const StationRow *row = static_cast<const StationRow *>(d->row(index).data());
+    if (!row->supportRidesFromStation) {
         return;
     }
 
@@ -201,20 +816,29 @@ void RealTimeStationSearchModel::requestRidesFromStation(int index)
         return;
     }
 
-    QString backendIdentifier = data.value(Qt::UserRole + BACKEND_IDENTIFIER_INDEX).toString();
+    QString backendIdentifier = row->backendIdentifier;
 
     if (!d->backendManager->contains(backendIdentifier)) {
         return;
     }
 
     AbstractBackendWrapper *backend = d->backendManager->backend(backendIdentifier);
-    Station station = data.value(Qt::UserRole + STATION_INDEX).value<Station>();
+    Station station = row->station;
     debug("realtime-station-search-model") << "Requesting real time rides for" << station.name();
+    d->history.record(backendIdentifier, station);
 
-    QString request = backend->requestRealTimeRidesFromStation(station);
+    QString request = backend->requestPrefetchedRealTimeRidesFromStation(station);
     emit ridesFromStationRequested(backend, request, station);
 }
 
+void RealTimeStationSearchModel::clearHistory()
+{
+    Q_D(RealTimeStationSearchModel);
+    d->history.clear();
+    d->historyRows.clear();
+    d->setRows(d->mergeRows());
+}
+
 }
 
 #include "realtimestationsearchmodel.moc"
@@ -52,11 +52,30 @@ class RealTimeStationSearchModelPrivate;
  * a list of stations that were searched. It also provides
  * a method to interact with the station, and query the
  * journeys from the station.
+ *
+ * Searches are only sent to the backends that cover the
+ * country() and city() of the model, and are sent again
+ * when the region changes.
+ *
+ * The stations passed to requestRidesFromStation() are stored
+ * in a PT2::StationHistory. Stations from the history that match
+ * the search are displayed first, immediately, even for searches
+ * that are too short to be sent to the backends.
  */
 class RealTimeStationSearchModel : public AbstractMultiBackendModel
 {
     Q_OBJECT
     Q_PROPERTY(bool short READ isShort NOTIFY shortChanged)
+    /**
+     * @short Debounce interval
+     */
+    Q_PROPERTY(int debounceInterval READ debounceInterval WRITE setDebounceInterval
+               NOTIFY debounceIntervalChanged)
+    /**
+     * @short Prefetch count
+     */
+    Q_PROPERTY(int prefetchCount READ prefetchCount WRITE setPrefetchCount
+               NOTIFY prefetchCountChanged)
 public:
     /**
      * @short Model roles
@@ -81,14 +100,68 @@ public:
      */
     explicit RealTimeStationSearchModel(QObject *parent = 0);
     bool isShort() const;
+    /**
+     * @brief Debounce interval
+     *
+     * Requests to backends are only sent when search() was not
+     * called for this interval, so that typing a station name
+     * do not send a request for every character. Results that
+     * are already in the model are still refined immediately.
+     *
+     * @return debounce interval, in milliseconds.
+     */
+    int debounceInterval() const;
+    /**
+     * @brief Set the debounce interval
+     * @param debounceInterval debounce interval, in milliseconds.
+     */
+    void setDebounceInterval(int debounceInterval);
+    /**
+     * @brief Prefetch count
+     *
+     * When the suggested stations did not change for a short
+     * time, the rides from the first stations are prefetched,
+     * so that requestRidesFromStation() can be answered
+     * immediately. Prefetches are cancelled when the search
+     * changes. By default, no station is prefetched.
+     *
+     * @return number of stations to prefetch.
+     */
+    int prefetchCount() const;
+    /**
+     * @brief Set the prefetch count
+     * @param prefetchCount number of stations to prefetch.
+     */
+    void setPrefetchCount(int prefetchCount);
     /**
      * @short Role names
      * @return role names.
      */
     QHash<int, QByteArray> roleNames() const;
+    /**
+     * @brief Station
+     * @param index index of the station.
+     * @return station at the given index, or a null station.
+     */
+    Station station(int index) const;
+    /**
+     * @brief Backend identifier
+     * @param index index of the station.
+     * @return identifier of the backend that provided the station at the given index.
+     */
+    QString backendIdentifier(int index) const;
 public Q_SLOTS:
     /**
      * @brief Search
+     *
+     * If the new partial station name contains the previous one,
+     * the stations that are already in the model are filtered
+     * immediately. Backends that declare
+     * CAPABILITY_REAL_TIME_SUGGEST_STATION_COMPLETE are not
+     * queried again in this case, since the filtered stations are
+     * already complete. Other backends are queried after the
+     * debounce interval.
+     *
      * @param partialStation partial station name.
      */
     void search(const QString &partialStation);
@@ -97,8 +170,20 @@ public Q_SLOTS:
      * @param index index of the station.
      */
     void requestRidesFromStation(int index);
+    /**
+     * @brief Clear the history of the selected stations
+     */
+    void clearHistory();
 Q_SIGNALS:
     void shortChanged();
+    /**
+     * @brief Debounce interval changed
+     */
+    void debounceIntervalChanged();
+    /**
+     * @brief Prefetch count changed
+     */
+    void prefetchCountChanged();
     /**
      * @brief Rides from station requested
      * @param backend backend answering the request.
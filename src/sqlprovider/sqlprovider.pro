@@ -0,0 +1,32 @@
+include(../../common.pri)
+
+TEMPLATE = lib
+CONFIG += qt create_prl no_install_prl create_pc
+CONFIG(staticprovider): CONFIG += staticlib
+QT = core dbus sql
+
+DEFINES += PT2_SQLPROVIDER_LIBRARY
+
+INCLUDEPATH += ../lib
+LIBS += -L../lib -l$${NAME}
+
+TARGET = $${NAME}sqlprovider
+target.path = $${LIBDIR}
+
+HEADERS += sqlprovider_global.h \
+    sqlproviderpluginobject.h
+
+SOURCES += sqlproviderpluginobject.cpp
+
+QMAKE_PKGCONFIG_NAME = lib$$TARGET
+QMAKE_PKGCONFIG_DESCRIPTION = Public transportation 2 SQL provider development files
+QMAKE_PKGCONFIG_LIBDIR = $$target.path
+QMAKE_PKGCONFIG_INCDIR = $$headers.path
+QMAKE_PKGCONFIG_DESTDIR = pkgconfig
+QMAKE_PKGCONFIG_REQUIRES = $${NAME} Qt5Sql
+
+headers.files = $$PWD/*.h
+headers.path = $${INCLUDEDIR}/sqlprovider
+
+INSTALLS += target
+!CONFIG(optify): INSTALLS += headers
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+/**
+ * @file sqlproviderpluginobject.cpp
+ * @short Implementation of PT2::SqlProviderPluginObject
+ */
+
+#include "sqlproviderpluginobject.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtSql/QSqlError>
+
+#include "debug.h"
+
+namespace PT2
+{
+
+/**
+ * @internal
+ * @brief Template for the name of a connection
+ *
+ * The name contains the address of the object and of the thread.
+ */
+static const char *CONNECTION_NAME_TEMPLATE = "pt2-sql-provider-%1-%2";
+/**
+ * @internal
+ * @brief Pragmas applied to each connection
+ *
+ * The database is memory-mapped (up to 64 MiB), 8 MiB of page cache
+ * are used, temporary tables are kept in memory, and the connection
+ * refuses any write.
+ */
+static const char *CONNECTION_PRAGMAS[] = {
+    "PRAGMA mmap_size = 67108864",
+    "PRAGMA cache_size = -8192",
+    "PRAGMA temp_store = MEMORY",
+    "PRAGMA query_only = 1",
+    0
+};
+
+SqlStatementStatistics::SqlStatementStatistics()
+    : count(0), totalTime(0), maximumTime(0)
+{
+}
+
+/**
+ * @internal
+ * @brief A connection to the database, and its prepared statements
+ */
+struct SqlConnection
+{
+    /**
+     * @internal
+     * @brief Name of the connection
+     */
+    QString name;
+    /**
+     * @internal
+     * @brief Prepared statements, keyed by SQL text
+     */
+    QHash<QString, QSqlQuery> statements;
+};
+
+/**
+ * @internal
+ * @brief Private class for PT2::SqlProviderPluginObject
+ */
+struct SqlProviderPluginObjectPrivate
+{
+    /**
+     * @internal
+     * @brief Default constructor
+     * @param q Q-pointer.
+     */
+    explicit SqlProviderPluginObjectPrivate(SqlProviderPluginObject *q);
+    /**
+     * @internal
+     * @brief Connection for the current thread
+     *
+     * The connection is created if needed.
+     *
+     * @return connection for the current thread.
+     */
+    SqlConnection *connection() const;
+    /**
+     * @internal
+     * @brief Close the connection of a thread
+     * @param thread thread.
+     */
+    void closeConnection(QThread *thread);
+    /**
+     * @internal
+     * @brief Close all connections
+     */
+    void closeConnections();
+    /**
+     * @internal
+     * @brief Path to the database
+     */
+    QString databaseName;
+    /**
+     * @internal
+     * @brief Connections, for each thread
+     */
+    mutable QHash<QThread *, SqlConnection *> connections;
+    /**
+     * @internal
+     * @brief Mutex for the connections
+     */
+    mutable QMutex connectionsMutex;
+    /**
+     * @internal
+     * @brief Statistics, for each statement
+     */
+    mutable QMap<QString, SqlStatementStatistics> statistics;
+    /**
+     * @internal
+     * @brief Mutex for the statistics
+     */
+    mutable QMutex statisticsMutex;
+protected:
+    /**
+     * @internal
+     * @brief Q-pointer
+     */
+    SqlProviderPluginObject * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(SqlProviderPluginObject)
+};
+
+SqlProviderPluginObjectPrivate::SqlProviderPluginObjectPrivate(SqlProviderPluginObject *q)
+    : q_ptr(q)
+{
+}
+
+SqlConnection * SqlProviderPluginObjectPrivate::connection() const
+{
+    QThread *thread = QThread::currentThread();
+    QMutexLocker locker (&connectionsMutex);
+    if (connections.contains(thread)) {
+        return connections.value(thread);
+    }
+
+    SqlConnection *connection = new SqlConnection;
+    connection->name = QString(CONNECTION_NAME_TEMPLATE).arg(quintptr(q_ptr), 0, 16)
+                                                         .arg(quintptr(thread), 0, 16);
+    connections.insert(thread, connection);
+    locker.unlock();
+
+    // The connection is removed from the thread that used it, before
+    // the address of the thread can be reused by another thread
+    QObject::connect(thread, &QThread::finished,
+                     q_ptr, &SqlProviderPluginObject::slotThreadFinished,
+                     static_cast<Qt::ConnectionType>(Qt::DirectConnection | Qt::UniqueConnection));
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection->name);
+    db.setDatabaseName(databaseName);
+    db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    if (!db.open()) {
+        warning("sql-provider") << "Failed to open" << databaseName << db.lastError().text();
+        return connection;
+    }
+
+    QSqlQuery pragma (db);
+    for (int i = 0; CONNECTION_PRAGMAS[i]; ++i) {
+        if (!pragma.exec(CONNECTION_PRAGMAS[i])) {
+            warning("sql-provider") << "Failed to execute" << CONNECTION_PRAGMAS[i]
+                                    << pragma.lastError().text();
+        }
+    }
+
+    debug("sql-provider") << "Opened connection" << connection->name << "to" << databaseName;
+    return connection;
+}
+
+void SqlProviderPluginObjectPrivate::closeConnection(QThread *thread)
+{
+    QMutexLocker locker (&connectionsMutex);
+    SqlConnection *connection = connections.take(thread);
+    if (!connection) {
+        return;
+    }
+
+    // Queries should be destroyed before removing the connection
+    QString name = connection->name;
+    delete connection;
+    QSqlDatabase::removeDatabase(name);
+    debug("sql-provider") << "Closed connection" << name;
+}
+
+void SqlProviderPluginObjectPrivate::closeConnections()
+{
+    QMutexLocker locker (&connectionsMutex);
+    foreach (SqlConnection *connection, connections) {
+        // Queries should be destroyed before removing the connection
+        QString name = connection->name;
+        delete connection;
+        QSqlDatabase::removeDatabase(name);
+    }
+    connections.clear();
+}
+
+////// End of private class //////
+
+SqlProviderPluginObject::SqlProviderPluginObject(QObject *parent):
+    ProviderPluginObject(parent), d_ptr(new SqlProviderPluginObjectPrivate(this))
+{
+}
+
+SqlProviderPluginObject::~SqlProviderPluginObject()
+{
+    Q_D(SqlProviderPluginObject);
+    foreach (const SqlStatementStatistics &statistics, statementStatistics()) {
+        debug("sql-provider") << statistics.count << "executions," << statistics.totalTime
+                              << "ns in total," << statistics.maximumTime << "ns at most:"
+                              << statistics.statement;
+    }
+    d->closeConnections();
+}
+
+QString SqlProviderPluginObject::databaseName() const
+{
+    Q_D(const SqlProviderPluginObject);
+    return d->databaseName;
+}
+
+QList<SqlStatementStatistics> SqlProviderPluginObject::statementStatistics() const
+{
+    Q_D(const SqlProviderPluginObject);
+    QMutexLocker locker (&d->statisticsMutex);
+    return d->statistics.values();
+}
+
+void SqlProviderPluginObject::setDatabaseName(const QString &databaseName)
+{
+    Q_D(SqlProviderPluginObject);
+    if (d->databaseName != databaseName) {
+        d->closeConnections();
+        d->databaseName = databaseName;
+    }
+}
+
+QSqlDatabase SqlProviderPluginObject::database() const
+{
+    Q_D(const SqlProviderPluginObject);
+    SqlConnection *connection = d->connection();
+    return QSqlDatabase::database(connection->name, false);
+}
+
+QSqlQuery SqlProviderPluginObject::prepare(const QString &statement) const
+{
+    Q_D(const SqlProviderPluginObject);
+    SqlConnection *connection = d->connection();
+    if (connection->statements.contains(statement)) {
+        QSqlQuery query = connection->statements.value(statement);
+        query.finish();
+        return query;
+    }
+
+    QSqlQuery query (QSqlDatabase::database(connection->name, false));
+    if (!query.prepare(statement)) {
+        warning("sql-provider") << "Failed to prepare" << statement << query.lastError().text();
+        return query;
+    }
+
+    connection->statements.insert(statement, query);
+    return query;
+}
+
+bool SqlProviderPluginObject::execute(QSqlQuery &query) const
+{
+    Q_D(const SqlProviderPluginObject);
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = query.exec();
+    qint64 elapsed = timer.nsecsElapsed();
+
+    if (!ok) {
+        warning("sql-provider") << "Error:" << query.lastError().text() << query.lastQuery();
+    }
+
+    QMutexLocker locker (&d->statisticsMutex);
+    SqlStatementStatistics &statistics
+            = d->statistics[query.lastQuery()];
+    statistics.statement = query.lastQuery();
+    ++statistics.count;
+    statistics.totalTime += elapsed;
+    statistics.maximumTime = qMax(statistics.maximumTime, elapsed);
+    return ok;
+}
+
+void SqlProviderPluginObject::slotThreadFinished()
+{
+    Q_D(SqlProviderPluginObject);
+    QThread *thread = qobject_cast<QThread *>(sender());
+    if (thread) {
+        d->closeConnection(thread);
+    }
+}
+
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef PT2_SQLPROVIDERPLUGINOBJECT_H
+#define PT2_SQLPROVIDERPLUGINOBJECT_H
+
+/**
+ * @file sqlproviderpluginobject.h
+ * @short Definition of PT2::SqlProviderPluginObject
+ */
+
+#include "sqlprovider_global.h"
+#include "provider/providerpluginobject.h"
+
+#include <QtCore/QList>
+#include <QtCore/QScopedPointer>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+
+namespace PT2
+{
+
+/**
+ * @brief Statistics about a SQL statement
+ *
+ * These statistics are collected by PT2::SqlProviderPluginObject
+ * for each executed statement.
+ */
+struct PT2_SQLPROVIDER_EXPORT SqlStatementStatistics
+{
+    /**
+     * @brief Default constructor
+     */
+    explicit SqlStatementStatistics();
+    /**
+     * @brief SQL statement
+     */
+    QString statement;
+    /**
+     * @brief Number of executions
+     */
+    int count;
+    /**
+     * @brief Total execution time, in nanoseconds
+     */
+    qint64 totalTime;
+    /**
+     * @brief Maximum execution time, in nanoseconds
+     */
+    qint64 maximumTime;
+};
+
+class SqlProviderPluginObjectPrivate;
+
+/**
+ * @brief Base for a provider plugin using a SQLite database
+ *
+ * This class is the recommended base for a provider plugin
+ * that reads its data from a SQLite database. It manages
+ * the connections to the database, and caches the prepared
+ * statements, so that providers only have to set the path
+ * of the database with setDatabaseName(), and then to call
+ * prepare() and execute().
+ *
+ * The database is opened in read-only mode, and one connection
+ * is created for each thread that uses it, so that statements
+ * can be executed from worker threads. The connection of a thread
+ * is removed when the thread finishes. Each connection is tuned
+ * for read-mostly workloads: the database file is memory-mapped,
+ * the page cache is increased, and the connection is marked as
+ * query only.
+ *
+ * Prepared statements are cached per connection and keyed by
+ * their SQL text, so that calling prepare() several times with
+ * the same statement only prepares it once.
+ *
+ * Every call to execute() is timed, and the statistics can be
+ * retrieved with statementStatistics(). They are also printed
+ * as debug output when the object is destroyed.
+ */
+class PT2_SQLPROVIDER_EXPORT SqlProviderPluginObject: public ProviderPluginObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Default constructor
+     * @param parent parent object.
+     */
+    explicit SqlProviderPluginObject(QObject *parent = 0);
+    /**
+     * @brief Destructor
+     */
+    virtual ~SqlProviderPluginObject();
+    /**
+     * @brief Path to the database
+     * @return path to the database.
+     */
+    QString databaseName() const;
+    /**
+     * @brief Statistics about executed statements
+     * @return statistics about executed statements.
+     */
+    QList<SqlStatementStatistics> statementStatistics() const;
+protected:
+    /**
+     * @brief Set the path to the database
+     *
+     * Changing the path closes every opened connection.
+     *
+     * @param databaseName path to the database.
+     */
+    void setDatabaseName(const QString &databaseName);
+    /**
+     * @brief Connection for the current thread
+     *
+     * The connection is created and opened on first use.
+     *
+     * @return connection for the current thread.
+     */
+    QSqlDatabase database() const;
+    /**
+     * @brief Prepared statement
+     *
+     * The statement is prepared on the connection for the current
+     * thread, and cached. Bound values of the returned query should
+     * be set before calling execute().
+     *
+     * @param statement SQL statement.
+     * @return prepared query.
+     */
+    QSqlQuery prepare(const QString &statement) const;
+    /**
+     * @brief Execute a prepared statement
+     *
+     * The execution is timed and added to the statistics.
+     *
+     * @param query query to execute.
+     * @return if the execution succeeded.
+     */
+    bool execute(QSqlQuery &query) const;
+    /**
+     * @brief D-pointer
+     */
+    QScopedPointer<SqlProviderPluginObjectPrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(SqlProviderPluginObject)
+private Q_SLOTS:
+    /**
+     * @brief Slot used to remove the connection of a finished thread
+     */
+    void slotThreadFinished();
+};
+
+}
+
+#endif // PT2_SQLPROVIDERPLUGINOBJECT_H
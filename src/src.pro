@@ -1,9 +1,11 @@
 TEMPLATE = subdirs
-SUBDIRS = lib qml bin plugins
+SUBDIRS = lib sqlprovider qml bin plugins
 !CONFIG(semistatic): {
 SUBDIRS += 3rdparty
 lib.depends = 3rdparty
 }
+sqlprovider.depends = lib
 qml.depends = lib
 bin.depends = lib
-plugins.depends = lib
+CONFIG(staticprovider): bin.depends += plugins
+plugins.depends = lib sqlprovider
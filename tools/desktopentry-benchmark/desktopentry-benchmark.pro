@@ -0,0 +1,16 @@
+include(../../common.pri)
+
+# Standalone benchmark of the desktop file parser,
+# that is not built with the rest of the project
+TEMPLATE = app
+TARGET = desktopentry-benchmark
+
+QT = core
+INCLUDEPATH += ../../src/3rdparty/mlitedesktop
+
+HEADERS += ../../src/3rdparty/mlitedesktop/mlite-global.h \
+    ../../src/3rdparty/mlitedesktop/mdesktopentry.h \
+    ../../src/3rdparty/mlitedesktop/mdesktopentry_p.h
+
+SOURCES += main.cpp \
+    ../../src/3rdparty/mlitedesktop/mdesktopentry.cpp
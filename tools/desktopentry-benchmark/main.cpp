@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2013 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+
+/**
+ * @file desktopentry-benchmark/main.cpp
+ * @short Benchmark of the desktop file parser
+ */
+
+#include <iostream>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+
+#include <MDesktopEntry>
+
+using namespace std;
+
+/**
+ * @brief Default number of times each file is parsed
+ */
+static const int DEFAULT_ITERATIONS = 1000;
+/**
+ * @brief Group of the keys read by PT2::BackendInfo
+ */
+static const char *DESKTOP_FILE_GROUP = "Desktop Entry";
+/**
+ * @brief Key of the capabilities, read by PT2::BackendInfo
+ */
+static const char *DESKTOP_FILE_BACKENDINFO_CAPABILITIES
+    = "X-PublicTransportation-BackendInfo-Capabilities";
+
+/**
+ * @brief Display help
+ */
+void displayHelp()
+{
+    cout << "Benchmark of the desktop file parser" << endl;
+    cout << endl;
+    cout << "Usage: desktopentry-benchmark [--iterations <count>] <file.desktop> ..." << endl;
+    cout << "    --iterations <count>   parse each file <count> times (default "
+         << DEFAULT_ITERATIONS << ")." << endl;
+}
+
+/**
+ * @brief Parse a desktop file
+ *
+ * The values read by PT2::BackendInfo are also read, so
+ * that lazily decoded values are included in the time.
+ *
+ * @param file desktop file.
+ * @return if the file is valid.
+ */
+bool parse(const QString &file)
+{
+    MDesktopEntry parser (file);
+    parser.name();
+    parser.comment();
+    parser.icon();
+    parser.exec();
+    parser.value(DESKTOP_FILE_GROUP, DESKTOP_FILE_BACKENDINFO_CAPABILITIES);
+    return parser.isValid();
+}
+
+/**
+ * @brief Main
+ *
+ * Entry point of the benchmark.
+ *
+ * @param argc argc.
+ * @param argv argv.
+ * @return exit code.
+ */
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList files = app.arguments().mid(1);
+    int iterations = DEFAULT_ITERATIONS;
+    if (files.count() >= 2 && files.first() == "--iterations") {
+        iterations = files.at(1).toInt();
+        files = files.mid(2);
+    }
+
+    if (files.isEmpty() || iterations <= 0) {
+        displayHelp();
+        return 1;
+    }
+
+    qint64 totalTime = 0;
+    foreach (const QString &file, files) {
+        QElapsedTimer timer;
+        timer.start();
+        bool valid = true;
+        for (int i = 0; i < iterations; ++i) {
+            valid = parse(file);
+        }
+        qint64 time = timer.nsecsElapsed();
+        totalTime += time;
+
+        cout << file.toLocal8Bit().constData() << ": " << time / iterations / 1000.
+             << " us per parse" << (valid ? "" : " (invalid)") << endl;
+    }
+
+    cout << "Average: " << totalTime / files.count() / iterations / 1000.
+         << " us per parse" << endl;
+    return 0;
+}
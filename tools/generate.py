@@ -139,6 +139,16 @@ def makeSignature(type, data, className, prefix, suffix, addReqest = True):
     signature += ")"
     return signature
 
+def makeTypeName(parameter):
+    typeName = ""
+    if "type" in parameter:
+        typeName = defaultTypes[parameter["type"]].strip()
+    if "object" in parameter:
+        typeName = objects[parameter["object"]]["name"]
+    if "list" in parameter and parameter["list"]:
+        typeName = "QList<" + typeName + ">"
+    return typeName
+
 def makeHeaderMethod(type, data, prefix, suffix, virtual = False, addReqest = True, doc = ""):
     header = "    /**\n"
     header += "     * @brief "
@@ -546,6 +556,7 @@ header += """#ifndef PT2_ABSTRACTBACKENDWRAPPER_H
 
 #include <QtCore/QObject>
 #include <QtCore/QStringList>
+#include <QtCore/QVariant>
 
 namespace PT2
 {
@@ -555,7 +566,8 @@ namespace PT2
 for object in objects:
     header += "class " + object + ";\n"
 
-header += """class AbstractBackendWrapperPrivate;
+header += """class ResultCache;
+class AbstractBackendWrapperPrivate;
 
 /**
  * @brief Base class for a backend wrapper
@@ -646,6 +658,25 @@ header += """ *
  * a method to perform this registration (that should use setBackendProperties())
  * and that should set the status to AbstractBackendWrapper::Launched.
  *
+ * @section prefetching Prefetching
+ *
+ * Rides from a station can be requested speculatively with
+ * prefetchRealTimeRidesFromStation(), before the user actually
+ * asks for them. Prefetched rides are kept for a short time, and
+ * requestPrefetchedRealTimeRidesFromStation() answers with them
+ * if they are available, or waits for the running prefetch. The
+ * prefetches that are not needed anymore can be dropped with
+ * cancelPrefetches().
+ *
+ * @section caching Caching results
+ *
+ * Results can be stored on disk by a PT2::ResultCache, that is set
+ * with setResultCache(). Requests are answered from the cache when
+ * the cached result is fresh. When it is stale, the cached result is
+ * registered immediately, and registered again for the same request
+ * when the backend answers. isRevalidating() tells if a registered
+ * result will be registered again.
+ *
  */
 class PT2_EXPORT AbstractBackendWrapper: public QObject
 {
@@ -745,7 +776,102 @@ header += """
 for method in data["methods"]:
     header += makeHeaderMethod("signal", method, "request", "", True, False)
 
-header += """public Q_SLOTS:
+header += """    /**
+     * @brief Prefetch rides from station for real time information
+     *
+     * The rides are requested to the backend, but are not relayed
+     * by realTimeRidesFromStationRegistered(). Instead, they are
+     * kept to answer a later call to
+     * requestPrefetchedRealTimeRidesFromStation(). Nothing is done
+     * if rides for this station are already prefetched.
+     *
+     * @param station station.
+     */
+    void prefetchRealTimeRidesFromStation(const PT2::Station &station);
+    /**
+     * @brief Request rides from station for real time information, using prefetched rides
+     *
+     * If the rides of the station were prefetched recently, they are
+     * registered for the returned request in the next event loop
+     * iteration. If they are still being prefetched, they are
+     * registered when the prefetch finishes. Otherwise, this method
+     * calls requestRealTimeRidesFromStation().
+     *
+     * @param station station.
+     * @return request identifier.
+     */
+    QString requestPrefetchedRealTimeRidesFromStation(const PT2::Station &station);
+    /**
+     * @brief Cancel prefetches
+     *
+     * The running prefetches that are not awaited by any request
+     * are dropped, and their replies will be ignored.
+     */
+    void cancelPrefetches();
+    /**
+     * @brief If the backend is launched on demand
+     *
+     * A backend is launched on demand when its capabilities
+     * were declared with setDeclaredCapabilities(). Such a backend
+     * is launched when a request is performed while it is stopped,
+     * and the request is sent once the backend is launched. It is
+     * stopped after being idle for idleTimeout() milliseconds.
+     *
+     * @return if the backend is launched on demand.
+     */
+    bool isLaunchedOnDemand() const;
+    /**
+     * @brief Set declared capabilities
+     *
+     * The declared capabilities, usually read from the backend
+     * description, are the capabilities of the backend until it
+     * is launched and registers its own capabilities. Declaring
+     * capabilities allows the backend to be launched on demand.
+     *
+     * @param capabilities declared capabilities.
+     */
+    void setDeclaredCapabilities(const QStringList &capabilities);
+    /**
+     * @brief Idle timeout
+     *
+     * A backend launched on demand that have no running request
+     * for this duration is stopped. A negative or null timeout
+     * disables stopping idle backends.
+     *
+     * @return idle timeout, in milliseconds.
+     */
+    int idleTimeout() const;
+    /**
+     * @brief Set idle timeout
+     * @param idleTimeout idle timeout, in milliseconds.
+     */
+    void setIdleTimeout(int idleTimeout);
+    /**
+     * @brief Result cache
+     * @return result cache, or 0 if results are not cached.
+     */
+    ResultCache * resultCache() const;
+    /**
+     * @brief Set result cache
+     *
+     * The backend wrapper takes ownership of the result cache.
+     *
+     * @param resultCache result cache.
+     */
+    void setResultCache(ResultCache *resultCache);
+    /**
+     * @brief If a request is being revalidated
+     *
+     * A request is revalidated when a stale cached result was
+     * registered for it, and the backend did not answer yet.
+     * The request is still running, and the result of the
+     * backend will be registered for the same request.
+     *
+     * @param request request identifier.
+     * @return if the request is being revalidated.
+     */
+    bool isRevalidating(const QString &request) const;
+public Q_SLOTS:
     /**
      * @brief Launch the backend
      *
@@ -870,13 +996,97 @@ header += """protected:
      * @return request identifier.
      */
     QString createRequest(RequestType requestType);
+    /**
+     * @brief Queue request
+     *
+     * This method should be called by implementations before
+     * sending a request. If the backend is launched on demand
+     * and is not launched, the request is queued, the backend
+     * is launched, and the request is sent later using
+     * sendQueuedRequest().
+     *
+     * @param request request identifier.
+     * @param arguments arguments of the request.
+     * @return if the request was queued.
+     */
+    bool queueRequest(const QString &request, const QVariantList &arguments);
+    /**
+     * @brief Answer from cache
+     *
+     * This method should be called by implementations before
+     * queueRequest(). If a fresh result is cached, it is registered
+     * in the next event loop iteration, and the request should not
+     * be sent. If a stale result is cached, it is also registered,
+     * but the request should still be sent to revalidate it.
+     *
+     * @param request request identifier.
+     * @param arguments arguments of the request.
+     * @return if the request was answered from the cache.
+     */
+    bool answerFromCache(const QString &request, const QVariantList &arguments);
+    /**
+     * @brief Send a queued request
+     *
+     * This method is called when the backend is launched, for each
+     * request that were queued with queueRequest().
+     *
+     * @param request request identifier.
+     * @param requestType request type.
+     * @param arguments arguments of the request.
+     */
+    virtual void sendQueuedRequest(const QString &request, RequestType requestType,
+                                   const QVariantList &arguments) = 0;
 
     /**
      * @brief D-pointer
      */
     QScopedPointer<AbstractBackendWrapperPrivate> d_ptr;
 private:
+    /**
+     * @brief Register prefetched rides
+     *
+     * The rides are kept, and registered for the requests that
+     * were waiting for this prefetch.
+     *
+     * @param request request identifier of the prefetch.
+     * @param rideList ride list.
+     */
+    void registerPrefetchedRides(const QString &request, const QList<PT2::CompanyNodeData> &rideList);
+    /**
+     * @brief Store the result of a request in the result cache
+     *
+     * Only the results of the requests that were sent to
+     * the backend are stored.
+     *
+     * @param request request identifier.
+     * @param result result.
+     */
+    void cacheResult(const QString &request, const QVariant &result);
+    /**
+     * @brief Process queued requests
+     *
+     * Queued requests are sent when the backend is launched,
+     * and fail if it cannot be launched.
+     */
+    void processQueuedRequests();
+    /**
+     * @brief Restart the idle timer
+     */
+    void restartIdleTimer();
     Q_DECLARE_PRIVATE(AbstractBackendWrapper)
+private Q_SLOTS:
+    /**
+     * @brief Slot used to register prefetched rides
+     */
+    void slotRegisterPrefetchHits();
+    /**
+     * @brief Slot used to register cached results
+     */
+    void slotRegisterCacheHits();
+    /**
+     * @brief Slot used to stop the backend when it is idle
+     */
+    void slotIdleTimeout();
 };
 
 }
@@ -897,21 +1107,39 @@ source += """/**
 #include "abstractbackendwrapper.h"
 #include "abstractbackendwrapper_p.h"
 
+#include <QtCore/QTimer>
 #include <QtCore/QUuid>
 
 #include "debug.h"
 #include "errorid.h"
 #include "base/company.h"
+#include "base/companynodedata.h"
 #include "base/line.h"
 #include "base/ride.h"
 #include "base/station.h"
+#include "manager/resultcache.h"
 
 namespace PT2
 {
 
+/**
+ * @internal
+ * @brief Time during which prefetched rides can be used, in milliseconds
+ */
+static const int PREFETCH_TIMEOUT = 30000;
+/**
+ * @internal
+ * @brief Default time after which an idle backend is stopped, in milliseconds
+ */
+static const int DEFAULT_IDLE_TIMEOUT = 300000;
+
 AbstractBackendWrapperPrivate::AbstractBackendWrapperPrivate()
 {
      status = AbstractBackendWrapper::Stopped;
+     launchOnDemand = false;
+     idleTimeout = DEFAULT_IDLE_TIMEOUT;
+     idleTimer = 0;
+     resultCache = 0;
 }
 
 ////// End of private class //////
@@ -935,6 +1163,8 @@ AbstractBackendWrapper::AbstractBackendWrapper(AbstractBackendWrapperPrivate &dd
 
 AbstractBackendWrapper::~AbstractBackendWrapper()
 {
+    Q_D(AbstractBackendWrapper);
+    delete d->resultCache;
 }
 
 QString AbstractBackendWrapper::identifier() const
@@ -967,6 +1197,60 @@ QString AbstractBackendWrapper::copyright() const
     return d->copyright;
 }
 
+bool AbstractBackendWrapper::isLaunchedOnDemand() const
+{
+    Q_D(const AbstractBackendWrapper);
+    return d->launchOnDemand;
+}
+
+void AbstractBackendWrapper::setDeclaredCapabilities(const QStringList &capabilities)
+{
+    Q_D(AbstractBackendWrapper);
+    d->launchOnDemand = !capabilities.isEmpty();
+    if (d->status != Launched && d->capabilities != capabilities) {
+        d->capabilities = capabilities;
+        emit capabilitiesChanged();
+
+        debug("abs-backend-wrapper") << "Declared capabilities" << capabilities;
+    }
+}
+
+int AbstractBackendWrapper::idleTimeout() const
+{
+    Q_D(const AbstractBackendWrapper);
+    return d->idleTimeout;
+}
+
+void AbstractBackendWrapper::setIdleTimeout(int idleTimeout)
+{
+    Q_D(AbstractBackendWrapper);
+    d->idleTimeout = idleTimeout;
+    if (d->idleTimer && idleTimeout <= 0) {
+        d->idleTimer->stop();
+    }
+}
+
+ResultCache * AbstractBackendWrapper::resultCache() const
+{
+    Q_D(const AbstractBackendWrapper);
+    return d->resultCache;
+}
+
+void AbstractBackendWrapper::setResultCache(ResultCache *resultCache)
+{
+    Q_D(AbstractBackendWrapper);
+    if (d->resultCache != resultCache) {
+        delete d->resultCache;
+        d->resultCache = resultCache;
+    }
+}
+
+bool AbstractBackendWrapper::isRevalidating(const QString &request) const
+{
+    Q_D(const AbstractBackendWrapper);
+    return d->revalidatingRequests.contains(request);
+}
+
 void AbstractBackendWrapper::waitForStopped()
 {
 }
@@ -980,11 +1264,78 @@ void AbstractBackendWrapper::registerError(const QString &request, const QString
         debug("abs-backend-wrapper") << errorId;
         debug("abs-backend-wrapper") << error;
 
+        // Requests waiting for a failed prefetch fail too
+        d->prefetchRequests.remove(request);
+        foreach (const QString &waitingRequest, d->waitingRequests.take(request)) {
+            registerError(waitingRequest, errorId, error);
+        }
+
+        d->cacheKeys.remove(request);
+        d->revalidatingRequests.remove(request);
         delete d->requests.take(request);
         emit errorRegistered(request, errorId, error);
     }
 }
 
+void AbstractBackendWrapper::prefetchRealTimeRidesFromStation(const PT2::Station &station)
+{
+    Q_D(AbstractBackendWrapper);
+    QString identifier = station.identifier();
+    if (d->prefetchRequests.values().contains(identifier)) {
+        return;
+    }
+
+    if (d->prefetchedRides.contains(identifier)
+        && !d->prefetchedRides.value(identifier).timer.hasExpired(PREFETCH_TIMEOUT)) {
+        return;
+    }
+
+    debug("abs-backend-wrapper") << "Prefetching rides from" << station.name();
+    QString request = requestRealTimeRidesFromStation(station);
+    d->prefetchRequests.insert(request, identifier);
+}
+
+QString AbstractBackendWrapper::requestPrefetchedRealTimeRidesFromStation(const PT2::Station &station)
+{
+    Q_D(AbstractBackendWrapper);
+    QString identifier = station.identifier();
+    if (d->prefetchedRides.contains(identifier)) {
+        if (!d->prefetchedRides.value(identifier).timer.hasExpired(PREFETCH_TIMEOUT)) {
+            debug("abs-backend-wrapper") << "Using prefetched rides from" << station.name();
+            QString request = createRequest(RealTime_RidesFromStationType);
+            d->prefetchHits.append(qMakePair(request, identifier));
+            QTimer::singleShot(0, this, SLOT(slotRegisterPrefetchHits()));
+            return request;
+        }
+        d->prefetchedRides.remove(identifier);
+    }
+
+    QString prefetchRequest = d->prefetchRequests.key(identifier);
+    if (!prefetchRequest.isEmpty()) {
+        debug("abs-backend-wrapper") << "Waiting for prefetched rides from" << station.name();
+        QString request = createRequest(RealTime_RidesFromStationType);
+        d->waitingRequests[prefetchRequest].append(request);
+        return request;
+    }
+
+    return requestRealTimeRidesFromStation(station);
+}
+
+void AbstractBackendWrapper::cancelPrefetches()
+{
+    Q_D(AbstractBackendWrapper);
+    foreach (const QString &request, d->prefetchRequests.keys()) {
+        if (d->waitingRequests.contains(request)) {
+            continue;
+        }
+
+        debug("abs-backend-wrapper") << "Cancelling prefetch" << request;
+        d->prefetchRequests.remove(request);
+        d->cacheKeys.remove(request);
+        delete d->requests.take(request);
+    }
+}
+
 """
 
 for method in data["methods"]:
@@ -997,6 +1348,8 @@ for method in data["methods"]:
     source += "            return;\n"
     source += "        }\n"
     source += "\n"
+    source += "        cacheResult(request, QVariant::fromValue("
+    source += method["method"]["params"][-1]["name"] + "));\n"
     
     if "source" in method:
         source += indent(method["source"], 2)
@@ -1031,6 +1384,11 @@ void AbstractBackendWrapper::setStatus(Status status)
         emit statusChanged();
 
         debug("abs-backend-wrapper") << "Status changed to" << d->status;
+
+        if (status == Launched) {
+            restartIdleTimer();
+        }
+        processQueuedRequests();
     }
 }
 
@@ -1060,6 +1418,158 @@ void AbstractBackendWrapper::setBackendProperties(const QStringList &capabilitie
     }
 }
 
+void AbstractBackendWrapper::registerPrefetchedRides(const QString &request,
+                                                     const QList<PT2::CompanyNodeData> &rideList)
+{
+    Q_D(AbstractBackendWrapper);
+    PrefetchedRides prefetchedRides;
+    prefetchedRides.rideList = rideList;
+    prefetchedRides.timer.start();
+    d->prefetchedRides.insert(d->prefetchRequests.take(request), prefetchedRides);
+
+    foreach (const QString &waitingRequest, d->waitingRequests.take(request)) {
+        registerRealTimeRidesFromStation(waitingRequest, rideList);
+    }
+}
+
+void AbstractBackendWrapper::slotRegisterPrefetchHits()
+{
+    Q_D(AbstractBackendWrapper);
+    while (!d->prefetchHits.isEmpty()) {
+        QPair<QString, QString> hit = d->prefetchHits.takeFirst();
+        registerRealTimeRidesFromStation(hit.first,
+                                         d->prefetchedRides.value(hit.second).rideList);
+    }
+}
+
+void AbstractBackendWrapper::cacheResult(const QString &request, const QVariant &result)
+{
+    Q_D(AbstractBackendWrapper);
+    d->revalidatingRequests.remove(request);
+    if (!d->resultCache || !d->cacheKeys.contains(request)) {
+        return;
+    }
+
+    RequestType requestType = d->requests.value(request)->type;
+    d->resultCache->insert(d->cacheKeys.take(request), requestType, result,
+                           ResultCache::defaultTimeToLive(requestType));
+}
+
+void AbstractBackendWrapper::slotRegisterCacheHits()
+{
+    Q_D(AbstractBackendWrapper);
+    while (!d->cacheHits.isEmpty()) {
+        CacheHit hit = d->cacheHits.takeFirst();
+        if (!d->requests.contains(hit.request)) {
+            continue;
+        }
+
+        RequestType requestType = d->requests.value(hit.request)->type;
+        if (!hit.stale) {
+            switch (requestType) {
+            case RealTime_SuggestStationFromStringType:
+                registerRealTimeSuggestedStations(hit.request, hit.result.value<QList<PT2::Station> >());
+                break;
+            case RealTime_RidesFromStationType:
+                registerRealTimeRidesFromStation(hit.request, hit.result.value<QList<PT2::CompanyNodeData> >());
+                break;
+            case RealTime_SuggestLineFromStringType:
+                registerRealTimeSuggestedLines(hit.request, hit.result.value<QList<PT2::Line> >());
+                break;
+            default:
+                break;
+            }
+            continue;
+        }
+
+        // Stale prefetched rides are not relayed, and
+        // stale results keep the request running
+        if (d->prefetchRequests.contains(hit.request)) {
+            continue;
+        }
+
+        d->revalidatingRequests.insert(hit.request);
+        switch (requestType) {
+        case RealTime_SuggestStationFromStringType:
+            emit realTimeSuggestedStationsRegistered(hit.request, hit.result.value<QList<PT2::Station> >());
+            break;
+        case RealTime_RidesFromStationType:
+            emit realTimeRidesFromStationRegistered(hit.request, hit.result.value<QList<PT2::CompanyNodeData> >());
+            break;
+        case RealTime_SuggestLineFromStringType:
+            emit realTimeSuggestedLinesRegistered(hit.request, hit.result.value<QList<PT2::Line> >());
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void AbstractBackendWrapper::processQueuedRequests()
+{
+    Q_D(AbstractBackendWrapper);
+    if (d->queuedRequests.isEmpty()) {
+        return;
+    }
+
+    switch (d->status) {
+    case Launched:
+        debug("abs-backend-wrapper") << "Sending" << d->queuedRequests.count()
+                                     << "queued requests";
+        while (!d->queuedRequests.isEmpty()) {
+            QPair<QString, QVariantList> queuedRequest = d->queuedRequests.takeFirst();
+            if (d->requests.contains(queuedRequest.first)) {
+                sendQueuedRequest(queuedRequest.first, d->requests.value(queuedRequest.first)->type,
+                                  queuedRequest.second);
+            }
+        }
+        break;
+    case Stopped:
+        // Requests were queued while the backend was stopping
+        QMetaObject::invokeMethod(this, "launch", Qt::QueuedConnection);
+        break;
+    case Invalid:
+        while (!d->queuedRequests.isEmpty()) {
+            registerError(d->queuedRequests.takeFirst().first, ERROR_BACKEND_NOT_LAUNCHED,
+                          d->lastError);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void AbstractBackendWrapper::restartIdleTimer()
+{
+    Q_D(AbstractBackendWrapper);
+    if (!d->launchOnDemand || d->idleTimeout <= 0) {
+        return;
+    }
+
+    if (!d->idleTimer) {
+        d->idleTimer = new QTimer(this);
+        d->idleTimer->setSingleShot(true);
+        connect(d->idleTimer, &QTimer::timeout, this, &AbstractBackendWrapper::slotIdleTimeout);
+    }
+    d->idleTimer->start(d->idleTimeout);
+}
+
+void AbstractBackendWrapper::slotIdleTimeout()
+{
+    Q_D(AbstractBackendWrapper);
+    if (d->status != Launched) {
+        return;
+    }
+
+    if (!d->requests.isEmpty()) {
+        restartIdleTimer();
+        return;
+    }
+
+    debug("abs-backend-wrapper") << "Stopping idle backend" << d->identifier;
+    stop();
+}
+
 QString AbstractBackendWrapper::createRequest(RequestType requestType)
 {
     Q_D(AbstractBackendWrapper);
@@ -1071,10 +1581,61 @@ QString AbstractBackendWrapper::createRequest(RequestType requestType)
     requestData->request = request;
     requestData->type = requestType;
     d->requests.insert(request, requestData);
+    restartIdleTimer();
 
     return request;
 }
 
+bool AbstractBackendWrapper::queueRequest(const QString &request, const QVariantList &arguments)
+{
+    Q_D(AbstractBackendWrapper);
+    if (!d->launchOnDemand || d->status == Launched) {
+        return false;
+    }
+
+    debug("abs-backend-wrapper") << "Queuing request" << request << "until"
+                                 << d->identifier << "is launched";
+    bool launchNeeded = d->queuedRequests.isEmpty()
+                        && (d->status == Stopped || d->status == Invalid);
+    d->queuedRequests.append(qMakePair(request, arguments));
+
+    // The backend is launched in the next event loop iteration,
+    // so that a failure is reported after the request is returned
+    if (launchNeeded) {
+        QMetaObject::invokeMethod(this, "launch", Qt::QueuedConnection);
+    }
+    return true;
+}
+
+bool AbstractBackendWrapper::answerFromCache(const QString &request, const QVariantList &arguments)
+{
+    Q_D(AbstractBackendWrapper);
+    if (!d->resultCache || !d->requests.contains(request)) {
+        return false;
+    }
+
+    QString key = ResultCache::key(d->requests.value(request)->type, arguments);
+    CacheHit hit;
+    hit.request = request;
+    ResultCache::Freshness freshness = d->resultCache->find(key, hit.result);
+    if (freshness == ResultCache::Missing) {
+        d->cacheKeys.insert(request, key);
+        return false;
+    }
+
+    debug("abs-backend-wrapper") << "Using cached result for" << key;
+    hit.stale = (freshness == ResultCache::Stale);
+    d->cacheHits.append(hit);
+    QTimer::singleShot(0, this, SLOT(slotRegisterCacheHits()));
+
+    // Stale results are sent again
+    if (hit.stale) {
+        d->cacheKeys.insert(request, key);
+        return false;
+    }
+    return true;
+}
+
 
 }
 """
@@ -1096,6 +1657,8 @@ source += """/**
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonObject>
 #include <QtCore/QList>
 #include <QtCore/QPluginLoader>
 #include <QtDBus/QDBusConnection>
@@ -1186,6 +1749,29 @@ ProviderPluginDBusWrapper::~ProviderPluginDBusWrapper()
 bool ProviderPluginDBusWrapper::load(const QString &plugin)
 {
     Q_D(ProviderPluginDBusWrapper);
+#ifdef PT2_STATIC_PROVIDER
+    // Plugins are linked in the provider, and are selected
+    // by name, so "libratp.so" selects the class "Ratp"
+    QString name = QFileInfo(plugin).completeBaseName();
+    if (name.startsWith("lib")) {
+        name = name.mid(3);
+    }
+
+    QObject *pluginObject = 0;
+    foreach (const QStaticPlugin &staticPlugin, QPluginLoader::staticPlugins()) {
+        QString className = staticPlugin.metaData().value("className").toString();
+        if (className.compare(name, Qt::CaseInsensitive) == 0) {
+            pluginObject = staticPlugin.instance();
+            break;
+        }
+    }
+
+    if (!pluginObject) {
+        warning("provider-wrapper") << "The plugin" << plugin.toLocal8Bit().constData()
+                                    << "is not linked in the provider";
+        return false;
+    }
+#else
     QDir dir (PLUGIN_FOLDER);
     if (!dir.exists(plugin)) {
         warning("provider-wrapper") << "The plugin" << plugin.toLocal8Bit().constData()
@@ -1202,6 +1788,7 @@ bool ProviderPluginDBusWrapper::load(const QString &plugin)
         warning("provider-wrapper") << pluginLoader.errorString();
         return false;
     }
+#endif
 
     d->provider = qobject_cast<ProviderPluginObject *>(pluginObject);
     if (!d->provider) {
@@ -1322,7 +1909,16 @@ Q_SIGNALS:
 for method in data["methods"]:
     doc = "This is a DBus proxy signal."
     header += makeHeaderMethod("signal", method, "", "requested", False, True, doc)
-header += """
+header += """protected:
+    /**
+     * @brief Reimplementation of sendQueuedRequest
+     *
+     * @param request request identifier.
+     * @param requestType request type.
+     * @param arguments arguments of the request.
+     */
+    void sendQueuedRequest(const QString &request, RequestType requestType,
+                           const QVariantList &arguments);
 private:
     Q_DECLARE_PRIVATE(DBusBackendWrapper)
 };
@@ -1502,7 +2098,10 @@ void DBusBackendWrapper::launch()
     d->dbusObjectPath = DBUS_BACKEND_PATH_PREFIX;
     d->dbusObjectPath.append(dbusIdentifier);
 
-    new Pt2Adaptor(this);
+    // The adaptor is kept when the backend is launched again
+    if (!findChild<Pt2Adaptor *>()) {
+        new Pt2Adaptor(this);
+    }
     if (!QDBusConnection::sessionBus().registerObject(d->dbusObjectPath, this)) {
         setLastError(QString("Failed to register object on path %1").arg(d->dbusObjectPath));
         setStatus(Invalid);
@@ -1609,12 +2208,36 @@ for method in data["methods"]:
     source += makeSignature("signal", method, "DBusBackendWrapper", "request", "", False)
     source += "{\n"
     source += "    QString request = createRequest(" + makeEnum(method) + ");\n"
+    source += "    QVariantList arguments;\n"
     argumentList = ["request"]
     for parameter in method["signal"]["params"]:
+        source += "    arguments.append(QVariant::fromValue(" + parameter["name"] + "));\n"
         argumentList.append(parameter["name"])
-    source += "    emit " + makeName(method) + "Requested(" + ", ".join(argumentList) + ");\n"
+    source += "    if (!answerFromCache(request, arguments) && !queueRequest(request, arguments)) {\n"
+    source += "        emit " + makeName(method) + "Requested(" + ", ".join(argumentList) + ");\n"
+    source += "    }\n"
     source += "    return request;\n"
     source += "}\n"
+
+source += """
+void DBusBackendWrapper::sendQueuedRequest(const QString &request, RequestType requestType,
+                                           const QVariantList &arguments)
+{
+    switch (requestType) {
+"""
+for method in data["methods"]:
+    source += "    case " + makeEnum(method) + ":\n"
+    argumentList = ["request"]
+    for i in range(len(method["signal"]["params"])):
+        argumentList.append("arguments.at(" + str(i) + ").value<" \
+                            + makeTypeName(method["signal"]["params"][i]) + ">()")
+    source += "        emit " + makeName(method) + "Requested(" + ", ".join(argumentList) + ");\n"
+    source += "        break;\n"
+source += """    default:
+        break;
+    }
+}
+"""
     
 source += """
 }
@@ -1648,6 +2271,15 @@ for method in data["methods"]:
     header += " */\n"
     header += "#define " + prefix + name + " \"capability:" + name.lower() + "\"\n"
 
+for capability in data["capabilities"]:
+    prefix = "CAPABILITY_"
+    name = "_".join(capability["class"].split(" ")).upper() + "_" + capability["name"]
+    header += "/**\n"
+    header += " * @short " + prefix + name +  "\n"
+    header += " *\n"
+    header += makeDoc(capability["doc"], 0)
+    header += " */\n"
+    header += "#define " + prefix + name + " \"capability:" + name.lower() + "\"\n"
 
 header += """
 #endif // CAPABILITIESCONSTANTS_H